@@ -20,7 +20,9 @@
 #include "Exceptions.h"
 #include "FileSystem.h"
 #include "yagl_version.h" // Generated in a pre-build step.
+#include <algorithm>
 #include <iostream>
+#include <thread>
 
 
 // Singleton implementation.
@@ -40,8 +42,13 @@ void CommandLineOptions::parse(int argc, char* argv[])
     bool     test    = false;
 
     uint16_t palette = 1;
+    std::string cache_dir;
     uint16_t format  = 2;
 
+    uint16_t compression     = m_compression;
+    uint16_t chunk_gap       = m_chunk_gap;
+    bool     max_compression = false;
+
     try
     {
         cxxopts::Options options(argv[0], "yagl: a tool for decoding and encoding GRF files");
@@ -61,6 +68,20 @@ void CommandLineOptions::parse(int argc, char* argv[])
             ("p,palette",   "Choose the initial palette for the GRF", cxxopts::value<uint16_t>(palette), "<idx>")
             ("w,width",     "Maximum width of sprite sheets", cxxopts::value<uint16_t>(m_width), "<num>")
             ("h,height",    "Maximum height of sprite sheets", cxxopts::value<uint16_t>(m_height), "<num>")
+            ("j,jobs",      "Number of threads used to process sprites (default: one per core)", cxxopts::value<uint16_t>(m_jobs), "<num>")
+            ("c,compression", "Sprite compression level from 0 (none, fastest) to 3 (smallest, slowest)", cxxopts::value<uint16_t>(compression), "<level>")
+            ("m,max_compression", "Same as --compression 3", cxxopts::value<bool>(max_compression))
+            ("chunk_gap",   "Join chunks in tile sprites which are separated by fewer transparent pixels than this", cxxopts::value<uint16_t>(chunk_gap), "<gap>")
+            ("auto_chunk_gap", "Try several chunk gaps for each tile sprite, and keep the smallest", cxxopts::value<bool>(m_auto_chunk_gap))
+            ("auto_chunking",  "Store each sprite chunked or not, whichever is smaller", cxxopts::value<bool>(m_auto_chunking))
+            ("crop",        "Trim transparent borders from sprites, except those marked no_crop", cxxopts::value<bool>(m_crop))
+            ("reduce_colours", "Drop empty masks, and store 32bpp sprites which only use palette colours as 8bpp", cxxopts::value<bool>(m_reduce_colours))
+            ("dedup_sprites",  "Place identical sprites only once in the sprite sheets", cxxopts::value<bool>(m_dedup_sprites))
+            ("alias_sprites",  "Write identical sprites once, and refer to them by the same sprite ID", cxxopts::value<bool>(m_alias_sprites))
+            ("sprite_cache",   "Keep compressed sprites in .yagl-cache so later encodes only compress changed sprites", cxxopts::value<bool>(m_sprite_cache))
+            ("conversion_cache", "Reuse the output of an earlier conversion with the same inputs and options", cxxopts::value<bool>(m_conversion_cache))
+            ("incremental",    "Encode only the records which have changed, and decode sprites to where they were before", cxxopts::value<bool>(m_incremental))
+            ("cache_dir",      "Directory for the caches (default: .yagl-cache next to the YAGL)", cxxopts::value<std::string>(cache_dir), "<dir>")
             ("v,version",   "Print version information")
             ("help",        "Print help")
 
@@ -125,11 +146,17 @@ void CommandLineOptions::parse(int argc, char* argv[])
         m_yagl_dir   = fs::path(m_grf_file).parent_path().append(m_yagl_dir).make_preferred().string();
         m_yagl_file  = fs::path(m_yagl_dir).append(grf_name).replace_extension("yagl").make_preferred().string();
         m_hex_file   = fs::path(m_yagl_file).replace_extension("hex").make_preferred().string();
+        m_gaps_file  = fs::path(m_yagl_file).replace_extension("gaps").make_preferred().string();
+        m_manifest_file = fs::path(m_yagl_file).replace_extension("manifest").make_preferred().string();
+        m_layout_file   = fs::path(m_yagl_file).replace_extension("layout").make_preferred().string();
+        m_cache_dir  = cache_dir.empty() ? fs::path(m_yagl_dir).append(".yagl-cache").make_preferred().string() : 
+                                           fs::path(cache_dir).make_preferred().string();
         m_image_base = fs::path(m_yagl_file).replace_extension().make_preferred().string();
 
         if (m_operation == Operation::Decode) 
         {
-            if (!fs::is_regular_file(m_grf_file)) 
+            // Non-regular files such as pipes are allowed: they are just read more slowly.
+            if (!fs::exists(m_grf_file) || fs::is_directory(m_grf_file)) 
             {
                 std::cout << "ERROR: File '" << m_grf_file << "' does not exist\n";
                 exit(1);
@@ -144,6 +171,25 @@ void CommandLineOptions::parse(int argc, char* argv[])
             }
         }
 
+        if (max_compression)
+        {
+            compression = 3;
+        }
+        if (compression > 3)
+        {
+            std::cout << "ERROR: Invalid compression level. Permitted values are 0, 1, 2 and 3.\n";
+            exit(1);
+        }
+        m_compression = uint8_t(compression);
+
+        if ((chunk_gap == 0) || (chunk_gap > 0xFF))
+        {
+            std::cout << "ERROR: Invalid chunk gap. Permitted values are 1 to 255.\n";
+            exit(1);
+        }
+        m_chunk_gap       = uint8_t(chunk_gap);
+        m_chunk_gap_given = (result.count("chunk_gap") > 0);
+
         switch (palette)
         {
             case 1: m_palette = PaletteType::Default;        break;
@@ -163,3 +209,20 @@ void CommandLineOptions::parse(int argc, char* argv[])
     }
 }
 
+
+uint32_t CommandLineOptions::jobs() const
+{
+    // The debug trace is only readable if the sprites are processed in order.
+    if (m_debug)
+    {
+        return 1;
+    }
+
+    if (m_jobs > 0)
+    {
+        return m_jobs;
+    }
+
+    // This may return zero if the number of cores is not known.
+    return std::max(1U, std::thread::hardware_concurrency());
+}
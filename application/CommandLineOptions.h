@@ -40,12 +40,28 @@ class CommandLineOptions
         const std::string& yagl_dir()   const { return m_yagl_dir; }
         const std::string& yagl_file()  const { return m_yagl_file; }
         const std::string& hex_file()   const { return m_hex_file; }
+        const std::string& gaps_file()  const { return m_gaps_file; }
+        const std::string& manifest_file() const { return m_manifest_file; }
+        const std::string& layout_file() const   { return m_layout_file; }
+        const std::string& cache_dir()  const { return m_cache_dir; }
         const std::string& image_base() const { return m_image_base; }
 
         uint32_t           width()      const { return m_width; }
         uint32_t           height()     const { return m_height; }
         PaletteType        palette()    const { return m_palette; }
         uint8_t            chunk_gap()  const { return m_chunk_gap; }
+        bool               chunk_gap_given() const { return m_chunk_gap_given; }
+        bool               auto_chunk_gap() const { return m_auto_chunk_gap; }
+        bool               auto_chunking() const  { return m_auto_chunking; }
+        bool               crop()       const { return m_crop; }
+        bool               reduce_colours() const { return m_reduce_colours; }
+        bool               dedup_sprites() const  { return m_dedup_sprites; }
+        bool               alias_sprites() const  { return m_alias_sprites; }
+        bool               sprite_cache() const   { return m_sprite_cache; }
+        bool               conversion_cache() const { return m_conversion_cache; }
+        bool               incremental() const    { return m_incremental; }
+        uint32_t           jobs()       const;
+        uint8_t            compression() const { return m_compression; }
 
         bool               debug()      const { return m_debug; }
         const std::string& test_args()  const { return m_test_args; }
@@ -64,11 +80,27 @@ class CommandLineOptions
         uint16_t    m_height    = 16'000;                 // Max height of spritesheets
         PaletteType m_palette   = PaletteType::Default; 
         uint8_t     m_chunk_gap = 3;                      // Join chunks in tiles gaps smaller than is. 
+        bool        m_chunk_gap_given = false;            // The gap was given on the command line.
+        bool        m_auto_chunk_gap = false;             // Choose the chunk gap for each sprite.
+        bool        m_auto_chunking  = false;             // Choose chunked or plain for each sprite.
+        bool        m_crop      = false;                  // Trim transparent borders from sprites.
+        bool        m_reduce_colours = false;             // Drop empty masks and demote palette-exact sprites.
+        bool        m_dedup_sprites  = false;             // Place identical sprites once in sprite sheets.
+        bool        m_alias_sprites  = false;             // Write identical sprites once in Container2 GRFs.
+        bool        m_sprite_cache   = false;             // Keep compressed sprites between encodes.
+        bool        m_conversion_cache = false;           // Reuse the outputs of identical conversions.
+        bool        m_incremental    = false;             // Only parse records which have changed, and keep sprite sheet layouts.
+        uint16_t    m_jobs      = 0;                      // Worker threads for sprites: 0 means one per core.
+        uint8_t     m_compression = 2;                    // Sprite compression level: 0 (none) to 3 (max).
 
         // Calculated from m_grf_file and m_yagl_dir.
         std::string m_yagl_dir  = "sprites";
         std::string m_yagl_file;
         std::string m_hex_file;
+        std::string m_gaps_file;
+        std::string m_manifest_file;
+        std::string m_layout_file;
+        std::string m_cache_dir;
         std::string m_image_base;
 
         // Used for debugging
@@ -16,16 +16,27 @@
 // You should have received a copy of the GNU General Public License
 // along with yagl. If not, see <https://www.gnu.org/licenses/>.
 ///////////////////////////////////////////////////////////////////////////////
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include "NewGRFData.h"
+#include "MappedFile.h"
 #include "Lexer.h"
 #include "CommandLineOptions.h"
 #include "yagl_version.h" // Generated in a pre-build step.
 #include "FileSystem.h"
+#include "ChunkEncoder.h"
+#include "RealSpriteRecord.h"
+#include "PixelPool.h"
+#include "SpriteCache.h"
+#include "ConversionCache.h"
+#include "RecordManifest.h"
+#include "SpriteSheetLayout.h"
 
 // Unit testing framework
 #define CATCH_CONFIG_RUNNER
+// The alternate signal stack in this version of Catch2 does not compile with recent glibc.
+#define CATCH_CONFIG_NO_POSIX_SIGNALS
 #include "catch.hpp"
 
 
@@ -61,6 +72,91 @@ static std::ofstream open_write_file(const std::string& file_name)
 }
 
 
+// Regular files are memory mapped and decoded in place. Anything else, such as a named
+// pipe, is read through a stream instead.
+static void read_grf_file(NewGRFData& grf_data, const std::string& file_name)
+{
+    if (MappedFile::can_map(file_name))
+    {
+        MappedFile file(file_name);
+        ByteReader reader{file.data(), file.size()};
+        grf_data.read(reader);
+    }
+    else
+    {
+        std::ifstream is = open_read_file(file_name);
+        grf_data.read(is);
+    }
+}
+
+
+static void back_up_grf_file()
+{
+    const CommandLineOptions& options = CommandLineOptions::options();
+
+    fs::path grf_file = options.grf_file();
+    if (fs::is_regular_file(grf_file))
+    {
+        fs::path bak_file = grf_file;
+        bak_file.replace_extension("grf.bak");
+
+        std::cout << "Creating back up GRF: " << grf_file.string() << " => " << bak_file.string() << std::endl;
+        fs::rename(grf_file, bak_file);
+    } 
+}
+
+
+// Everything which affects the outputs of a conversion, apart from the contents of the input
+// files. This is the key for the conversion cache.
+static std::string conversion_key(const char* operation)
+{
+    const CommandLineOptions& options = CommandLineOptions::options();
+    const fs::path            grf_dir = fs::absolute(options.grf_file()).parent_path();
+
+    std::ostringstream os;
+    os << operation << ' ' << str_yagl_version << '\n';
+    os << fs::path(options.grf_file()).filename().generic_string() << ' ';
+    os << fs::absolute(options.yagl_dir()).lexically_relative(grf_dir).generic_string() << '\n';
+    os << int(options.palette()) << ' ' << options.width() << ' ' << options.height() << ' ';
+    os << int(options.compression()) << ' ' << int(options.chunk_gap()) << options.chunk_gap_given() << ' ';
+    os << options.auto_chunk_gap() << options.auto_chunking() << options.crop() << options.reduce_colours();
+    os << options.dedup_sprites() << options.alias_sprites() << options.incremental();
+    return os.str();
+}
+
+
+// Returns true if the conversion cache has the outputs for this conversion. They are copied 
+// into place with ConversionCache::restore(). Pipes and other special files cannot be hashed 
+// or copied, so conversions which read or write them are not cached.
+static bool find_conversion(const char* operation, const std::string& input_file, const std::string& output_file)
+{
+    const CommandLineOptions& options = CommandLineOptions::options();
+    if (!options.conversion_cache() || !fs::is_regular_file(input_file) || 
+        (fs::exists(output_file) && !fs::is_regular_file(output_file)))
+    {
+        return false;
+    }
+
+    // The version is part of the key, so outputs from other builds would be used without it.
+    if (std::strlen(str_yagl_version) == 0)
+    {
+        std::cout << "Conversion cache: not used because this build of yagl has no version" << std::endl;
+        return false;
+    }
+
+    // Paths in the cache are relative to the GRF so that the cache can be used elsewhere.
+    ConversionCache& cache = ConversionCache::cache();
+    cache.set_directory(fs::path(options.cache_dir()).append("conversions").string(), 
+        fs::path(options.grf_file()).parent_path().string());
+    cache.add_input(input_file);
+
+    bool found = cache.lookup(conversion_key(operation));
+    std::cout << "Conversion cache: " << (found ? "hit" : "miss") << " (" << cache.hits() << " hits, ";
+    std::cout << cache.misses() << " misses in total)" << std::endl;
+    return found;
+}
+
+
 static void decode()
 {
     CommandLineOptions& options = CommandLineOptions::options();
@@ -75,17 +171,46 @@ static void decode()
         std::cout << "Output directory: " << options.yagl_dir() << "\n";
         std::cout << "Image base:       " << options.image_base() << "\n" << std::endl;
 
+        if (find_conversion("decode", options.grf_file(), options.yagl_file()))
+        {
+            ConversionCache::cache().restore();
+            return;
+        }
+
         // Read in the GRF file ...
         // The GRF file already checked for existence.
         std::cout << "Reading GRF..." << std::endl;
         NewGRFData grf_data;
-        std::ifstream is = open_read_file(options.grf_file());
-        grf_data.read(is);
+        read_grf_file(grf_data, options.grf_file());
+
+        if (options.dedup_sprites())
+        {
+            std::cout << "Found " << PixelPool::pool().shared_sprites() << " sprites identical to others, sharing ";
+            std::cout << PixelPool::pool().shared_bytes() << " bytes of pixels" << std::endl;
+        }
+
+        // The sprites are put back where they were in the sprite sheets of the last decode.
+        if (options.incremental())
+        {
+            SpriteSheetLayout::layout().load(options.layout_file());
+            ConversionCache::cache().add_input(options.layout_file());
+        }
 
         // Write out the YAGL file and associated sprite sheets ...
         std::cout << "Writing YAGL and other files..." << std::endl;
         std::ofstream os = open_write_file(options.yagl_file());
         grf_data.print(os, options.yagl_dir(), options.image_base());
+        os.close();
+
+        if (options.incremental())
+        {
+            std::cout << "Incremental decode kept " << SpriteSheetLayout::layout().kept_sheets() << " unchanged sprite sheets" << std::endl;
+            SpriteSheetLayout::layout().save(options.layout_file());
+            ConversionCache::cache().add_output(options.layout_file());
+        }
+
+        ConversionCache::cache().add_output(options.yagl_file());
+        ConversionCache::cache().save(conversion_key("decode"));
     }
     catch (const std::exception& e)
     {
@@ -105,6 +230,13 @@ static void encode()
         std::cout << "Source directory: " << options.yagl_dir() << "\n";
         std::cout << "Image base:       " << options.image_base() << "\n" << std::endl;
 
+        if (find_conversion("encode", options.yagl_file(), options.grf_file()))
+        {
+            back_up_grf_file();
+            ConversionCache::cache().restore();
+            return;
+        }
+
         // Read in the YAGL file ...
         // This file already checked for existence.
         // Will need to check for the sprite sheets as we go along.
@@ -114,24 +246,79 @@ static void encode()
 
         // Parse the YAGL script ...
         std::cout << "Parsing YAGL..." << std::endl;
+        if (options.incremental())
+        {
+            RecordManifest::manifest().load(options.manifest_file());
+        }
         NewGRFData grf_data;
         grf_data.parse(token_stream, options.yagl_dir(), options.image_base()); 
 
-        // Back up the GRF before overwriting it ...
-        fs::path grf_file = options.grf_file();
-        if (fs::is_regular_file(grf_file))
+        if (options.incremental())
         {
-            fs::path bak_file = grf_file;
-            bak_file.replace_extension("grf.bak");
+            std::cout << "Incremental encode reused " << RecordManifest::manifest().reused() << " unchanged records, and parsed ";
+            std::cout << RecordManifest::manifest().parsed() << " new or edited records" << std::endl;
+        }
 
-            std::cout << "Creating back up GRF: " << grf_file.string() << " => " << bak_file.string() << std::endl;
-            fs::rename(grf_file, bak_file);
-        } 
+        if (options.crop())
+        {
+            std::cout << "Cropping removed " << RealSpriteRecord::cropped_pixels() << " transparent pixels from ";
+            std::cout << RealSpriteRecord::cropped_sprites() << " sprites" << std::endl;
+        }
+
+        if (options.reduce_colours())
+        {
+            std::cout << "Colour reduction dropped " << RealSpriteRecord::dropped_masks() << " empty masks and stored ";
+            std::cout << RealSpriteRecord::demoted_sprites() << " 32bpp sprites as 8bpp" << std::endl;
+        }
+
+        // Back up the GRF before overwriting it ...
+        back_up_grf_file();
 
         // Write out the GRF file ...
         std::cout << "Writing GRF..." << std::endl;
         std::ofstream os = open_write_file(options.grf_file());
+        // A chunk gap given on the command line is used for every sprite.
+        if (options.chunk_gap_given() && !options.auto_chunk_gap())
+        {
+            if (fs::is_regular_file(options.gaps_file()))
+            {
+                std::cout << "Ignoring chunk gaps file because --chunk_gap was given: " << options.gaps_file() << std::endl;
+            }
+        }
+        else
+        {
+            ChunkGapTable::table().load(options.gaps_file());
+            ConversionCache::cache().add_input(options.gaps_file());
+        }
+        if (options.sprite_cache())
+        {
+            SpriteCache::cache().set_directory(fs::path(options.cache_dir()).append("sprites").string());
+        }
         grf_data.write(os);
+
+        if (options.sprite_cache())
+        {
+            std::cout << "Sprite cache: " << SpriteCache::cache().hits() << " hits, ";
+            std::cout << SpriteCache::cache().misses() << " misses" << std::endl;
+        }
+
+        // Save the chunk gaps so that later encodes can use them without searching.
+        if (options.auto_chunk_gap())
+        {
+            std::cout << "Writing chunk gaps: " << options.gaps_file() << std::endl;
+            ChunkGapTable::table().save(options.gaps_file());
+            ConversionCache::cache().add_output(options.gaps_file());
+        }
+
+        // The manifest is only updated once the GRF has been written successfully.
+        if (options.incremental())
+        {
+            RecordManifest::manifest().save(options.manifest_file());
+        }
+
+        os.close();
+        ConversionCache::cache().add_output(options.grf_file());
+        ConversionCache::cache().save(conversion_key("encode"));
     }
     catch (const std::exception& e)
     {
@@ -157,8 +344,7 @@ static void hex_dump()
         // The GRF file already checked for existence.
         std::cout << "Reading GRF..." << std::endl;
         NewGRFData grf_data;
-        std::ifstream is = open_read_file(options.grf_file());
-        grf_data.read(is);
+        read_grf_file(grf_data, options.grf_file());
 
         // Write out the HEX file...
         std::cout << "Writing HEX..." << std::endl;
@@ -18,6 +18,8 @@
 ///////////////////////////////////////////////////////////////////////////////
 #pragma once
 #include "TokenStream.h"
+#include "ByteReader.h"
+#include "ByteWriter.h"
 #include <map>
 #include <iostream>
 
@@ -34,8 +36,8 @@ public:
     // handled the property or not. We don't care about the result - an exception will be thrown
     // in cases where this was not so.
     // Binary serialisation
-    virtual bool read_property(std::istream& is, uint8_t property) = 0;
-    virtual bool write_property(std::ostream& os, uint8_t property) const = 0;
+    virtual bool read_property(ByteReader& is, uint8_t property) = 0;
+    virtual bool write_property(ByteWriter& os, uint8_t property) const = 0;
     // Text serialisation
     virtual bool print_property(std::ostream& os, uint8_t property, uint16_t indent) const { return false; }
     virtual bool parse_property(TokenStream& is, const std::string& name, uint8_t& index) = 0;
@@ -53,10 +53,15 @@
 #include "SpriteSheetGenerator.h"
 #include "CommandLineOptions.h"
 #include "Exceptions.h"
+#include "Parallel.h"
+#include "RecordManifest.h"
 #include "yagl_version.h" // Generated in a pre-build step.
 #include <sstream>
 #include <fstream>
+#include <iterator>
 #include <csignal>
+#include <algorithm>
+#include <exception>
 
 
 // Expected value for the first bytes in the GRF format 2 container. 
@@ -70,6 +75,15 @@ NewGRFData::NewGRFData()
 
 
 void NewGRFData::read(std::istream& is)
+{
+    // Load the whole stream into memory and then treat it exactly like a mapped file.
+    std::vector<uint8_t> buffer((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+    ByteReader reader{buffer.data(), buffer.size()};
+    read(reader);
+}
+
+
+void NewGRFData::read(ByteReader& is)
 {
     // The structure of a GRF file is pretty simple. It is just a list of 
     // variable length records in up to three sections: 
@@ -90,6 +104,13 @@ void NewGRFData::read(std::istream& is)
     // This is the type of the current container pseudo-sprite.
     RecordType container = RecordType::ACTION_01; 
 
+    // Container2 records are all length-prefixed, so most of the data section can be 
+    // decoded on several threads. Whatever is left, if anything, is read serially below.
+    if ((m_info.format == GRFFormat::Container2) && (CommandLineOptions::options().jobs() > 1))
+    {
+        read_records_in_parallel(is, record_index, num_sprites, container);
+    }
+
     // Read data records from the data section.
     while (true)
     {
@@ -109,12 +130,12 @@ void NewGRFData::read(std::istream& is)
 
         // This section is terminated with a zero length record. The size of the length of the record
         // depends on the file format version.
-        uint32_t size = (m_info.format == GRFFormat::Container1) ? read_uint16(is) : read_uint32(is);
+        uint32_t size = (m_info.format == GRFFormat::Container1) ? is.read_uint16() : is.read_uint32();
         if (size == 0)
             break;
 
         // The info byte determines what type of record we are dealing with. 
-        uint8_t info = read_uint8(is);
+        uint8_t info = is.read_uint8();
 
         std::unique_ptr<Record> record = nullptr;
         switch (info)
@@ -128,7 +149,7 @@ void NewGRFData::read(std::istream& is)
                 {
                     // Number of records in the file. We could use this to spot errors like reading past
                     // the end of the file, but there is no need to store.
-                    uint32_t number_of_records = read_uint32(is);
+                    uint32_t number_of_records = is.read_uint32();
                     std::cout << "Number of records: " << number_of_records << '\n';
                     // We didnt create a record, so skip the rest of the loop.
                     continue;
@@ -168,9 +189,12 @@ void NewGRFData::read(std::istream& is)
             // It appears that this can also be used for sound effects. RUKTS.grf does this. 
             // Need to take account of parent type...
             case 0xFD:
+            {
                 record = std::make_unique<SpriteIndexRecord>(container);
-                record->read(is, m_info);
+                ByteReader bis(is.read_bytes(size), size);
+                record->read(bis, m_info);
                 break;
+            }
 
             // This is a real-sprite (Format1 only), or a recolour-sprite. The size might be misleading so we 
             // have to decompress the image to find out. Pass record index as the (fake) sprite ID. The 
@@ -189,26 +213,7 @@ void NewGRFData::read(std::istream& is)
             record->print(std::cout, m_sprites, 0); // Indent = 0     
         }
 
-        // This is our slightly too trusting method for grouping sprites into containers. 
-        // The format for the file is simply a long list of records. Some of the records are effectively
-        // containers, such as Action01, and indicate how many sprites they contain, call it NUM. 
-        // The next NUM records in the file are the sprites which the container "holds". If the wrong
-        // number of sprites are in the file, it'll all go a bit wrong. 
-        if (num_sprites > 0)
-        {
-            // We need to append the record to the previous container.
-            m_records.back()->append_sprite(std::move(record));
-            --num_sprites; 
-        }   
-        else
-        {
-            // This is a top level record, maybe a container. If it's a container,
-            // num_sprites will be set to a non-zero value for the number of contained
-            // sprites.
-            num_sprites = record->num_sprites_to_read();
-            container   = record->record_type();
-            m_records.push_back(std::move(record));
-        }
+        add_record(std::move(record), num_sprites, container);
 
         // Important: this is used to give indices to real sprites for Container1 files. 
         ++record_index;
@@ -217,17 +222,21 @@ void NewGRFData::read(std::istream& is)
     // Read sprite records from the sprite section. Only applies to Format2 files.
     if (m_info.format == GRFFormat::Container2)
     {
+        // Most of the sprites are decoded up front on several threads. Whatever is 
+        // left, if anything, is read serially below.
+        read_sprites_in_parallel(is);
+
         //while (true)
-        while (is.peek() != EOF)
+        while (!is.at_end())
         {
             // This section is terminated with a zero length record. 
-            uint32_t sprite_id = read_uint32(is);
+            uint32_t sprite_id = is.read_uint32();
             if (sprite_id == 0)
                 break;
 
             // Read the size and compression to match what we did above. 
-            uint32_t size        = read_uint32(is);
-            uint8_t  compression = read_uint8(is);
+            uint32_t size        = is.read_uint32();
+            uint8_t  compression = is.read_uint8();
 
             // Error decoding RUKTS.grf caused a fault. It appears that sound
             // files are stored among the images in this section of the file. 
@@ -251,27 +260,27 @@ void NewGRFData::read(std::istream& is)
 }
 
 
-GRFFormat NewGRFData::read_format(std::istream& is)
+GRFFormat NewGRFData::read_format(ByteReader& is)
 {
     // If this is not a format 2 file, we will read past the end of file
     // and maybe get an exception. This is not an error: it just means we have 
     // an empty GRF file.
     try
     {
-        uint16_t leader = read_uint16(is);
+        uint16_t leader = is.read_uint16();
         if (leader == 0)
         {
             // We don't need to store this value as the string is constant.
             std::array<uint8_t, 8> identifier  = {};
             for (uint8_t i = 0; i < identifier.size(); ++i)
             {
-                identifier[i] = read_uint8(is);
+                identifier[i] = is.read_uint8();
             }
 
             // We don't really need to store these values on a read, as they are calculated or constant.
             // But the members will be useful when writing the file out.
-            read_uint32(is);
-            read_uint8(is);
+            is.read_uint32();
+            is.read_uint8();
 
             if (identifier == CONTAINER2_IDENTIFIER) 
             {
@@ -288,7 +297,7 @@ GRFFormat NewGRFData::read_format(std::istream& is)
     }
 
     // Restore the stream for reading Format1.
-    is.seekg(0, std::istream::beg);
+    is.seek(0);
     return GRFFormat::Container1;
 }
 
@@ -305,23 +314,309 @@ void NewGRFData::append_sprite(uint32_t sprite_id, std::unique_ptr<Record> sprit
 }
 
 
-void NewGRFData::read_sprite(std::istream& is, uint32_t sprite_id, uint32_t size, uint8_t compression, const GRFInfo& info)
+void NewGRFData::add_record(std::unique_ptr<Record> record, uint16_t& num_sprites, RecordType& container)
+{
+    // This is our slightly too trusting method for grouping sprites into containers. 
+    // The format for the file is simply a long list of records. Some of the records are effectively
+    // containers, such as Action01, and indicate how many sprites they contain, call it NUM. 
+    // The next NUM records in the file are the sprites which the container "holds". If the wrong
+    // number of sprites are in the file, it'll all go a bit wrong. 
+    if (num_sprites > 0)
+    {
+        // We need to append the record to the previous container.
+        m_records.back()->append_sprite(std::move(record));
+        --num_sprites; 
+    }   
+    else
+    {
+        // This is a top level record, maybe a container. If it's a container,
+        // num_sprites will be set to a non-zero value for the number of contained
+        // sprites.
+        num_sprites = record->num_sprites_to_read();
+        container   = record->record_type();
+        m_records.push_back(std::move(record));
+    }
+}
+
+
+void NewGRFData::read_records_in_parallel(ByteReader& is, uint32_t& record_index, uint16_t& num_sprites, RecordType& container)
+{
+    // The first pass finds the boundaries of the records and works out how they are grouped
+    // into containers, which is what the serial loop would do. Grouping depends on the number 
+    // of sprites in each container, so top level container records (Actions 01, 05, 0A, 11 and 
+    // 12) are decoded straight away. So is Action08, as it sets the GRF version which affects 
+    // how later records are read. Both are rare. Everything else is decoded afterwards on 
+    // several threads. The index stops at the terminator or at anything unexpected, such as 
+    // a record we fail to decode here, and the serial loop takes over from that point. 
+    struct RecordEntry
+    {
+        size_t                  offset;    // Position of the data following the info byte.
+        uint32_t                size;
+        uint8_t                 info;
+        bool                    top_level;
+        GRFInfo                 grf_info;  // Including the version in force at this record.
+        std::unique_ptr<Record> record;    // Only set for records decoded during the first pass.
+    };
+
+    std::vector<RecordEntry> entries;
+    uint32_t   index_record    = record_index;
+    uint16_t   index_sprites   = num_sprites;
+    RecordType index_container = container;
+    GRFInfo    index_info      = m_info;
+    size_t     stop            = is.position();
+    while (is.remaining() >= 5)
+    {
+        stop = is.position();
+        uint32_t size = is.read_uint32();
+        if ((size == 0) || (size >= is.remaining()))
+            break;
+
+        // The size does not include the info byte.
+        RecordEntry entry{is.position() + 1, size, is.read_uint8(), (index_sprites == 0), index_info};
+        if (entry.info == 0xFF)
+        {
+            // The record counter is not kept. See the serial loop.
+            if ((size == 4) && (index_record == 0))
+            {
+                uint32_t number_of_records = is.read_uint32();
+                std::cout << "Number of records: " << number_of_records << '\n';
+                stop = is.position();
+                continue;
+            }
+
+            uint8_t action = is.data()[0];
+            bool    is_container = entry.top_level && 
+                ((action == 0x01) || (action == 0x05) || (action == 0x0A) || (action == 0x11) || (action == 0x12));
+            if (is_container || (action == 0x08))
+            {
+                try
+                {
+                    ByteReader reader = is.slice(is.position(), size);
+                    entry.record = decode_record(reader, size, entry.top_level, index_info);
+                }
+                catch ([[maybe_unused]] const std::exception& e)
+                {
+                    break;
+                }
+
+                if (entry.record->record_type() == RecordType::ACTION_08)
+                {
+                    index_info.version = static_cast<const Action08Record*>(entry.record.get())->grf_version();
+                }
+            }
+        }
+        else if ((entry.info == 0xFD) && !entry.top_level)
+        {
+            // Sprite references belong to the preceding container, which we decoded above.
+            try
+            {
+                ByteReader reader = is.slice(is.position(), size);
+                entry.record = std::make_unique<SpriteIndexRecord>(index_container);
+                entry.record->read(reader, index_info);
+            }
+            catch ([[maybe_unused]] const std::exception& e)
+            {
+                break;
+            }
+        }
+        else
+        {
+            // A real sprite, whose size doesn't tell us how long it is. It shouldn't be 
+            // here in a Container2 file anyway. Or an orphaned sprite reference.
+            break;
+        }
+
+        // Keep track of the grouping as the serial loop would.
+        if (index_sprites > 0)
+        {
+            --index_sprites;
+        }
+        else
+        {
+            // Only containers have sprites, and we decoded all of those above. The type of 
+            // the container is only needed for sprite references, which must follow one. 
+            index_sprites   = entry.record ? entry.record->num_sprites_to_read() : 0;
+            index_container = entry.record ? entry.record->record_type() : index_container;
+        }
+        ++index_record;
+
+        is.skip(size);
+        entries.push_back(std::move(entry));
+        stop = is.position();
+    }
+
+    // Now decode the remaining records concurrently. As with the sprites, errors are held 
+    // back until the in order pass below.
+    std::vector<std::exception_ptr> errors(entries.size());
+    parallel_for(entries.size(), CommandLineOptions::options().jobs(), [&](size_t index)
+    {
+        RecordEntry& entry = entries[index];
+        if (entry.record)
+            return;
+
+        try
+        {
+            ByteReader reader = is.slice(entry.offset, entry.size);
+            entry.record = decode_record(reader, entry.size, entry.top_level, entry.grf_info);
+        }
+        catch (...)
+        {
+            errors[index] = std::current_exception();
+        }
+    });
+
+    // Add the records in file order, exactly as the serial loop would. 
+    for (size_t index = 0; index < entries.size(); ++index)
+    {
+        RecordEntry& entry = entries[index];
+        if (errors[index])
+        {
+            // The serial loop reports the error and skips the record without counting 
+            // it. That changes the grouping of the records which follow, so hand back to 
+            // the serial loop just after this record.
+            try
+            {
+                std::rethrow_exception(errors[index]);
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << e.what() << '\n';
+            }
+            is.seek(entry.offset + entry.size);
+            return;
+        }
+
+        update_version_info(*entry.record);
+        add_record(std::move(entry.record), num_sprites, container);
+        ++record_index;
+    }
+
+    is.seek(stop);
+}
+
+
+void NewGRFData::read_sprites_in_parallel(ByteReader& is)
+{
+    // Each record in the sprite section gives its size, so we can find all the sprites 
+    // in a quick first pass, without decoding them. The index stops at the terminator 
+    // or at anything which doesn't look right, and is left for the serial loop.
+    struct SpriteEntry
+    {
+        uint32_t sprite_id;
+        uint32_t size;
+        uint8_t  compression;
+        size_t   offset;   // Position of the data following the compression byte.
+    };
+
+    std::vector<SpriteEntry> entries;
+    size_t start = is.position();
+    while (is.remaining() >= 9)
+    {
+        SpriteEntry entry;
+        entry.sprite_id = is.read_uint32();
+        if (entry.sprite_id == 0)
+            break;
+
+        entry.size        = is.read_uint32();
+        entry.compression = is.read_uint8();
+        entry.offset      = is.position();
+        if ((entry.size == 0) || ((entry.size - 1) > is.remaining()))
+            break;
+
+        is.skip(entry.size - 1);
+        entries.push_back(entry);
+    }
+
+    // The real sprites are decoded concurrently. Sound effects are left for the in 
+    // order pass below: there are few of them and they are quick to read. Each sprite
+    // reads from its own offset to the end of the data, exactly as the serial loop 
+    // would, and we note how much it consumed. Errors are held back until the sprite's 
+    // turn comes in the in order pass, in case the serial loop would never reach it.
+    std::vector<std::unique_ptr<RealSpriteRecord>> sprites(entries.size());
+    std::vector<size_t>             consumed(entries.size());
+    std::vector<std::exception_ptr> errors(entries.size());
+    parallel_for(entries.size(), CommandLineOptions::options().jobs(), [&](size_t index)
+    {
+        const SpriteEntry& entry = entries[index];
+        if (entry.compression == 0xFF)
+            return;
+
+        try
+        {
+            ByteReader reader = is.slice(entry.offset, is.size() - entry.offset);
+            sprites[index] = std::make_unique<RealSpriteRecord>(entry.sprite_id, entry.size, entry.compression);
+            sprites[index]->read(reader, m_info);
+            consumed[index] = reader.position();
+        }
+        catch (...)
+        {
+            errors[index] = std::current_exception();
+        }
+    });
+
+    // Add the sprites to m_sprites in file order so that the result is the same as 
+    // a serial read.
+    for (size_t index = 0; index < entries.size(); ++index)
+    {
+        const SpriteEntry& entry = entries[index];
+        is.seek(entry.offset);
+        if (errors[index])
+        {
+            std::rethrow_exception(errors[index]);
+        }
+
+        if (entry.compression == 0xFF)
+        {
+            std::unique_ptr<Record> effect  = read_record(is, entry.size - 1, true, m_info);
+            std::unique_ptr<Record> wrapper = std::make_unique<SpriteWrapperRecord>(entry.sprite_id, std::move(effect));
+            append_sprite(entry.sprite_id, std::move(wrapper));
+        }
+        else
+        {
+            is.skip(consumed[index]);
+            append_sprite(entry.sprite_id, std::move(sprites[index]));
+
+            // If the sprite did not occupy the space its size claims, the rest of the 
+            // index is unreliable. Carry on serially from where the sprite ended.
+            if (consumed[index] != (entry.size - 1))
+                return;
+        }
+    }
+
+    // Leave the cursor at the point where the index stopped.
+    is.seek(entries.empty() ? start : (entries.back().offset + entries.back().size - 1));
+}
+
+
+void NewGRFData::read_sprite(ByteReader& is, uint32_t sprite_id, uint32_t size, uint8_t compression, const GRFInfo& info)
 {
+    // The size of a Container1 sprite does not tell us how many bytes it occupies in 
+    // the file, so the sprite reads from the remainder of the data and leaves the 
+    // cursor after however much it consumed.
     std::unique_ptr<RealSpriteRecord> sprite = std::make_unique<RealSpriteRecord>(sprite_id, size, compression);
     sprite->read(is, m_info);
     append_sprite(sprite_id, std::move(sprite));
 }
 
 
-std::unique_ptr<Record> NewGRFData::read_record(std::istream& is, uint32_t size, bool top_level, const GRFInfo& info)
+std::unique_ptr<Record> NewGRFData::read_record(ByteReader& is, uint32_t size, bool top_level, const GRFInfo& info)
+{
+    std::unique_ptr<Record> record = decode_record(is, size, top_level, info);
+    update_version_info(*record);
+    return record;
+}
+
+
+std::unique_ptr<Record> NewGRFData::decode_record(ByteReader& is, uint32_t size, bool top_level, const GRFInfo& info) const
 {   
     // Extract the type and data of this record. A little bit of interpretation is 
     // required to work out how to parse the data. Whether we parse the data or not,
     // it has now been taken out of the file stream.
-    uint8_t action = read_uint8(is);
-    std::string data;
-    data.resize(size - 1);
-    is.read(&data[0], size - 1);
+    // The record's data is not copied: it is decoded directly from a view into the 
+    // input buffer.
+    uint8_t        action = is.read_uint8();
+    uint32_t       length = size - 1;
+    const uint8_t* data   = is.read_bytes(length);
 
     // Work out exactly what we are dealing with here before calling a factory method to
     // create the appropriate type of object.
@@ -362,7 +657,11 @@ std::unique_ptr<Record> NewGRFData::read_record(std::istream& is, uint32_t size,
         case 0x02: 
             // Action02 (variants): Defines graphics set IDs
             // This byte is in the basic case a number of graphics sets, presumably always less than 0x80.
-            switch (static_cast<uint8_t>(data[2]))
+            if (length < 3)
+            {
+                throw RUNTIME_ERROR("Action02 record is too short");
+            }
+            switch (data[2])
             {
                 case 0x80: // Use 80 to randomize the object (vehicle, station, building, industry, object) based on its own triggers and bits.
                 case 0x83: // Use 83 to randomize the object based on its "related" object (s.b.).
@@ -430,16 +729,18 @@ std::unique_ptr<Record> NewGRFData::read_record(std::istream& is, uint32_t size,
     // Use a factory to create the appropriate object and then parse the data 
     // previously read from the file.
     std::unique_ptr<Record> record = make_record(record_type);
-    std::istringstream iss(data);
-    record->read(iss, m_info); 
-    record->read_data = data;
-    update_version_info(*record);
+    ByteReader bis(data, length);
+    record->read(bis, info); 
+    if (Record::retain_read_data)
+    {
+        record->read_data.assign(reinterpret_cast<const char*>(data), length);
+    }
 
     return record;
 }
 
 
-std::unique_ptr<Record> NewGRFData::make_record(RecordType record_type)
+std::unique_ptr<Record> NewGRFData::make_record(RecordType record_type) const
 {
     switch (record_type)
     {
@@ -502,36 +803,35 @@ uint32_t NewGRFData::total_records() const
 }
 
 
-void NewGRFData::write_format(std::ostream& os, uint32_t sprite_offs) const
+// Returns the position of the sprite section offset, which is patched once the data
+// section has been written.
+size_t NewGRFData::write_format(ByteWriter& os) const
 {
+    size_t sprite_offs_pos = 0;
     if (m_info.format == GRFFormat::Container2)
     {
         // Write a leader to indicate the container version.
-        write_uint16(os, 0);
-
-        for (const auto& item: CONTAINER2_IDENTIFIER)
-        {
-            write_uint8(os, item);
-        }
+        os.write_uint16(0);
+        os.write_bytes(CONTAINER2_IDENTIFIER.data(), CONTAINER2_IDENTIFIER.size());
 
-        // Temporary values for now. Come back later to overwrite.
-        write_uint32(os, sprite_offs); // Sprite offset in the file.
-        write_uint8(os,  0x00);        // Sprite compression - it seems that no values are defined for this.
+        sprite_offs_pos = os.reserve_uint32(); // Sprite offset in the file.
+        os.write_uint8(0x00);                  // Sprite compression - it seems that no values are defined for this.
     }
+    return sprite_offs_pos;
 }
 
 
-void NewGRFData::write_counter(std::ostream& os) const
+void NewGRFData::write_counter(ByteWriter& os) const
 {
     // Create the counter record at the start of the file.
     switch (m_info.format)
     {
-        case GRFFormat::Container1: write_uint16(os, 0x0004); break;
-        case GRFFormat::Container2: write_uint32(os, 0x0004); break;
+        case GRFFormat::Container1: os.write_uint16(0x0004); break;
+        case GRFFormat::Container2: os.write_uint32(0x0004); break;
     }
-    write_uint8(os, 0xFF);
+    os.write_uint8(0xFF);
     // It appears we should not count the counter itself.
-    write_uint32(os, total_records());
+    os.write_uint32(total_records());
 }
 
 
@@ -558,7 +858,7 @@ void NewGRFData::write_counter(std::ostream& os) const
 // }
 
 
-void NewGRFData::write_record(std::ostream& os, const Record& record) const
+void NewGRFData::write_record(ByteWriter& os, const Record& record, const SpriteAliasMap& aliases) const
 {
     if (record.record_type() == RecordType::REAL_SPRITE)
     {
@@ -577,103 +877,218 @@ void NewGRFData::write_record(std::ostream& os, const Record& record) const
         {
             throw RUNTIME_ERROR("Expected single real sprite");
         }
-        write_record(os, *sprites[0]);
+        write_record(os, *sprites[0], aliases);
     }       
     else 
     {
         // All the others are handled in same way.
 
-        // Write the record into a buffer in order to obtain its length.
-        // The buffer is copied to the output after writing a record header.
-        std::ostringstream ss;
-        record.write(ss, m_info);
-        std::string data = ss.str();
-        uint16_t length = uint16_t(data.length());
-
-        // Compare strings from read and write phases
-        // Testing only.
-        // if (record->record_type() != RecordType::SPRITE_INDEX)
-        // {
-        //     compare_strings(record->read_data, data);
-        //     std::ostringstream ss2;
-        //     record->write(ss2, m_info);
-        // }
-
-        // Record header
+        // Reserve space for the record header and have the record write itself directly
+        // into the output buffer. The length is patched in afterwards.
+        size_t length_pos = (m_info.format == GRFFormat::Container1) ? 
+            os.reserve_uint16() : os.reserve_uint32();
+
+        // All pseudo-sprites are prefixed with 0xFF, except index records for real sprites.        
+        uint8_t prefix = (record.record_type() == RecordType::SPRITE_INDEX) ? 0xFD : 0xFF;
+        os.write_uint8(prefix);
+
+        size_t start = os.position();
+        auto alias = (record.record_type() == RecordType::SPRITE_INDEX) ? 
+            aliases.find(static_cast<const SpriteIndexRecord*>(&record)->sprite_id()) : aliases.end();
+        if (alias != aliases.end())
+        {
+            SpriteIndexRecord{RecordType::ACTION_01, alias->second}.write(os, m_info);
+        }
+        else
+        {
+            record.write(os, m_info);
+        }
+        size_t length = os.position() - start;
+
         if (m_info.format == GRFFormat::Container1)
         {
-            write_uint16(os, length);
+            os.patch_uint16(length_pos, uint16_t(length));
         }
         else
         {
-            write_uint32(os, length);
+            os.patch_uint32(length_pos, uint32_t(length));
         }
+    }
+}
 
-        // All pseudo-sprites are prefixed with 0xFF, except index records for real sprites.        
-        uint8_t prefix = (record.record_type() == RecordType::SPRITE_INDEX) ? 0xFD : 0xFF;
-        write_uint8(os, prefix);
 
-        // Copy out the record data
-        for (const auto byte: data)
+NewGRFData::SpriteAliasMap NewGRFData::find_sprite_aliases() const
+{
+    // Container2 allows several sprite index records to refer to the same sprite ID, so 
+    // a sprite whose images are all identical to those of an earlier sprite can share them.
+    // Sprite IDs are arbitrary labels for the sprite section, so changing them makes no 
+    // difference to the GRF. Candidates are found by hashing, and then compared in full.
+    SpriteAliasMap aliases;
+    std::map<uint64_t, std::vector<const SpriteZoomVector*>> candidates;
+    std::map<const SpriteZoomVector*, uint32_t> sprite_ids;
+
+    auto same_images = [](const SpriteZoomVector& images1, const SpriteZoomVector& images2)
+    {
+        if (images1.size() != images2.size())
         {
-            write_uint8(os, byte);
+            return false;
+        }
+        for (size_t i = 0; i < images1.size(); ++i)
+        {
+            auto image1 = static_cast<const RealSpriteRecord*>(images1[i].get());
+            auto image2 = static_cast<const RealSpriteRecord*>(images2[i].get());
+            if (!image1->same_content(*image2))
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    for (const auto& it: m_sprites)
+    {
+        const SpriteZoomVector& images = it.second;
+
+        // Sound effects and such like are left alone.
+        uint64_t hash = images.size();
+        bool     real = !images.empty();
+        for (const auto& image: images)
+        {
+            if (image->record_type() != RecordType::REAL_SPRITE)
+            {
+                real = false;
+                break;
+            }
+            hash = hash * 0x100000001B3ULL + static_cast<const RealSpriteRecord*>(image.get())->content_hash();
+        }
+        if (!real)
+        {
+            continue;
+        }
+
+        std::vector<const SpriteZoomVector*>& matches = candidates[hash];
+        auto match = std::find_if(matches.begin(), matches.end(), 
+            [&](const SpriteZoomVector* other) { return same_images(images, *other); });
+        if (match != matches.end())
+        {
+            aliases[it.first] = sprite_ids[*match];
+        }
+        else
+        {
+            matches.push_back(&images);
+            sprite_ids[&images] = it.first;
         }
     }
+
+    return aliases;
 }
 
 
+// The number of sprites compressed per thread in each batch when writing.
+static constexpr size_t SPRITES_PER_JOB = 64;
+
+
 void NewGRFData::write(std::ostream& os) const
 {
+    // Everything is written into a buffer which is passed on to the output in large blocks.
+    // The output is written strictly in order, so it does not need to be seekable: it 
+    // can be a pipe.
+    ByteWriter writer{&os};
+
     // Header section indicates that this a Container2 format, or not.
     // The counter is an optional record containing the number of records in the GRF.
-    write_format(os);
-    write_counter(os);
+    size_t sprite_offs_pos = write_format(writer);
+    write_counter(writer);
+
+    // The Container2 header contains the size of the data section, so we hold the whole 
+    // section in the buffer until that is known. The data section is usually small: most 
+    // of the bulk of a GRF is in the sprite section which follows.
+    bool hold_data_section = (m_info.format == GRFFormat::Container2);
+
+    // Duplicate sprites are only written once, and referred to by the ID of the first.
+    SpriteAliasMap aliases;
+    if (CommandLineOptions::options().alias_sprites() && (m_info.format == GRFFormat::Container2))
+    {
+        aliases = find_sprite_aliases();
+        std::cout << "Aliasing removed " << aliases.size() << " duplicate sprites" << std::endl;
+    }
 
     for (const auto& record: m_records)
     {
-        write_record(os, *record);
+        write_record(writer, *record, aliases);
 
         // Containers are used to hold records in a logical tree which is
         // not really present in the GRF. This is mostly used for the collection
         // of sprites which comes after Actions 01, 05, 0A, and so on. And Action 11.
         for (uint32_t j = 0; j < record->num_sprites_to_write(); ++j)
         {
-            write_record(os, *(record->get_sprite(j)));
+            write_record(writer, *(record->get_sprite(j)), aliases);
+        }
+
+        if (!hold_data_section)
+        {
+            writer.flush();
         }
     }
 
     // Data section terminator - zero-length record
     if (m_info.format == GRFFormat::Container1)
     {
-        write_uint16(os, 0x0000);
+        writer.write_uint16(0x0000);
     }
     else
     {
-        write_uint32(os, 0x0000000);
+        writer.write_uint32(0x0000000);
     } 
 
-    // Now we know the offset for the graphics section.
-    // There is a fixed offset here which skips the file header.
-    uint32_t sprite_offs = static_cast<uint32_t>(os.tellp()) - 14U; 
-
     // For the Container version 2, all the actual image data goes at the end.
     // This section does not exist for Container version 1.
     if (m_info.format == GRFFormat::Container2)
     {
+        // Now we know the offset for the graphics section.
+        // There is a fixed offset here which skips the file header.
+        uint32_t sprite_offs = static_cast<uint32_t>(writer.position()) - 14U; 
+        writer.patch_uint32(sprite_offs_pos, sprite_offs);
+
+        // Compressing the sprites is by far the most expensive part of writing the file, and
+        // each sprite is independent of the others. They are compressed on several threads into 
+        // separate buffers, which are written out in the usual order, so the output does not 
+        // depend on the number of threads. This is done in batches to limit the memory used.
+        std::vector<const Record*> sprites;
         for (const auto& it: m_sprites)
         {
+            if (aliases.find(it.first) != aliases.end())
+            {
+                continue;
+            }
             for (const auto& sprite: it.second)
             {
-                sprite->write(os, m_info);
+                sprites.push_back(sprite.get());
+            }
+        }
+
+        const uint32_t jobs       = CommandLineOptions::options().jobs();
+        const size_t   batch_size = size_t(jobs) * SPRITES_PER_JOB;
+        for (size_t first = 0; first < sprites.size(); first += batch_size)
+        {
+            size_t count = std::min(batch_size, sprites.size() - first);
+            std::vector<ByteWriter> buffers(count);
+            parallel_for(count, jobs, [&](size_t index)
+            {
+                sprites[first + index]->write(buffers[index], m_info);
+            });
+
+            for (const auto& buffer: buffers)
+            {
+                writer.write_bytes(buffer.buffer().data(), buffer.buffer().size());
             }
+            writer.flush();
         }
 
-        write_uint32(os, 0x0000000);
+        writer.write_uint32(0x0000000);
     }
 
-    // Restore the stream to the beginning to rewrite the header.
-    os.seekp(0, std::istream::beg);
-    write_format(os, sprite_offs);
+    writer.flush(true);
 }
 
 
@@ -762,6 +1177,10 @@ void NewGRFData::parse(TokenStream& is, const std::string& output_dir, const std
     // parse its own internals. The GRF file is nothing more than a long list of 
     // such records. Reading the text should result in the same data structure as 
     // reading the equivalent binary file.
+    //
+    // With --incremental, records which have not changed since the last encode are copied 
+    // from the manifest rather than parsed. The records which are parsed are stored in it.
+    RecordManifest& manifest = RecordManifest::manifest();
     uint32_t exceptions    = 0;
     uint32_t record_number = 0;
     while (is.peek().type != TokenType::Terminator)
@@ -771,9 +1190,29 @@ void NewGRFData::parse(TokenStream& is, const std::string& output_dir, const std
             RecordType type  = parse_record_type(is);
             is.unmatch();
 
-            std::unique_ptr<Record> record = make_record(type);
-            record->parse(is, m_sprites);
-            update_version_info(*record);
+            uint32_t length = 0;
+            uint64_t hash   = 0;
+            if (manifest.enabled() && RecordManifest::is_cacheable(type))
+            {
+                length = is.record_length();
+                hash   = is.hash_tokens(length);
+            }
+
+            std::unique_ptr<Record> record = (length > 0) ? manifest.find(hash, type) : nullptr;
+            if (record)
+            {
+                is.skip(length);
+            }
+            else
+            {
+                record = make_record(type);
+                record->parse(is, m_sprites);
+                update_version_info(*record);
+                if (length > 0)
+                {
+                    record = manifest.store(hash, *record, m_info);
+                }
+            }
             m_records.push_back(std::move(record));
         }
         catch (const std::exception& e)
@@ -832,12 +1271,12 @@ void NewGRFData::hex_dump(std::ostream& os)
         ++index; 
 
 
-        std::ostringstream ss;
+        ByteWriter ss;
         record->write(ss, m_info);
 
         os << "Record #" << index << "\n";
         os << RecordName(record->record_type()) << "\n";
-        os << to_nfo(ss.str(), 0) << "\n\n";
+        os << to_nfo(std::string(ss.buffer().begin(), ss.buffer().end()), 0) << "\n\n";
     }
 
     if (m_info.format == GRFFormat::Container2)
@@ -849,10 +1288,10 @@ void NewGRFData::hex_dump(std::ostream& os)
                 ++index; 
                 auto sprite = dynamic_cast<RealSpriteRecord*>(record.get());
 
-                std::ostringstream ss;
+                ByteWriter ss;
                 sprite->write(ss, m_info);
                 os << "Sprite #" << to_hex(sprite->sprite_id()) << "\n";
-                os << to_nfo(ss.str(), 0) << "\n";
+                os << to_nfo(std::string(ss.buffer().begin(), ss.buffer().end()), 0) << "\n";
             }
         }
     }
@@ -18,6 +18,8 @@
 ///////////////////////////////////////////////////////////////////////////////
 #pragma once
 #include "Record.h"
+#include "ByteReader.h"
+#include "ByteWriter.h"
 #include <iostream>
 #include <memory>
 #include <vector>
@@ -33,8 +35,10 @@ class NewGRFData
 public:
     NewGRFData();
 
-    // Binary serialisation
+    // Binary serialisation. Reading from a stream is a fallback for files which 
+    // cannot be memory mapped: the whole stream is loaded into memory first.
     void read(std::istream& is);
+    void read(ByteReader& is);
     void write(std::ostream& os) const;
     // Text serialisation
     void print(std::ostream& os, const std::string& output_dir, const std::string& image_file_base) const;
@@ -46,20 +50,27 @@ public:
 
 private:    
     // Helpers for reading a GRF binary file 
-    GRFFormat               read_format(std::istream& is);
-    std::unique_ptr<Record> read_record(std::istream& is, uint32_t size, bool top_level, const GRFInfo& info);
-    void                    read_sprite(std::istream& is, uint32_t sprite_id, uint32_t size, uint8_t compression, const GRFInfo& info);
-    std::unique_ptr<Record> make_record(RecordType record_type);
+    GRFFormat               read_format(ByteReader& is);
+    std::unique_ptr<Record> read_record(ByteReader& is, uint32_t size, bool top_level, const GRFInfo& info);
+    void                    read_sprite(ByteReader& is, uint32_t sprite_id, uint32_t size, uint8_t compression, const GRFInfo& info);
+    void                    read_records_in_parallel(ByteReader& is, uint32_t& record_index, uint16_t& num_sprites, RecordType& container);
+    void                    read_sprites_in_parallel(ByteReader& is);
+    std::unique_ptr<Record> decode_record(ByteReader& is, uint32_t size, bool top_level, const GRFInfo& info) const;
+    std::unique_ptr<Record> make_record(RecordType record_type) const;
 
     friend void append_real_sprite(uint32_t sprite_id, std::unique_ptr<Record> sprite);
     void append_sprite(uint32_t sprite_id, std::unique_ptr<Record> sprite);
+    void add_record(std::unique_ptr<Record> record, uint16_t& num_sprites, RecordType& container);
     void update_version_info(const Record& record);
 
     // Helpers for writing a GRF binary file
-    void write_format(std::ostream& os, uint32_t sprite_offs = 0) const;
-    void write_counter(std::ostream& os) const;
-    void write_record(std::ostream& os, const Record& record) const;
+    size_t write_format(ByteWriter& os) const;
+    void   write_counter(ByteWriter& os) const;
+    // Maps sprite IDs onto the IDs of identical sprites which are written in their place.
+    using SpriteAliasMap = std::map<uint32_t, uint32_t>;
+    void   write_record(ByteWriter& os, const Record& record, const SpriteAliasMap& aliases) const;
     uint32_t total_records() const;
+    SpriteAliasMap find_sprite_aliases() const;
 
 private:
     GRFInfo m_info;
@@ -25,10 +25,11 @@
 #include "FakeSpriteRecord.h"
 
 
-int Record::alloc_count = 0;
+int  Record::alloc_count      = 0;
+bool Record::retain_read_data = false;
 
 
-void ActionRecord::write(std::ostream& os, const GRFInfo& info) const
+void ActionRecord::write(ByteWriter& os, const GRFInfo& info) const
 {
     // The read and write methods for this class are unbalanced because 
     // the file reader needs to read ahead to work out what kind of 
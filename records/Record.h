@@ -20,6 +20,8 @@
 #include "TokenStream.h"
 #include "GRFStrings.h"
 #include "GRFLabel.h"
+#include "ByteReader.h"
+#include "ByteWriter.h"
 #include <cstdint>
 #include <iostream>
 #include <vector>
@@ -180,8 +182,8 @@ public:
     virtual ~Record() {}
 
     // Binary serialisation
-    virtual void read(std::istream& is, const GRFInfo& info) {};
-    virtual void write(std::ostream& os, const GRFInfo& info) const {}; 
+    virtual void read(ByteReader& is, const GRFInfo& info) {};
+    virtual void write(ByteWriter& os, const GRFInfo& info) const {}; 
     // Text serialisation - sprites structure needed to hold sprites found in containers.
     virtual void print(std::ostream& os, const SpriteZoomMap& sprites, uint16_t indent) const {};
     virtual void parse(TokenStream& is, SpriteZoomMap& sprites) {};
@@ -198,7 +200,10 @@ public:
     static int alloc_count;
 
 public:
-    // Purely for testing purposes.
+    // Purely for testing purposes. The binary data from which the record was read is 
+    // only kept if retain_read_data is set, as it would otherwise double the memory
+    // used for the data section of large GRFs.
+    static bool retain_read_data;
     std::string read_data;    
 };
 
@@ -212,8 +217,8 @@ public:
     virtual ~ActionRecord() {}
 
     // Binary serialisation
-    //void read(std::istream& is, const GRFInfo& info) override {};
-    void write(std::ostream& os, const GRFInfo& info) const override; 
+    //void read(ByteReader& is, const GRFInfo& info) override {};
+    void write(ByteWriter& os, const GRFInfo& info) const override; 
     // Text serialisation
     //void print(std::ostream& os, const SpriteZoomMap& sprites, uint16_t indent) const override {};
     //void parse(TokenStream& is, SpriteZoomMap& sprites) override {};
@@ -228,8 +233,8 @@ public:
     virtual ~ContainerRecord() {}
 
     // Binary serialisation
-    //void read(std::istream& is, const GRFInfo& info) override {};
-    //void write(std::ostream& os, const GRFInfo& info) const override; 
+    //void read(ByteReader& is, const GRFInfo& info) override {};
+    //void write(ByteWriter& os, const GRFInfo& info) const override; 
     // Text serialisation
     //void print(std::ostream& os, const SpriteZoomMap& sprites, uint16_t indent) const override {};
     //void parse(TokenStream& is, SpriteZoomMap& sprites) override {};
@@ -0,0 +1,196 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#include "RecordManifest.h"
+#include "MappedFile.h"
+#include "FileSystem.h"
+#include "yagl_version.h" // Generated in a pre-build step.
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+
+
+namespace {
+
+constexpr std::array<uint8_t, 4> MANIFEST_MAGIC = { 'Y', 'R', 'M', '1' };
+
+} // namespace {
+
+
+void ManifestRecord::write(ByteWriter& os, const GRFInfo& info) const
+{
+    os.write_bytes(m_data->data(), m_data->size());
+}
+
+
+RecordManifest& RecordManifest::manifest()
+{
+    static RecordManifest instance;
+    return instance;
+}
+
+
+bool RecordManifest::is_cacheable(RecordType type)
+{
+    switch (type)
+    {
+        // Containers are always parsed so that their sprites are read from the sprite 
+        // sheets and binary files, and the number of sprites in each is checked. The sprites 
+        // are counted in the skip counts of Action07 and Action09, so those are parsed too, 
+        // along with the labels of Action10. Action08 sets the GRF version, on which the 
+        // data for Action13 depends.
+        case RecordType::ACTION_00:
+        case RecordType::ACTION_02_BASIC:
+        case RecordType::ACTION_02_RANDOM:
+        case RecordType::ACTION_02_VARIABLE:
+        case RecordType::ACTION_02_INDUSTRY:
+        case RecordType::ACTION_02_SPRITE_LAYOUT:
+        case RecordType::ACTION_03:
+        case RecordType::ACTION_04:
+        case RecordType::ACTION_06:
+        case RecordType::ACTION_0B:
+        case RecordType::ACTION_0C:
+        case RecordType::ACTION_0D:
+        case RecordType::ACTION_0E:
+        case RecordType::ACTION_0F:
+        case RecordType::ACTION_14:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+
+void RecordManifest::load(const std::string& file_name)
+{
+    m_enabled = true;
+    m_previous.clear();
+    m_current.clear();
+    m_reused  = 0;
+    m_parsed  = 0;
+
+    if (!MappedFile::can_map(file_name))
+    {
+        return;
+    }
+
+    try
+    {
+        MappedFile file{file_name};
+        ByteReader is{file.data(), file.size()};
+
+        // A manifest written by a different version of yagl is ignored.
+        const uint8_t* magic = is.read_bytes(MANIFEST_MAGIC.size());
+        if (!std::equal(MANIFEST_MAGIC.begin(), MANIFEST_MAGIC.end(), magic) || 
+            (is.read_uint32() != MANIFEST_VERSION))
+        {
+            return;
+        }
+        // A build without a version cannot tell whether the manifest was written by one 
+        // which serialises records differently, so it never uses one.
+        uint32_t length = is.read_uint32();
+        const char* version = reinterpret_cast<const char*>(is.read_bytes(length));
+        if ((std::strlen(str_yagl_version) == 0) || (std::string(version, length) != str_yagl_version))
+        {
+            return;
+        }
+
+        // Each entry is: hash, data size, data.
+        uint32_t count = is.read_uint32();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint64_t hash = is.read_uint32();
+            hash |= uint64_t(is.read_uint32()) << 32;
+            uint32_t size = is.read_uint32();
+            const uint8_t* data = is.read_bytes(size);
+            m_previous[hash] = std::make_shared<const std::vector<uint8_t>>(data, data + size);
+        }
+    }
+    catch (const std::exception&)
+    {
+        m_previous.clear();
+    }
+}
+
+
+void RecordManifest::save(const std::string& file_name) const
+{
+    // Write to a temporary file and then rename it, so that an interrupted encode does 
+    // not leave a partial manifest behind.
+    std::string temp = file_name + ".tmp";
+    {
+        std::ofstream os(temp, std::ios::binary);
+        if (os.fail())
+        {
+            throw RUNTIME_ERROR("Error opening file for writing: " + temp);
+        }
+
+        ByteWriter writer{&os};
+        writer.write_bytes(MANIFEST_MAGIC.data(), MANIFEST_MAGIC.size());
+        writer.write_uint32(MANIFEST_VERSION);
+        std::string version{str_yagl_version};
+        writer.write_uint32(uint32_t(version.size()));
+        writer.write_bytes(reinterpret_cast<const uint8_t*>(version.data()), version.size());
+
+        writer.write_uint32(uint32_t(m_current.size()));
+        for (const auto& [hash, data]: m_current)
+        {
+            writer.write_uint32(uint32_t(hash));
+            writer.write_uint32(uint32_t(hash >> 32));
+            writer.write_uint32(uint32_t(data->size()));
+            writer.write_bytes(data->data(), data->size());
+            writer.flush();
+        }
+        writer.flush(true);
+    }
+
+    fs::rename(temp, file_name);
+}
+
+
+std::unique_ptr<Record> RecordManifest::find(uint64_t hash, RecordType type)
+{
+    // Identical records within the same script share an entry.
+    auto it = m_current.find(hash);
+    if (it == m_current.end())
+    {
+        auto previous = m_previous.find(hash);
+        if (previous == m_previous.end())
+        {
+            return nullptr;
+        }
+        it = m_current.insert(*previous).first;
+    }
+
+    ++m_reused;
+    return std::make_unique<ManifestRecord>(type, it->second);
+}
+
+
+std::unique_ptr<Record> RecordManifest::store(uint64_t hash, const Record& record, const GRFInfo& info)
+{
+    ByteWriter os;
+    record.write(os, info);
+
+    auto data = std::make_shared<const std::vector<uint8_t>>(os.buffer());
+    m_current[hash] = data;
+    ++m_parsed;
+    return std::make_unique<ManifestRecord>(record.record_type(), data);
+}
@@ -0,0 +1,88 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include "Record.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+// The binary data of a record which was copied from the manifest rather than parsed.
+class ManifestRecord : public Record
+{
+public:
+    using Data = std::shared_ptr<const std::vector<uint8_t>>;
+
+public:
+    ManifestRecord(RecordType record_type, Data data)
+    : Record{record_type}
+    , m_data{std::move(data)}
+    {
+    }
+
+    // The data is written exactly as it was when the record was last parsed.
+    void write(ByteWriter& os, const GRFInfo& info) const override;
+
+private:
+    Data m_data;
+};
+
+
+// A sidecar file for the YAGL script which holds the binary data of each record against 
+// a hash of its tokens. An encode only has to parse the records which have been edited 
+// since the last one: the others are copied from the manifest. Only records whose data 
+// depends on nothing but their own text are kept. A missing or damaged manifest just 
+// means that every record is parsed.
+class RecordManifest
+{
+public:
+    // Bump this whenever the binary data written for records changes.
+    static constexpr uint32_t MANIFEST_VERSION = 1;
+
+public:
+    static RecordManifest& manifest();
+
+    // The manifest is disabled until it has been loaded, even if the file does not exist.
+    void load(const std::string& file_name);
+    void save(const std::string& file_name) const;
+    bool enabled() const { return m_enabled; }
+
+    static bool is_cacheable(RecordType type);
+
+    // Returns the record stored for the hash, or nullptr if there is none. 
+    std::unique_ptr<Record> find(uint64_t hash, RecordType type);
+    // Serialises a newly parsed record and returns it in the form in which it will be written.
+    std::unique_ptr<Record> store(uint64_t hash, const Record& record, const GRFInfo& info);
+
+    uint32_t reused() const { return m_reused; }
+    uint32_t parsed() const { return m_parsed; }
+
+private:
+    bool m_enabled = false;
+
+    // Entries from the previous encode, and those used in this one. Only the latter are 
+    // saved, so the manifest does not accumulate records which no longer exist.
+    std::map<uint64_t, ManifestRecord::Data> m_previous;
+    std::map<uint64_t, ManifestRecord::Data> m_current;
+
+    uint32_t m_reused = 0;
+    uint32_t m_parsed = 0;
+};
@@ -17,6 +17,7 @@
 // along with yagl. If not, see <https://www.gnu.org/licenses/>.
 ///////////////////////////////////////////////////////////////////////////////
 #include "TokenStream.h"
+#include "Fnv1aHash.h"
 #include <sstream>
 
 
@@ -70,6 +71,42 @@ void TokenStream::next_record()
 }
 
 
+uint32_t TokenStream::record_length() const
+{
+    // Records can be longer than peek() is able to look ahead.
+    uint32_t blocks = 0;
+    for (size_t index = m_index; index < m_tokens.size(); ++index)
+    {
+        const TokenValue& token = m_tokens[index];
+        if (token.type == TokenType::OpenBrace)
+        {
+            ++blocks;
+        }
+        else if ((token.type == TokenType::CloseBrace) && (blocks > 0) && (--blocks == 0))
+        {
+            return static_cast<uint32_t>(index + 1 - m_index);
+        }
+    }
+    return 0;
+}
+
+
+uint64_t TokenStream::hash_tokens(uint32_t count) const
+{
+    // Hashes the type and text of each token.
+    Fnv1aHash hash;
+    for (size_t index = m_index; index < (m_index + count); ++index)
+    {
+        const TokenValue& token = m_tokens.at(index);
+        hash.add(static_cast<uint8_t>(token.type));
+        hash.add(token.value);
+        // Separates the values of adjacent tokens.
+        hash.add(uint8_t(0));
+    }
+    return hash.value();
+}
+
+
 bool TokenStream::match_ident(const std::string& value) 
 {
     const TokenValue& token = peek();
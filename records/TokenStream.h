@@ -80,6 +80,13 @@ public:
     // parsed again by that object. This gives a nicer exception...
     void unmatch() { if (m_index > 0) --m_index; }
 
+    // These allow a whole record to be passed over without parsing it. The length is the 
+    // number of tokens up to and including the brace which closes the record's block, or 
+    // zero if the block is not closed. Whitespace and comments do not affect the hash.
+    uint32_t record_length() const;
+    uint64_t hash_tokens(uint32_t count) const;
+    void     skip(uint32_t count) { m_index += count; }
+
 private:
     uint64_t match_uint64(TokenValue& token, DataType type);
 
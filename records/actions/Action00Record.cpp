@@ -40,7 +40,7 @@
 #include "CommandLineOptions.h"
 
 
-void Action00Record::read(std::istream& is, const GRFInfo& info)
+void Action00Record::read(ByteReader& is, const GRFInfo& info)
 {
     // We probably already know this from peeking - get from traits?
     m_feature = static_cast<FeatureType>(read_uint8(is));
@@ -86,7 +86,7 @@ void Action00Record::read(std::istream& is, const GRFInfo& info)
 }
 
 
-void Action00Record::write(std::ostream& os, const GRFInfo& info) const
+void Action00Record::write(ByteWriter& os, const GRFInfo& info) const
 {
     uint8_t num_props = uint8_t(m_properties.size());
     uint8_t num_info  = uint8_t(m_instances.size());
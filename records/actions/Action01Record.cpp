@@ -20,7 +20,7 @@
 #include "StreamHelpers.h"
 
 
-void Action01Record::read(std::istream& is, const GRFInfo& info)
+void Action01Record::read(ByteReader& is, const GRFInfo& info)
 {
     m_feature = static_cast<FeatureType>(read_uint8(is));
     
@@ -45,7 +45,7 @@ void Action01Record::read(std::istream& is, const GRFInfo& info)
 }
 
 
-void Action01Record::write(std::ostream& os, const GRFInfo& info) const
+void Action01Record::write(ByteWriter& os, const GRFInfo& info) const
 {
     ContainerRecord::write(os, info);
 
@@ -21,7 +21,7 @@
 #include "IntegerDescriptor.h"
 
 
-void Action02BasicRecord::read(std::istream& is, const GRFInfo& info)
+void Action02BasicRecord::read(ByteReader& is, const GRFInfo& info)
 {
     m_feature             = static_cast<FeatureType>(read_uint8(is));
     m_act02_set_id        = read_uint8(is);
@@ -40,7 +40,7 @@ void Action02BasicRecord::read(std::istream& is, const GRFInfo& info)
 }
 
 
-void Action02BasicRecord::write(std::ostream& os, const GRFInfo& info) const
+void Action02BasicRecord::write(ByteWriter& os, const GRFInfo& info) const
 {
     ActionRecord::write(os, info);
 
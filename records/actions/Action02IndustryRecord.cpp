@@ -21,7 +21,7 @@
 #include "EnumDescriptor.h"
 
 
-void Action02IndustryRecord::read(std::istream& is, const GRFInfo& info)
+void Action02IndustryRecord::read(ByteReader& is, const GRFInfo& info)
 {
     m_feature      = static_cast<FeatureType>(read_uint8(is));
     m_act02_set_id = read_uint8(is);
@@ -61,7 +61,7 @@ void Action02IndustryRecord::read(std::istream& is, const GRFInfo& info)
 }
 
 
-void Action02IndustryRecord::write(std::ostream& os, const GRFInfo& info) const
+void Action02IndustryRecord::write(ByteWriter& os, const GRFInfo& info) const
 {
     ActionRecord::write(os, info);
 
@@ -291,7 +291,7 @@ void Action02IndustryRecord::parse_version1(TokenStream& is)
 }   
 
 
-void Action02IndustryRecord::CargoList::read(std::istream& is)
+void Action02IndustryRecord::CargoList::read(ByteReader& is)
 {
     uint8_t num_input = read_uint8(is);
     cargos.resize(num_input);
@@ -305,7 +305,7 @@ void Action02IndustryRecord::CargoList::read(std::istream& is)
 }
 
 
-void Action02IndustryRecord::CargoList::write(std::ostream& os) const
+void Action02IndustryRecord::CargoList::write(ByteWriter& os) const
 {
     write_uint8(os, uint8_t(cargos.size()));
     for (const auto& c: cargos)
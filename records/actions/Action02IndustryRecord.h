@@ -38,8 +38,8 @@ public:
     }
 
     // Binary serialisation
-    void read(std::istream& is, const GRFInfo& info) override;
-    void write(std::ostream& os, const GRFInfo& info) const override;    
+    void read(ByteReader& is, const GRFInfo& info) override;
+    void write(ByteWriter& os, const GRFInfo& info) const override;    
     // Text serialisation
     void print(std::ostream& os, const SpriteZoomMap& sprites, uint16_t indent) const override;
     void parse(TokenStream& is, SpriteZoomMap& sprites) override;
@@ -105,8 +105,8 @@ private:
 
     struct CargoList
     {
-        void read(std::istream& is);
-        void write(std::ostream& os) const;    
+        void read(ByteReader& is);
+        void write(ByteWriter& os) const;    
         void print(std::ostream& os, uint16_t indent) const;
         void parse(TokenStream& is);
         std::vector<Cargo> cargos;
@@ -22,7 +22,7 @@
 #include "IntegerDescriptor.h"
 
 
-void Action02RandomRecord::read(std::istream& is, const GRFInfo& info)
+void Action02RandomRecord::read(ByteReader& is, const GRFInfo& info)
 {
     m_feature = static_cast<FeatureType>(read_uint8(is));
     m_set_id  = read_uint8(is);
@@ -61,7 +61,7 @@ void Action02RandomRecord::read(std::istream& is, const GRFInfo& info)
 }
 
 
-void Action02RandomRecord::write(std::ostream& os, const GRFInfo& info) const
+void Action02RandomRecord::write(ByteWriter& os, const GRFInfo& info) const
 {
     ActionRecord::write(os, info);
 
@@ -22,7 +22,7 @@
 #include "BooleanDescriptor.h"
 
 
-void Action02SpriteLayoutRecord::SpriteRegisters::read(std::istream& is, bool is_parent)
+void Action02SpriteLayoutRecord::SpriteRegisters::read(ByteReader& is, bool is_parent)
 {
     if (flags & BIT0_SKIP_SPRITE)     skip_sprite     = read_uint8(is);
     if (flags & BIT1_SPRITE_OFFSET)   sprite_offset   = read_uint8(is);
@@ -45,7 +45,7 @@ void Action02SpriteLayoutRecord::SpriteRegisters::read(std::istream& is, bool is
 }
 
 
-void Action02SpriteLayoutRecord::SpriteRegisters::write(std::ostream& os, bool is_parent) const
+void Action02SpriteLayoutRecord::SpriteRegisters::write(ByteWriter& os, bool is_parent) const
 {
     if (flags & BIT0_SKIP_SPRITE)       write_uint8(os, skip_sprite);
     if (flags & BIT1_SPRITE_OFFSET)     write_uint8(os, sprite_offset);
@@ -236,7 +236,7 @@ void Action02SpriteLayoutRecord::SpriteRegisters::parse(TokenStream& is, bool is
 }
 
 
-void Action02SpriteLayoutRecord::read(std::istream& is, const GRFInfo& info)
+void Action02SpriteLayoutRecord::read(ByteReader& is, const GRFInfo& info)
 {
     m_feature = static_cast<FeatureType>(read_uint8(is));
     m_set_id  = read_uint8(is);
@@ -315,7 +315,7 @@ void Action02SpriteLayoutRecord::read(std::istream& is, const GRFInfo& info)
 }
 
 
-void Action02SpriteLayoutRecord::write(std::ostream& os, const GRFInfo& info) const
+void Action02SpriteLayoutRecord::write(ByteWriter& os, const GRFInfo& info) const
 {
     ActionRecord::write(os, info);
 
@@ -29,8 +29,8 @@ public:
     }
 
     // Binary serialisation
-    void read(std::istream& is, const GRFInfo& info) override;
-    void write(std::ostream& os, const GRFInfo& info) const override;    
+    void read(ByteReader& is, const GRFInfo& info) override;
+    void write(ByteWriter& os, const GRFInfo& info) const override;    
     // Text serialisation
     void print(std::ostream& os, const SpriteZoomMap& sprites, uint16_t indent) const override;
     void parse(TokenStream& is, SpriteZoomMap& sprites) override;
@@ -64,8 +64,8 @@ private:
         uint8_t  sprite_var10;      // bit 6 
         uint8_t  recolour_var10;    // bit 7
 
-        void read(std::istream& is, bool is_parent);
-        void write(std::ostream& os, bool is_parent) const;
+        void read(ByteReader& is, bool is_parent);
+        void write(ByteWriter& os, bool is_parent) const;
         void print(std::ostream& os, bool is_parent, uint16_t indent) const;
         void parse(TokenStream& is, bool is_parent);
     };
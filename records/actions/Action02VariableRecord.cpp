@@ -26,7 +26,7 @@ using VarType = Action02VariableRecord::VarType;
 
 // The sizes of a number of the fields in the record depend on the type 
 // read near the beginning. 
-static uint32_t read_action(std::istream& is, VarType var_type)
+static uint32_t read_action(ByteReader& is, VarType var_type)
 {
      switch (var_type)
      {
@@ -47,7 +47,7 @@ static uint32_t read_action(std::istream& is, VarType var_type)
 }
 
 
-static void write_action(std::ostream& os, VarType type, uint32_t value)
+static void write_action(ByteWriter& os, VarType type, uint32_t value)
 {
      switch (type)
      {
@@ -66,7 +66,7 @@ static void write_action(std::ostream& os, VarType type, uint32_t value)
 }
 
 
-void Action02VariableRecord::read(std::istream& is, const GRFInfo& info)
+void Action02VariableRecord::read(ByteReader& is, const GRFInfo& info)
 {
     m_feature  = static_cast<FeatureType>(read_uint8(is));
     m_set_id.read(is);
@@ -150,7 +150,7 @@ void Action02VariableRecord::read(std::istream& is, const GRFInfo& info)
 }
 
 
-void Action02VariableRecord::write(std::ostream& os, const GRFInfo& info) const
+void Action02VariableRecord::write(ByteWriter& os, const GRFInfo& info) const
 {
     ActionRecord::write(os, info);
 
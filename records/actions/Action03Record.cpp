@@ -22,7 +22,7 @@
 #include "BooleanDescriptor.h"
 
 
-void Action03Record::read(std::istream& is, const GRFInfo& info)
+void Action03Record::read(ByteReader& is, const GRFInfo& info)
 {
     m_feature = static_cast<FeatureType>(read_uint8(is));
 
@@ -62,7 +62,7 @@ void Action03Record::read(std::istream& is, const GRFInfo& info)
 }
 
 
-void Action03Record::write(std::ostream& os, const GRFInfo& info) const
+void Action03Record::write(ByteWriter& os, const GRFInfo& info) const
 {
     ActionRecord::write(os, info);
 
@@ -31,8 +31,8 @@ public:
     }
 
     // Binary serialisation
-    void read(std::istream& is, const GRFInfo& info) override;
-    void write(std::ostream& os, const GRFInfo& info) const override;  
+    void read(ByteReader& is, const GRFInfo& info) override;
+    void write(ByteWriter& os, const GRFInfo& info) const override;  
     // Text serialisation
     void print(std::ostream& os, const SpriteZoomMap& sprites, uint16_t indent) const override;
     void parse(TokenStream& is, SpriteZoomMap& sprites) override;
@@ -21,7 +21,7 @@
 #include "GRFStrings.h"
 
 
-void Action04Record::read(std::istream& is, const GRFInfo& info)
+void Action04Record::read(ByteReader& is, const GRFInfo& info)
 {
     m_feature = static_cast<FeatureType>(read_uint8(is));
 
@@ -64,7 +64,7 @@ void Action04Record::read(std::istream& is, const GRFInfo& info)
 }
 
 
-void Action04Record::write(std::ostream& os, const GRFInfo& info) const
+void Action04Record::write(ByteWriter& os, const GRFInfo& info) const
 {
     ActionRecord::write(os, info);
 
@@ -20,7 +20,7 @@
 #include "StreamHelpers.h"
 
 
-void Action05Record::read(std::istream& is, const GRFInfo& info)
+void Action05Record::read(ByteReader& is, const GRFInfo& info)
 {
     // NewFeatureType - this is a type of sprite for new features 
     // not in TTD.
@@ -36,7 +36,7 @@ void Action05Record::read(std::istream& is, const GRFInfo& info)
 }
 
 
-void Action05Record::write(std::ostream& os, const GRFInfo& info) const
+void Action05Record::write(ByteWriter& os, const GRFInfo& info) const
 {
     ContainerRecord::write(os, info);
 
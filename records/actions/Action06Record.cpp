@@ -20,7 +20,7 @@
 #include "StreamHelpers.h"
 
 
-void Action06Record::read(std::istream& is, const GRFInfo& info)
+void Action06Record::read(ByteReader& is, const GRFInfo& info)
 {
     while (is.peek() != 0xFF)
     {
@@ -39,7 +39,7 @@ void Action06Record::read(std::istream& is, const GRFInfo& info)
 }
 
 
-void Action06Record::write(std::ostream& os, const GRFInfo& info) const
+void Action06Record::write(ByteWriter& os, const GRFInfo& info) const
 {
     ActionRecord::write(os, info);
 
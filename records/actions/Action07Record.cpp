@@ -84,7 +84,7 @@ void parse_description(uint8_t& param, TokenStream& is)
 } // namespace {
 
 
-void Action07Record::read(std::istream& is, const GRFInfo& info)
+void Action07Record::read(ByteReader& is, const GRFInfo& info)
 {
     m_variable  = read_uint8(is);
     m_varsize   = read_uint8(is);
@@ -110,7 +110,7 @@ void Action07Record::read(std::istream& is, const GRFInfo& info)
 }
 
 
-void Action07Record::write(std::ostream& os, const GRFInfo& info) const
+void Action07Record::write(ByteWriter& os, const GRFInfo& info) const
 {
     ActionRecord::write(os, info);
 
@@ -22,7 +22,7 @@
 #include "EnumDescriptor.h"
 
 
-void Action08Record::read(std::istream& is, const GRFInfo& info)
+void Action08Record::read(ByteReader& is, const GRFInfo& info)
 {
     // This is the version of the GRF specification we are using.
     m_grf_version = static_cast<GRFVersion>(read_uint8(is));
@@ -35,7 +35,7 @@ void Action08Record::read(std::istream& is, const GRFInfo& info)
 }
 
 
-void Action08Record::write(std::ostream& os, const GRFInfo& info) const
+void Action08Record::write(ByteWriter& os, const GRFInfo& info) const
 {
     ActionRecord::write(os, info);
 
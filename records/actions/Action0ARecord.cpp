@@ -21,7 +21,7 @@
 #include "RecolourRecord.h"
 
 
-void Action0ARecord::read(std::istream& is, const GRFInfo& info)
+void Action0ARecord::read(ByteReader& is, const GRFInfo& info)
 {
     uint8_t num_sets = read_uint8(is);
     m_sets.resize(num_sets);
@@ -34,7 +34,7 @@ void Action0ARecord::read(std::istream& is, const GRFInfo& info)
 }
 
 
-void Action0ARecord::write(std::ostream& os, const GRFInfo& info) const
+void Action0ARecord::write(ByteWriter& os, const GRFInfo& info) const
 {
     ContainerRecord::write(os, info);
 
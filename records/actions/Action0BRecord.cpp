@@ -23,7 +23,7 @@
 #include "IntegerDescriptor.h"
 
 
-void Action0BRecord::read(std::istream& is, const GRFInfo& info)
+void Action0BRecord::read(ByteReader& is, const GRFInfo& info)
 {
     uint8_t severity = read_uint8(is);
     m_language_id    = read_uint8(is);
@@ -45,7 +45,7 @@ void Action0BRecord::read(std::istream& is, const GRFInfo& info)
 
     // // Can either scan the string or just check for end of input. The 
     // // built in strings can't be scanned, so...
-    if (is.peek() != EOF)
+    if (!is.at_end())
     {
         m_data.read(is);
     }
@@ -53,12 +53,12 @@ void Action0BRecord::read(std::istream& is, const GRFInfo& info)
     m_num_params = 0;
     m_param1     = 0xFF;
     m_param2     = 0xFF;
-    if (is.peek() != EOF)
+    if (!is.at_end())
     {
         m_num_params = 1;
         m_param1     = read_uint8(is);
     }
-    if (is.peek() != EOF)
+    if (!is.at_end())
     {
         m_num_params = 2;
         m_param2     = read_uint8(is);
@@ -66,7 +66,7 @@ void Action0BRecord::read(std::istream& is, const GRFInfo& info)
 }
 
 
-void Action0BRecord::write(std::ostream& os, const GRFInfo& info) const
+void Action0BRecord::write(ByteWriter& os, const GRFInfo& info) const
 {
     ActionRecord::write(os, info);
 
@@ -20,7 +20,7 @@
 #include "StreamHelpers.h"
 
 
-void Action0CRecord::read(std::istream& is, const GRFInfo& info)
+void Action0CRecord::read(ByteReader& is, const GRFInfo& info)
 {
     // This could be a text comment, or binary data (a commented pseudo-sprite).
     // UI needs to reflect this. 
@@ -28,7 +28,7 @@ void Action0CRecord::read(std::istream& is, const GRFInfo& info)
 }
 
 
-void Action0CRecord::write(std::ostream& os, const GRFInfo& info) const
+void Action0CRecord::write(ByteWriter& os, const GRFInfo& info) const
 {
     ActionRecord::write(os, info);
  
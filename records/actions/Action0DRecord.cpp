@@ -24,7 +24,7 @@
 #include <sstream>
 
 
-void Action0DRecord::read(std::istream& is, const GRFInfo& info)
+void Action0DRecord::read(ByteReader& is, const GRFInfo& info)
 {
     m_target = read_uint8(is);
     
@@ -49,7 +49,7 @@ void Action0DRecord::read(std::istream& is, const GRFInfo& info)
 }
 
 
-void Action0DRecord::write(std::ostream& os, const GRFInfo& info) const
+void Action0DRecord::write(ByteWriter& os, const GRFInfo& info) const
 {
     ActionRecord::write(os, info);
 
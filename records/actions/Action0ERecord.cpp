@@ -20,13 +20,13 @@
 #include "StreamHelpers.h"
 
 
-void Action0ERecord::read(std::istream& is, const GRFInfo& info)
+void Action0ERecord::read(ByteReader& is, const GRFInfo& info)
 {
     m_grf_ids.read(is);
 }
 
 
-void Action0ERecord::write(std::ostream& os, const GRFInfo& info) const
+void Action0ERecord::write(ByteWriter& os, const GRFInfo& info) const
 {
     ActionRecord::write(os, info);
     m_grf_ids.write(os);
@@ -21,7 +21,7 @@
 #include "GRFStrings.h"
 
 
-void Action0FRecord::read(std::istream& is, const GRFInfo& info)
+void Action0FRecord::read(ByteReader& is, const GRFInfo& info)
 {
     m_id  = read_uint8(is);
 
@@ -70,7 +70,7 @@ void Action0FRecord::read(std::istream& is, const GRFInfo& info)
 }
 
 
-void Action0FRecord::write(std::ostream& os, const GRFInfo& info) const
+void Action0FRecord::write(ByteWriter& os, const GRFInfo& info) const
 {
     ActionRecord::write(os, info);
 
@@ -20,14 +20,14 @@
 #include "StreamHelpers.h"
 
 
-void Action10Record::read(std::istream& is, const GRFInfo& info)
+void Action10Record::read(ByteReader& is, const GRFInfo& info)
 {
     m_label = read_uint8(is);
     m_comment.read(is, StringTerm::None);
 }
 
 
-void Action10Record::write(std::ostream& os, const GRFInfo& info) const
+void Action10Record::write(ByteWriter& os, const GRFInfo& info) const
 {
     ActionRecord::write(os, info);
 
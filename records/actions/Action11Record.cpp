@@ -22,7 +22,7 @@
 #include "StreamHelpers.h"
 
 
-void Action11Record::read(std::istream& is, const GRFInfo& info)
+void Action11Record::read(ByteReader& is, const GRFInfo& info)
 {
     // This is used to tell us how many of the following records are the
     // children of this one, but not important after that
@@ -30,7 +30,7 @@ void Action11Record::read(std::istream& is, const GRFInfo& info)
 }
 
 
-void Action11Record::write(std::ostream& os, const GRFInfo& info) const
+void Action11Record::write(ByteWriter& os, const GRFInfo& info) const
 {
     ContainerRecord::write(os, info);
 
@@ -21,7 +21,7 @@
 #include "EnumDescriptor.h"
 
 
-void Action12Record::read(std::istream& is, const GRFInfo& info)
+void Action12Record::read(ByteReader& is, const GRFInfo& info)
 {
     uint8_t num_ranges = read_uint8(is);
 
@@ -36,7 +36,7 @@ void Action12Record::read(std::istream& is, const GRFInfo& info)
 }
 
 
-void Action12Record::write(std::ostream& os, const GRFInfo& info) const
+void Action12Record::write(ByteWriter& os, const GRFInfo& info) const
 {
     ActionRecord::write(os, info);
 
@@ -20,7 +20,7 @@
 #include "StreamHelpers.h"
 
 
-void Action13Record::read(std::istream& is, const GRFInfo& info)
+void Action13Record::read(ByteReader& is, const GRFInfo& info)
 {
     m_grf_id.read(is);
 
@@ -43,7 +43,7 @@ void Action13Record::read(std::istream& is, const GRFInfo& info)
 }
 
 
-void Action13Record::write(std::ostream& os, const GRFInfo& info) const
+void Action13Record::write(ByteWriter& os, const GRFInfo& info) const
 {
     ActionRecord::write(os, info);
 
@@ -23,7 +23,7 @@
 #include <cctype>
 
 
-void Action14Record::read_chunks(std::istream& is, std::vector<Chunk>& chunks)
+void Action14Record::read_chunks(ByteReader& is, std::vector<Chunk>& chunks)
 {
     while (is.peek() != 0x00)
     {
@@ -60,13 +60,13 @@ void Action14Record::read_chunks(std::istream& is, std::vector<Chunk>& chunks)
 }
 
 
-void Action14Record::read(std::istream& is, const GRFInfo& info)
+void Action14Record::read(ByteReader& is, const GRFInfo& info)
 {
     read_chunks(is, m_chunks);
 }
 
 
-void Action14Record::write_chunks(std::ostream& os, const std::vector<Chunk>& chunks) const
+void Action14Record::write_chunks(ByteWriter& os, const std::vector<Chunk>& chunks) const
 {
     for (const auto& chunk: chunks)
     {
@@ -101,7 +101,7 @@ void Action14Record::write_chunks(std::ostream& os, const std::vector<Chunk>& ch
 }
 
 
-void Action14Record::write(std::ostream& os, const GRFInfo& info) const
+void Action14Record::write(ByteWriter& os, const GRFInfo& info) const
 {
     ActionRecord::write(os, info);
     
@@ -52,8 +52,8 @@ public:
     }
 
     // Binary serialisation
-    void read(std::istream& is, const GRFInfo& info) override;
-    void write(std::ostream& os, const GRFInfo& info) const override;   
+    void read(ByteReader& is, const GRFInfo& info) override;
+    void write(ByteWriter& os, const GRFInfo& info) const override;   
     // Text serialisation
     void print(std::ostream& os, const SpriteZoomMap& sprites, uint16_t indent) const override;
     void parse(TokenStream& is, SpriteZoomMap& sprites) override;
@@ -74,12 +74,12 @@ private:
         // Only for containers
         std::vector<Chunk> chunks;
 
-        //void read(std::istream& is);
+        //void read(ByteReader& is);
     };
 
 private:
-    void read_chunks(std::istream& is, std::vector<Chunk>& chunks);
-    void write_chunks(std::ostream& os, const std::vector<Chunk>& chunks) const;
+    void read_chunks(ByteReader& is, std::vector<Chunk>& chunks);
+    void write_chunks(ByteWriter& os, const std::vector<Chunk>& chunks) const;
     void print_chunks(std::ostream& os, const std::vector<Chunk>& chunks, uint16_t indent) const;
     void parse_chunks(TokenStream& is, std::vector<Chunk>& chunks);
 
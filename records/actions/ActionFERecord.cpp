@@ -20,7 +20,7 @@
 #include "StreamHelpers.h"
 
 
-void ActionFERecord::read(std::istream& is, const GRFInfo& info)
+void ActionFERecord::read(ByteReader& is, const GRFInfo& info)
 {
     m_import_code = read_uint8(is); // Always 0
     m_grf_id.read(is);
@@ -28,7 +28,7 @@ void ActionFERecord::read(std::istream& is, const GRFInfo& info)
 }
 
 
-void ActionFERecord::write(std::ostream& os, const GRFInfo& info) const
+void ActionFERecord::write(ByteWriter& os, const GRFInfo& info) const
 {
     ActionRecord::write(os, info);
 
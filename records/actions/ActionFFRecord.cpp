@@ -21,10 +21,11 @@
 #include "GRFStrings.h"
 #include "FileSystem.h"
 #include "CommandLineOptions.h"
+#include "ConversionCache.h"
 #include <fstream>
 
 
-void ActionFFRecord::read(std::istream& is, const GRFInfo& info)
+void ActionFFRecord::read(ByteReader& is, const GRFInfo& info)
 {
     // The length is superfluous as the string is null terminated.
     uint8_t length = read_uint8(is);
@@ -36,21 +37,20 @@ void ActionFFRecord::read(std::istream& is, const GRFInfo& info)
 
     // Not sure how big this is likely to be. It contains a WAV encoded 
     // sound effect. It is a byte-for-byte copy of the original WAV file.
-    while (is.peek() != EOF)
-    {
-        m_binary.push_back(read_uint8(is));
-    }
+    size_t size = is.remaining();
+    const uint8_t* data = is.read_bytes(size);
+    m_binary.assign(data, data + size);
 }
 
 
-void ActionFFRecord::write(std::ostream& os, const GRFInfo& info) const
+void ActionFFRecord::write(ByteWriter& os, const GRFInfo& info) const
 {
     ActionRecord::write(os, info);
 
     write_uint8(os, uint8_t(m_filename.length()));
     write_string(os, m_filename);
 
-    os.write((char*)&m_binary[0], m_binary.size());
+    os.write_bytes(m_binary.data(), m_binary.size());
 }  
 
 
@@ -94,6 +94,7 @@ void ActionFFRecord::write_binary_file(const std::string& binary_dir) const
 
     const std::string file_path = binary_path.make_preferred().string();
     std::cout << "Writing binary file: " << file_path << "..." << std::endl;
+    ConversionCache::cache().add_output(file_path);
 
     std::ofstream os(binary_path, std::ios::binary);
     os.write((char*)&m_binary[0], m_binary.size());
@@ -112,6 +113,7 @@ void ActionFFRecord::read_binary_file(const std::string& binary_dir)
     } 
 
     std::cout << "Reading binary file: " << file_path << "..." << std::endl;
+    ConversionCache::cache().add_input(file_path);
     std::ifstream is(file_path, std::ios::binary);    
     while(is.peek() != EOF)
     {
@@ -61,7 +61,7 @@ const EnumDescriptorT<Rotation> desc_rotation
 
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
-void AirportTile::read(std::istream& is)
+void AirportTile::read(ByteReader& is)
 {
     x_off = read_uint8(is);
     y_off = read_uint8(is);
@@ -87,7 +87,7 @@ void AirportTile::read(std::istream& is)
 }
 
 
-void AirportTile::write(std::ostream& os) const
+void AirportTile::write(ByteWriter& os) const
 {
     write_uint8(os, x_off);
     write_uint8(os, y_off);
@@ -160,7 +160,7 @@ void AirportTile::parse(TokenStream& is)
 // The layout consists of a single byte giving the rotation of the layout
 // (0: north, 2 : east, 4 : south, 6 : west) followed by a list of the above tile 
 // definitions, terminated by two bytes : 0, 80h 
-void AirportLayout::read(std::istream& is)
+void AirportLayout::read(ByteReader& is)
 {
     rotation = static_cast<Rotation>(read_uint8(is));
 
@@ -175,7 +175,7 @@ void AirportLayout::read(std::istream& is)
 }
 
 
-void AirportLayout::write(std::ostream& os) const
+void AirportLayout::write(ByteWriter& os) const
 {
     write_uint8(os, static_cast<uint8_t>(rotation));
 
@@ -224,7 +224,7 @@ void AirportLayout::parse(TokenStream& is)
 
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
-void AirportLayouts::read(std::istream& is)
+void AirportLayouts::read(ByteReader& is)
 {
     uint8_t num_layouts = read_uint8(is);
 
@@ -239,22 +239,18 @@ void AirportLayouts::read(std::istream& is)
 }
 
 
-void AirportLayouts::write(std::ostream& os) const
+void AirportLayouts::write(ByteWriter& os) const
 {
     write_uint8(os, uint8_t(layouts.size()));
 
-    // Size needs to be calculated... 
-    std::ostringstream ss;
-    for (const auto& layout: layouts)
-    {
-        layout.write(ss);
-    }
-    write_uint32(os, uint32_t(ss.str().length()));
-    
+    // The size is filled in once the layouts have been written.
+    size_t size_pos = os.reserve_uint32();
+    size_t start    = os.position();
     for (const auto& layout: layouts)
     {
         layout.write(os);
     }
+    os.patch_uint32(size_pos, uint32_t(os.position() - start));
 }
 
 
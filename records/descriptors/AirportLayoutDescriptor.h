@@ -30,8 +30,8 @@ struct AirportTile
     uint16_t tile;
     Type     type;
 
-    void read(std::istream& is);
-    void write(std::ostream& os) const;
+    void read(ByteReader& is);
+    void write(ByteWriter& os) const;
     void print(std::ostream& os, uint16_t indent) const;
     void parse(TokenStream& is);
 };
@@ -44,8 +44,8 @@ struct AirportLayout
     Rotation rotation;
     std::vector<AirportTile> tiles;
 
-    void read(std::istream& is);
-    void write(std::ostream& os) const;
+    void read(ByteReader& is);
+    void write(ByteWriter& os) const;
     void print(std::ostream& os, uint16_t indent) const;
     void parse(TokenStream& is);
 };
@@ -55,8 +55,8 @@ struct AirportLayouts
 {
     std::vector<AirportLayout> layouts;
 
-    void read(std::istream& is);
-    void write(std::ostream& os) const;
+    void read(ByteReader& is);
+    void write(ByteWriter& os) const;
     void print(std::ostream& os, uint16_t indent) const;
     void parse(TokenStream& is);
 };
@@ -34,7 +34,7 @@ public:
         m_value = is.match_bool();
     }
 
-    void read(std::istream& is)
+    void read(ByteReader& is)
     {
         uint8_t value = read_uint8(is);
         if ((value != TRUE) && (value != FALSE))
@@ -45,7 +45,7 @@ public:
         m_value = (value == TRUE);
     }
 
-    void write(std::ostream& os) const
+    void write(ByteWriter& os) const
     {     
         uint8_t value = (m_value ? TRUE : FALSE);
         write_uint8(os, value);
@@ -20,14 +20,14 @@
 #include "StreamHelpers.h"
 
 
-void CargoAcceptance::read(std::istream& is)
+void CargoAcceptance::read(ByteReader& is)
 {
     m_cargo_type = read_uint8(is);
     m_acceptance = read_uint8(is);
 }
 
 
-void CargoAcceptance::write(std::ostream& os) const
+void CargoAcceptance::write(ByteWriter& os) const
 {
     write_uint8(os, m_cargo_type);
     write_uint8(os, m_acceptance);
@@ -25,8 +25,8 @@ class CargoAcceptance
 {
 public:
     // Binary serialisation
-    void read(std::istream& is);
-    void write(std::ostream& os) const;
+    void read(ByteReader& is);
+    void write(ByteWriter& os) const;
     // Text serialisation
     void print(std::ostream& os) const;
     void parse(TokenStream& is);
@@ -68,7 +68,7 @@ public:
         is.match(TokenType::CloseParen);
     }
 
-    void read(std::istream& is)
+    void read(ByteReader& is)
     {
         uint32_t days;
         if constexpr (std::is_same_v<uint16_t, T>)
@@ -84,7 +84,7 @@ public:
         from_days(days);
     }
 
-    void write(std::ostream& os) const
+    void write(ByteWriter& os) const
     {
         uint32_t days = to_days();
         if constexpr (std::is_same_v<uint16_t, T>)
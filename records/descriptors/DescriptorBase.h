@@ -86,7 +86,7 @@ public:
         is.match(TokenType::CloseBracket);
     }
 
-    void read(std::istream& is)
+    void read(ByteReader& is)
     {
         for (auto& value: m_values)
         {
@@ -94,7 +94,7 @@ public:
         }
     }
 
-    void write(std::ostream& os) const
+    void write(ByteWriter& os) const
     {        
         for (const auto& value: m_values)
         {
@@ -140,7 +140,7 @@ public:
         is.match(TokenType::CloseBracket);
     }
 
-    void read(std::istream& is)
+    void read(ByteReader& is)
     {
         uint8_t num_items = read_uint8(is);
         for (uint8_t i = 0; i < num_items; ++i)
@@ -151,7 +151,7 @@ public:
         }
     }
 
-    void write(std::ostream& os) const
+    void write(ByteWriter& os) const
     {        
         write_uint8(os, uint8_t(m_values.size()));
         for (const auto& value: m_values)
@@ -20,13 +20,13 @@
 #include "StreamHelpers.h"
 
 
-void GRFLabel::read(std::istream& is)
+void GRFLabel::read(ByteReader& is)
 {
     m_label = read_uint32(is);
 }
 
 
-void GRFLabel::write(std::ostream& os) const
+void GRFLabel::write(ByteWriter& os) const
 {
     write_uint32(os, m_label);
 }
@@ -31,8 +31,8 @@ public:
     explicit GRFLabel(uint32_t label = 0) : m_label{label} {}
 
     // Binary serialisation
-    void read(std::istream& is);
-    void write(std::ostream& os) const;
+    void read(ByteReader& is);
+    void write(ByteWriter& os) const;
     // Text serialisation
     void print(std::ostream& os) const; // Quoted version of to_string().
     void parse(TokenStream& is);
@@ -57,7 +57,7 @@ const std::map<std::string, uint16_t> g_indices =
 
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
-bool IndustryTile::read(std::istream& is)
+bool IndustryTile::read(ByteReader& is)
 {
     m_x_off = read_uint8(is);
     m_y_off = read_uint8(is);
@@ -85,7 +85,7 @@ bool IndustryTile::read(std::istream& is)
 }
 
 
-void IndustryTile::write(std::ostream& os) const
+void IndustryTile::write(ByteWriter& os) const
 {
     write_uint8(os, m_x_off);
     write_uint8(os, m_y_off);
@@ -155,7 +155,7 @@ void IndustryTile::parse(TokenStream& is)
 
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
-void IndustryLayout::read(std::istream& is)
+void IndustryLayout::read(ByteReader& is)
 {
     m_is_reference = (is.peek() == 0xFE);
     if (m_is_reference)
@@ -178,7 +178,7 @@ void IndustryLayout::read(std::istream& is)
 }
 
 
-void IndustryLayout::write(std::ostream& os) const
+void IndustryLayout::write(ByteWriter& os) const
 {
     if (m_is_reference)
     {
@@ -262,7 +262,7 @@ void IndustryLayout::parse(TokenStream& is)
 
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
-void IndustryLayouts::read(std::istream& is)
+void IndustryLayouts::read(ByteReader& is)
 {
     uint8_t num_layouts = read_uint8(is);
 
@@ -277,22 +277,18 @@ void IndustryLayouts::read(std::istream& is)
 }
 
 
-void IndustryLayouts::write(std::ostream& os) const
+void IndustryLayouts::write(ByteWriter& os) const
 {
     write_uint8(os, uint8_t(m_layouts.size()));
 
-    // Size needs to be calculated... 
-    std::ostringstream ss;
-    for (const auto& layout: m_layouts)
-    {
-        layout.write(ss);
-    }
-    write_uint32(os, uint32_t(ss.str().length()));
-    
+    // The size is filled in once the layouts have been written.
+    size_t size_pos = os.reserve_uint32();
+    size_t start    = os.position();
     for (const auto& layout: m_layouts)
     {
         layout.write(os);
     }
+    os.patch_uint32(size_pos, uint32_t(os.position() - start));
 }
 
 
@@ -27,8 +27,8 @@ public:
     enum class Type { OldTile, NewTile, Clearance };
 
 public:
-    bool read(std::istream& is);
-    void write(std::ostream& os) const;
+    bool read(ByteReader& is);
+    void write(ByteWriter& os) const;
     void print(std::ostream& os, uint16_t indent) const;
     void parse(TokenStream& is);
 
@@ -43,8 +43,8 @@ private:
 struct IndustryLayout
 {
 public:
-    void read(std::istream& is);
-    void write(std::ostream& os) const;
+    void read(ByteReader& is);
+    void write(ByteWriter& os) const;
     void print(std::ostream& os, uint16_t indent) const;
     void parse(TokenStream& is);
 
@@ -65,8 +65,8 @@ private:
 struct IndustryLayouts
 {
 public:
-    void read(std::istream& is);
-    void write(std::ostream& os) const;
+    void read(ByteReader& is);
+    void write(ByteWriter& os) const;
     void print(std::ostream& os, uint16_t indent) const;
     void parse(TokenStream& is);
 
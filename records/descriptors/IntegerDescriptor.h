@@ -132,12 +132,12 @@ public:
         m_value = is.match_uint<T>();
     }
 
-    void read(std::istream& is)
+    void read(ByteReader& is)
     {
         m_value = read_uint<T, EXT>(is);
     }
 
-    void write(std::ostream& os) const
+    void write(ByteWriter& os) const
     {        
         write_uint<T, EXT>(os, m_value);
     }
@@ -192,7 +192,7 @@ public:
         is.match(TokenType::CloseBracket);
     }
 
-    void read(std::istream& is)
+    void read(ByteReader& is)
     {
         for (auto& value: m_values)
         {
@@ -200,7 +200,7 @@ public:
         }
     }
 
-    void write(std::ostream& os) const
+    void write(ByteWriter& os) const
     {        
         for (const auto& value: m_values)
         {
@@ -255,7 +255,7 @@ public:
         is.match(TokenType::CloseBracket);
     }
 
-    void read(std::istream& is)
+    void read(ByteReader& is)
     {
         uint8_t num_items = read_uint8(is);
         for (uint8_t i = 0; i < num_items; ++i)
@@ -266,7 +266,7 @@ public:
         }
     }
 
-    void write(std::ostream& os) const
+    void write(ByteWriter& os) const
     {        
         write_uint8(os, uint8_t(m_values.size()));
         for (const auto& value: m_values)
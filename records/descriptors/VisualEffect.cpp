@@ -54,7 +54,7 @@ static constexpr const char* str_effect = "effect";
 } // namespace {
 
 
-void VisualEffect::read(std::istream& is)
+void VisualEffect::read(ByteReader& is)
 {
     uint8_t value = read_uint8(is);
     if (value & 0x40)
@@ -71,7 +71,7 @@ void VisualEffect::read(std::istream& is)
 }
 
 
-void VisualEffect::write(std::ostream& os) const
+void VisualEffect::write(ByteWriter& os) const
 {
     uint8_t value = m_position;
     value |= static_cast<uint8_t>(m_effect);
@@ -42,8 +42,8 @@ public:
     };
 
 public:    
-    void read(std::istream& is);
-    void write(std::ostream& os) const;
+    void read(ByteReader& is);
+    void write(ByteWriter& os) const;
     void print(std::ostream& os) const; 
     void parse(TokenStream& is);
 
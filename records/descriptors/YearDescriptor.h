@@ -52,7 +52,7 @@ public:
         }
     }
 
-    void read(std::istream& is)
+    void read(ByteReader& is)
     {
         // Read the binary in one of three formats.
         m_year = read_uint<T, false>(is);
@@ -62,7 +62,7 @@ public:
         }
     }
 
-    void write(std::ostream& os) const
+    void write(ByteWriter& os) const
     {        
         if constexpr (std::is_same_v<T, uint8_t>)
         {
@@ -56,7 +56,7 @@ constexpr UInt8Descriptor  desc_11 = { 0x11, str_animation_triggers,   UIntForma
 } // namespace {
 
 
-bool Action00AirportTiles::read_property(std::istream& is, uint8_t property)
+bool Action00AirportTiles::read_property(ByteReader& is, uint8_t property)
 {
     switch (property)
     {
@@ -79,7 +79,7 @@ bool Action00AirportTiles::read_property(std::istream& is, uint8_t property)
 }   
 
 
-bool Action00AirportTiles::write_property(std::ostream& os, uint8_t property) const
+bool Action00AirportTiles::write_property(ByteWriter& os, uint8_t property) const
 {
     switch (property)
     {
@@ -63,7 +63,7 @@ constexpr UInt16Descriptor              desc_11 = { 0x11, str_maintenance_cost_f
 } // namespace {
 
 
-bool Action00Airports::read_property(std::istream& is, uint8_t property)
+bool Action00Airports::read_property(ByteReader& is, uint8_t property)
 {
     switch (property)
     {
@@ -82,7 +82,7 @@ bool Action00Airports::read_property(std::istream& is, uint8_t property)
 }   
 
 
-bool Action00Airports::write_property(std::ostream& os, uint8_t property) const
+bool Action00Airports::write_property(ByteWriter& os, uint8_t property) const
 {
     switch (property)
     {
@@ -30,8 +30,8 @@ public:
     Action00Airports() : Action00Feature() {}
 
     // Binary serialisation
-    bool read_property(std::istream& is, uint8_t property) override;
-    bool write_property(std::ostream& os, uint8_t property) const override;
+    bool read_property(ByteReader& is, uint8_t property) override;
+    bool write_property(ByteWriter& os, uint8_t property) const override;
     // Text serialisation
     bool print_property(std::ostream& os, uint8_t property, uint16_t indent) const override;
     bool parse_property(TokenStream& is, const std::string& name, uint8_t& index) override;
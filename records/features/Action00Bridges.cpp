@@ -81,7 +81,7 @@ constexpr UInt16Descriptor           desc_13 = { 0x13, str_cost_factor_word,
 } // namespace {
 
 
-void BridgeTable::read(std::istream& is)
+void BridgeTable::read(ByteReader& is)
 {
     for (uint32_t& sprite: m_sprites)
     {
@@ -90,7 +90,7 @@ void BridgeTable::read(std::istream& is)
 }
 
 
-void BridgeTable::write(std::ostream& os) const
+void BridgeTable::write(ByteWriter& os) const
 {
     for (const uint32_t& sprite: m_sprites)
     {
@@ -138,7 +138,7 @@ void BridgeTable::parse(TokenStream& is)
 }
 
 
-void BridgeLayout::read(std::istream& is)
+void BridgeLayout::read(ByteReader& is)
 {
     m_first_table_id = read_uint8(is);
 
@@ -151,7 +151,7 @@ void BridgeLayout::read(std::istream& is)
 }
 
 
-void BridgeLayout::write(std::ostream& os) const
+void BridgeLayout::write(ByteWriter& os) const
 {
     write_uint8(os, m_first_table_id);
 
@@ -202,7 +202,7 @@ void BridgeLayout::parse(TokenStream& is)
 }
 
 
-bool Action00Bridges::read_property(std::istream& is, uint8_t property)
+bool Action00Bridges::read_property(ByteReader& is, uint8_t property)
 {
     switch (property)
     {
@@ -226,7 +226,7 @@ bool Action00Bridges::read_property(std::istream& is, uint8_t property)
 }   
 
 
-bool Action00Bridges::write_property(std::ostream& os, uint8_t property) const
+bool Action00Bridges::write_property(ByteWriter& os, uint8_t property) const
 {
     switch (property)
     {
@@ -28,8 +28,8 @@
 class BridgeTable
 {
 public:
-    void read(std::istream& is);
-    void write(std::ostream& os) const;
+    void read(ByteReader& is);
+    void write(ByteWriter& os) const;
     void print(std::ostream& os, uint16_t indent) const;
     void parse(TokenStream& is);
 
@@ -41,8 +41,8 @@ private:
 class BridgeLayout
 {
 public:    
-    void read(std::istream& is);
-    void write(std::ostream& os) const;
+    void read(ByteReader& is);
+    void write(ByteWriter& os) const;
     void print(std::ostream& os, uint16_t indent) const;
     void parse(TokenStream& is);
 
@@ -58,8 +58,8 @@ public:
     Action00Bridges() : Action00Feature() {}
 
     // Binary serialisation
-    bool read_property(std::istream& is, uint8_t property) override;
-    bool write_property(std::ostream& os, uint8_t property) const override;
+    bool read_property(ByteReader& is, uint8_t property) override;
+    bool write_property(ByteWriter& os, uint8_t property) const override;
     // Text serialisation
     bool print_property(std::ostream& os, uint8_t property, uint16_t indent) const override;
     bool parse_property(TokenStream& is, const std::string& name, uint8_t& index) override;
@@ -44,7 +44,7 @@ constexpr UInt8Descriptor  desc_09 = { 0x09, str_graphics_flags, UIntFormat::Hex
 } // namespace {
 
 
-bool Action00Canals::read_property(std::istream& is, uint8_t property)
+bool Action00Canals::read_property(ByteReader& is, uint8_t property)
 {
     switch (property)
     {
@@ -57,7 +57,7 @@ bool Action00Canals::read_property(std::istream& is, uint8_t property)
 }   
 
 
-bool Action00Canals::write_property(std::ostream& os, uint8_t property) const
+bool Action00Canals::write_property(ByteWriter& os, uint8_t property) const
 {
     switch (property)
     {
@@ -104,7 +104,7 @@ constexpr UInt16Descriptor    desc_1D = { 0x1D, str_capacity_multiplier,    UInt
 } // namespace {
 
 
-bool Action00Cargos::read_property(std::istream& is, uint8_t property)
+bool Action00Cargos::read_property(ByteReader& is, uint8_t property)
 {
     switch (property)
     {
@@ -137,7 +137,7 @@ bool Action00Cargos::read_property(std::istream& is, uint8_t property)
 }   
 
 
-bool Action00Cargos::write_property(std::ostream& os, uint8_t property) const
+bool Action00Cargos::write_property(ByteWriter& os, uint8_t property) const
 {
     switch (property)
     {
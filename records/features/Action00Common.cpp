@@ -57,7 +57,7 @@ constexpr UInt8Descriptor              desc_07 = { 0x07, str_loading_speed,
 } // namespace {
 
 
-bool Action00Common::read_property(std::istream& is, uint8_t property)
+bool Action00Common::read_property(ByteReader& is, uint8_t property)
 {
     switch (property)
     {
@@ -74,7 +74,7 @@ bool Action00Common::read_property(std::istream& is, uint8_t property)
 }   
 
     
-bool Action00Common::write_property(std::ostream& os, uint8_t property) const
+bool Action00Common::write_property(ByteWriter& os, uint8_t property) const
 {
     switch (property)
     {
@@ -84,7 +84,7 @@ constexpr UInt8Descriptor        desc_15  = { 0x15, str_plural_form,
 } // namespace {
 
 
-void SnowLine::read(std::istream& is)
+void SnowLine::read(ByteReader& is)
 {
     for (auto& value: m_snow_heights)
     {
@@ -93,7 +93,7 @@ void SnowLine::read(std::istream& is)
 }
 
 
-void SnowLine::write(std::ostream& os) const
+void SnowLine::write(ByteWriter& os) const
 {
     for (auto value : m_snow_heights)
     {
@@ -136,7 +136,7 @@ void SnowLine::parse(TokenStream& is)
 }
 
 
-void GenderCase::read(std::istream& is)
+void GenderCase::read(ByteReader& is)
 {
     while (is.peek() != 0x00)
     {
@@ -149,7 +149,7 @@ void GenderCase::read(std::istream& is)
 }
 
 
-void GenderCase::write(std::ostream& os) const
+void GenderCase::write(ByteWriter& os) const
 {
     for (const auto& item: m_items)
     {
@@ -191,7 +191,7 @@ void GenderCase::parse(TokenStream& is)
 }
 
 
-bool Action00GlobalSettings::read_property(std::istream& is, uint8_t property) 
+bool Action00GlobalSettings::read_property(ByteReader& is, uint8_t property) 
 {
     switch (property)
     {
@@ -216,7 +216,7 @@ bool Action00GlobalSettings::read_property(std::istream& is, uint8_t property)
 }   
 
 
-bool Action00GlobalSettings::write_property(std::ostream& os, uint8_t property) const
+bool Action00GlobalSettings::write_property(ByteWriter& os, uint8_t property) const
 {
     switch (property)
     {
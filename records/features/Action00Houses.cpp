@@ -124,7 +124,7 @@ constexpr CargoAcceptanceDescriptor    desc_23  = { 0x23, str_tile_acceptance_li
 } // namespace {
 
 
-bool Action00Houses::read_property(std::istream& is, uint8_t property)
+bool Action00Houses::read_property(ByteReader& is, uint8_t property)
 {
     switch (property)
     {
@@ -163,7 +163,7 @@ bool Action00Houses::read_property(std::istream& is, uint8_t property)
 }   
 
 
-bool Action00Houses::write_property(std::ostream& os, uint8_t property) const
+bool Action00Houses::write_property(ByteWriter& os, uint8_t property) const
 {
     switch (property)
     {
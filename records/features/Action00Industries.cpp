@@ -144,7 +144,7 @@ constexpr MultipliersDescriptor          desc_28  = { 0x28, str_input_cargo_mult
 } // namespace {
 
 
-void Multipliers::read(std::istream& is)
+void Multipliers::read(ByteReader& is)
 {
     m_num_inputs  = read_uint8(is);
     m_num_outputs = read_uint8(is);
@@ -156,7 +156,7 @@ void Multipliers::read(std::istream& is)
 }
 
 
-void Multipliers::write(std::ostream& os) const
+void Multipliers::write(ByteWriter& os) const
 {
     write_uint8(os, m_num_inputs);
     write_uint8(os, m_num_outputs);
@@ -216,7 +216,7 @@ void Multipliers::parse(TokenStream& is)
 }
 
 
-bool Action00Industries::read_property(std::istream& is, uint8_t property)
+bool Action00Industries::read_property(ByteReader& is, uint8_t property)
 {
     switch (property)
     {
@@ -260,7 +260,7 @@ bool Action00Industries::read_property(std::istream& is, uint8_t property)
 }   
 
 
-bool Action00Industries::write_property(std::ostream& os, uint8_t property) const
+bool Action00Industries::write_property(ByteWriter& os, uint8_t property) const
 {
     switch (property)
     {
@@ -74,7 +74,7 @@ constexpr CargoAcceptanceDescriptor  desc_13  = { 0x13, str_cargo_acceptance_lis
 } // namespace {
 
 
-bool Action00IndustryTiles::read_property(std::istream& is, uint8_t property)
+bool Action00IndustryTiles::read_property(ByteReader& is, uint8_t property)
 {
     switch (property)
     {
@@ -97,7 +97,7 @@ bool Action00IndustryTiles::read_property(std::istream& is, uint8_t property)
 }   
 
 
-bool Action00IndustryTiles::write_property(std::ostream& os, uint8_t property) const
+bool Action00IndustryTiles::write_property(ByteWriter& os, uint8_t property) const
 {
     switch (property)
     {
@@ -94,7 +94,7 @@ constexpr UInt8Descriptor             desc_18  = { 0x18, str_number_on_creation,
 } // namespace {
 
 
-bool Action00Objects::read_property(std::istream& is, uint8_t property)
+bool Action00Objects::read_property(ByteReader& is, uint8_t property)
 {
     switch (property)
     {
@@ -122,7 +122,7 @@ bool Action00Objects::read_property(std::istream& is, uint8_t property)
 }   
 
 
-bool Action00Objects::write_property(std::ostream& os, uint8_t property) const
+bool Action00Objects::write_property(ByteWriter& os, uint8_t property) const
 {
     switch (property)
     {
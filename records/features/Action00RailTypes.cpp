@@ -104,7 +104,7 @@ constexpr GRFLabelListDescriptor desc_1D = { 0x1D, str_alternate_railtypes };
 } // namespace {
 
 
-bool Action00RailTypes::read_property(std::istream& is, uint8_t property)
+bool Action00RailTypes::read_property(ByteReader& is, uint8_t property)
 {
     switch (property)
     {
@@ -137,7 +137,7 @@ bool Action00RailTypes::read_property(std::istream& is, uint8_t property)
 }   
 
 
-bool Action00RailTypes::write_property(std::ostream& os, uint8_t property) const
+bool Action00RailTypes::write_property(ByteWriter& os, uint8_t property) const
 {
     switch (property)
     {
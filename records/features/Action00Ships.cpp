@@ -107,7 +107,7 @@ constexpr CargoListDescriptor    desc_1F  = { 0x1F, str_never_refittable_cargos
 } // namespace {
 
 
-bool Action00Ships::read_property(std::istream& is, uint8_t property)
+bool Action00Ships::read_property(ByteReader& is, uint8_t property)
 {
     if (Action00Common::read_property(is, property))
     {
@@ -146,7 +146,7 @@ bool Action00Ships::read_property(std::istream& is, uint8_t property)
 }   
 
 
-bool Action00Ships::write_property(std::ostream& os, uint8_t property) const
+bool Action00Ships::write_property(ByteWriter& os, uint8_t property) const
 {
     if (Action00Common::write_property(os, property))
     {
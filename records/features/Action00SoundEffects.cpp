@@ -47,7 +47,7 @@ constexpr UInt8Descriptor desc_0A = { 0x0A, str_override_old_sound, UIntFormat::
 } // namespace {
 
 
-bool Action00SoundEffects::read_property(std::istream& is, uint8_t property)
+bool Action00SoundEffects::read_property(ByteReader& is, uint8_t property)
 {
     switch (property)
     {
@@ -61,7 +61,7 @@ bool Action00SoundEffects::read_property(std::istream& is, uint8_t property)
 }   
 
 
-bool Action00SoundEffects::write_property(std::ostream& os, uint8_t property) const
+bool Action00SoundEffects::write_property(ByteWriter& os, uint8_t property) const
 {
     switch (property)
     {
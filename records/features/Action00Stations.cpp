@@ -122,7 +122,7 @@ const EnumDescriptorT<CustomLayout::Direction> direction_desc =
 
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
-void StationTileData::read(std::istream& is)
+void StationTileData::read(ByteReader& is)
 {
     m_x_off  = read_uint8(is);
     m_y_off  = read_uint8(is);
@@ -136,7 +136,7 @@ void StationTileData::read(std::istream& is)
 }
 
 
-void StationTileData::write(std::ostream& os) const
+void StationTileData::write(ByteWriter& os) const
 {
     write_uint8(os, m_x_off);
     write_uint8(os, m_y_off);
@@ -206,7 +206,7 @@ void StationTileData::parse(TokenStream& is)
 
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
-void StationTile::read(std::istream& is)
+void StationTile::read(ByteReader& is)
 {
     m_ground_sprite = read_uint32(is);
     if (m_ground_sprite == 0x00000000)
@@ -224,7 +224,7 @@ void StationTile::read(std::istream& is)
 }
 
 
-void StationTile::write(std::ostream& os) const
+void StationTile::write(ByteWriter& os) const
 {
     write_uint32(os, m_ground_sprite);
     if (m_ground_sprite == 0x00000000)
@@ -279,7 +279,7 @@ void StationTile::parse(TokenStream& is)
 
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
-void StationLayout::read(std::istream& is)
+void StationLayout::read(ByteReader& is)
 {
     uint16_t num_tiles = read_uint8_ext(is);
     m_tiles.resize(num_tiles);
@@ -290,7 +290,7 @@ void StationLayout::read(std::istream& is)
 }
 
 
-void StationLayout::write(std::ostream& os) const
+void StationLayout::write(ByteWriter& os) const
 {
     write_uint8_ext(os, uint16_t(m_tiles.size()));
     for (const auto& tile: m_tiles)
@@ -327,7 +327,7 @@ void StationLayout::parse(TokenStream& is)
 
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
-void CustomLayout::read(std::istream& is)
+void CustomLayout::read(ByteReader& is)
 {
     m_platform_length = read_uint8(is);
     m_platform_count  = read_uint8(is);
@@ -349,7 +349,7 @@ void CustomLayout::read(std::istream& is)
 }
 
 
-void CustomLayout::write(std::ostream& os) const
+void CustomLayout::write(ByteWriter& os) const
 {
     write_uint8(os, m_platform_length);
     write_uint8(os, m_platform_count);
@@ -424,7 +424,7 @@ void CustomLayout::parse(TokenStream& is)
 
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
-void CustomStation::read(std::istream& is)
+void CustomStation::read(ByteReader& is)
 {
     while (true)
     {
@@ -439,7 +439,7 @@ void CustomStation::read(std::istream& is)
 }
 
 
-void CustomStation::write(std::ostream& os) const
+void CustomStation::write(ByteWriter& os) const
 {
     for (const auto& layout: m_layouts)
     {
@@ -478,7 +478,7 @@ void CustomStation::parse(TokenStream& is)
 
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
-bool Action00Stations::read_property(std::istream& is, uint8_t property)
+bool Action00Stations::read_property(ByteReader& is, uint8_t property)
 {
     switch (property)
     {
@@ -506,7 +506,7 @@ bool Action00Stations::read_property(std::istream& is, uint8_t property)
 }   
 
 
-bool Action00Stations::write_property(std::ostream& os, uint8_t property) const
+bool Action00Stations::write_property(ByteWriter& os, uint8_t property) const
 {
     switch (property)
     {
@@ -26,8 +26,8 @@
 class StationTileData
 {
 public:
-    void read(std::istream& is);
-    void write(std::ostream& os) const;
+    void read(ByteReader& is);
+    void write(ByteWriter& os) const;
     void print(std::ostream& os, uint16_t indent) const;
     void parse(TokenStream& is);
 
@@ -46,8 +46,8 @@ private:
 class StationTile
 {
 public:
-    void read(std::istream& is);
-    void write(std::ostream& os) const;
+    void read(ByteReader& is);
+    void write(ByteWriter& os) const;
     void print(std::ostream& os, uint16_t indent) const;
     void parse(TokenStream& is);
 
@@ -60,8 +60,8 @@ private:
 class StationLayout
 {
 public:
-    void read(std::istream& is);
-    void write(std::ostream& os) const;
+    void read(ByteReader& is);
+    void write(ByteWriter& os) const;
     void print(std::ostream& os, uint16_t indent) const;
     void parse(TokenStream& is);
 
@@ -73,8 +73,8 @@ private:
 class CustomLayout
 {
 public:
-    void read(std::istream& is);
-    void write(std::ostream& os) const;
+    void read(ByteReader& is);
+    void write(ByteWriter& os) const;
     void print(std::ostream& os, uint16_t indent) const;
     void parse(TokenStream& is);
 
@@ -107,8 +107,8 @@ private:
 class CustomStation
 {
 public:
-    void read(std::istream& is);
-    void write(std::ostream& os) const;
+    void read(ByteReader& is);
+    void write(ByteWriter& os) const;
     void print(std::ostream& os, uint16_t indent) const;
     void parse(TokenStream& is);
 
@@ -123,8 +123,8 @@ public:
     Action00Stations() : Action00Feature() {}
 
     // Binary serialisation
-    bool read_property(std::istream& is, uint8_t property) override;
-    bool write_property(std::ostream& os, uint8_t property) const override;
+    bool read_property(ByteReader& is, uint8_t property) override;
+    bool write_property(ByteWriter& os, uint8_t property) const override;
     // Text serialisation
     bool print_property(std::ostream& os, uint8_t property, uint16_t indent) const override;
     bool parse_property(TokenStream& is, const std::string& name, uint8_t& index) override;
@@ -139,7 +139,7 @@ constexpr CargoListDescriptor     desc_2D  = { 0x2D, str_never_refittable_cargos
 } // namespace {
 
 
-bool Action00Trains::read_property(std::istream& is, uint8_t property)
+bool Action00Trains::read_property(ByteReader& is, uint8_t property)
 {
     if (Action00Common::read_property(is, property))
     {
@@ -189,7 +189,7 @@ bool Action00Trains::read_property(std::istream& is, uint8_t property)
 }   
 
 
-bool Action00Trains::write_property(std::ostream& os, uint8_t property) const
+bool Action00Trains::write_property(ByteWriter& os, uint8_t property) const
 {
     if (Action00Common::write_property(os, property))
     {
@@ -92,7 +92,7 @@ constexpr GRFLabelListDescriptor desc_1D = { 0x1D, str_alternate_tramtypes };
 } // namespace {
 
 
-bool Action00TramTypes::read_property(std::istream& is, uint8_t property)
+bool Action00TramTypes::read_property(ByteReader& is, uint8_t property)
 {
     switch (property)
     {
@@ -121,7 +121,7 @@ bool Action00TramTypes::read_property(std::istream& is, uint8_t property)
 }   
 
 
-bool Action00TramTypes::write_property(std::ostream& os, uint8_t property) const
+bool Action00TramTypes::write_property(ByteWriter& os, uint8_t property) const
 {
     switch (property)
     {
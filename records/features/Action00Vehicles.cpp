@@ -119,7 +119,7 @@ constexpr CargoListDescriptor    desc_25  = { 0x25, str_never_refittable_cargos
 } // namespace {
 
 
-bool Action00Vehicles::read_property(std::istream& is, uint8_t property)
+bool Action00Vehicles::read_property(ByteReader& is, uint8_t property)
 {
     if (Action00Common::read_property(is, property))
     {
@@ -162,7 +162,7 @@ bool Action00Vehicles::read_property(std::istream& is, uint8_t property)
 }   
 
 
-bool Action00Vehicles::write_property(std::ostream& os, uint8_t property) const
+bool Action00Vehicles::write_property(ByteWriter& os, uint8_t property) const
 {
     if (Action00Common::write_property(os, property))
     {
@@ -18,8 +18,24 @@
 ///////////////////////////////////////////////////////////////////////////////
 #include "ChunkEncoder.h"
 #include "RealSpriteRecord.h"
-#include "CommandLineOptions.h"
+#include "Exceptions.h"
+#include <algorithm>
+#include <cstring>
+#include "FileSystem.h"
 #include <exception>
+#include <fstream>
+#include <sstream>
+#include <tuple>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(_M_X64)
+    // SSE2 is always available on x86-64.
+    #define YAGL_CHUNK_SSE2 1
+    #include <emmintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #endif
+#endif
 
 
 // Each row is represented by a series of chunks which skip transparent sections.
@@ -29,11 +45,144 @@ static constexpr uint16_t SHORT_LAST_CHUNK = 0x0080;
 static constexpr uint16_t LONG_LAST_CHUNK  = 0x8000;
 
 
+namespace {
+
+
+// Number of bytes per pixel in the image data. The alpha channel (or the palette index for 
+// 8bpp images) tells us which pixels are transparent.
+uint16_t chunked_pixel_size(uint8_t compression, GRFFormat format)
+{
+    if (format == GRFFormat::Container1)
+    {
+        return 1;
+    }
+
+    // Is this format really supported? Have seen examples in 
+    // zbase-v5588/zbase_extra.grf. Makes no sense to me.
+    if ((compression & RealSpriteRecord::HAS_RGB) && 
+        (compression & RealSpriteRecord::HAS_ALPHA) && 
+        (compression & RealSpriteRecord::HAS_PALETTE))
+    {
+        return 5;
+    }
+    // Is it possible to have only RGB? Or are such images converted to 
+    // RGBA with all alpha fully opaque?
+    if ((compression & RealSpriteRecord::HAS_RGB) && 
+        (compression & RealSpriteRecord::HAS_ALPHA))
+    {
+        return 4;
+    }
+    if (compression & RealSpriteRecord::HAS_PALETTE)
+    {
+        return 1;
+    }
+
+    throw RUNTIME_ERROR("Chunked sprites must have an alpha channel or a palette");
+}
+
+
+// Chunk headers are words rather than bytes only for wide Container2 sprites. This is the 
+// same test that OpenTTD uses.
+bool has_long_chunks(uint16_t xdim, GRFFormat format)
+{
+    return (format == GRFFormat::Container2) && (xdim > 0x100);
+}
+
+
+// The row offsets are 32 bits rather than 16 bits only for large Container2 sprites.
+bool has_long_offsets(size_t chunked_size, GRFFormat format)
+{
+    return (format == GRFFormat::Container2) && (chunked_size > 0xFFFF);
+}
+
+
+// Calls func with the pixel size and chunk header width as compile time constants, so that 
+// the inner loops are specialised for each format. This is done once per sprite.
+template <typename Func>
+auto with_chunk_format(uint16_t pixel_size, bool long_chunks, Func&& func)
+{
+    using Short = std::false_type;
+    using Long  = std::true_type;
+    switch (pixel_size)
+    {
+        case 4:  return long_chunks ? func(std::integral_constant<uint16_t, 4>{}, Long{}) 
+                                    : func(std::integral_constant<uint16_t, 4>{}, Short{});
+        case 5:  return long_chunks ? func(std::integral_constant<uint16_t, 5>{}, Long{}) 
+                                    : func(std::integral_constant<uint16_t, 5>{}, Short{});
+        default: return long_chunks ? func(std::integral_constant<uint16_t, 1>{}, Long{}) 
+                                    : func(std::integral_constant<uint16_t, 1>{}, Short{});
+    }
+}
+
+
+uint32_t lowest_set_bit(uint64_t value)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return index;
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+
+// Sets bit x of mask (which must be zeroed) for each visible pixel in a row. Pixels are 
+// transparent if the byte at TRANS_OFFSET in each pixel is zero. With SSE2, 16 pixels are 
+// checked at a time for 8bpp and 32bpp images, and the rest one at a time.
+template <uint16_t PIXEL_SIZE, uint16_t TRANS_OFFSET>
+void find_visible_pixels(const uint8_t* row, uint16_t xdim, uint64_t* mask)
+{
+    uint32_t x = 0;
+#ifdef YAGL_CHUNK_SSE2
+    if constexpr ((PIXEL_SIZE == 1) || (PIXEL_SIZE == 4))
+    {
+        const __m128i zero = _mm_setzero_si128();
+        for (; (x + 16) <= xdim; x += 16)
+        {
+            __m128i trans;
+            if constexpr (PIXEL_SIZE == 1)
+            {
+                trans = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+            }
+            else
+            {
+                // Move the alpha of each pixel to the bottom of its 32 bit lane, and then 
+                // pack the lanes of four vectors down to one vector of bytes.
+                const __m128i* p = reinterpret_cast<const __m128i*>(row + x * 4);
+                __m128i a0 = _mm_srli_epi32(_mm_loadu_si128(p + 0), 24);
+                __m128i a1 = _mm_srli_epi32(_mm_loadu_si128(p + 1), 24);
+                __m128i a2 = _mm_srli_epi32(_mm_loadu_si128(p + 2), 24);
+                __m128i a3 = _mm_srli_epi32(_mm_loadu_si128(p + 3), 24);
+                trans = _mm_packus_epi16(_mm_packs_epi32(a0, a1), _mm_packs_epi32(a2, a3));
+            }
+
+            uint32_t visible = ~uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(trans, zero))) & 0xFFFF;
+            mask[x / 64] |= uint64_t(visible) << (x % 64);
+        }
+    }
+#endif
+
+    for (; x < xdim; ++x)
+    {
+        if (row[x * PIXEL_SIZE + TRANS_OFFSET] != 0x00)
+        {
+            mask[x / 64] |= uint64_t(1) << (x % 64);
+        }
+    }
+}
+
+
+template <uint16_t PIXEL_SIZE, bool LONG_CHUNKS>
 class ChunkEncoder
 {
 public:
-    ChunkEncoder(const std::vector<uint8_t>& pixels, uint16_t xdim, uint16_t ydim, 
-        uint8_t compression, GRFFormat format);
+    // The byte in each pixel which is zero for transparent pixels: alpha or palette index.
+    static constexpr uint16_t TRANS_OFFSET = (PIXEL_SIZE == 1) ? 0 : 3;
+    static constexpr uint16_t LAST_CHUNK   = LONG_CHUNKS ? LONG_LAST_CHUNK : SHORT_LAST_CHUNK;
+
+public:
+    ChunkEncoder(const std::vector<uint8_t>& pixels, uint16_t xdim, uint16_t ydim, GRFFormat format, uint8_t chunk_gap);
     std::vector<uint8_t> encode(); 
 
 private:
@@ -46,7 +195,7 @@ private:
 private:
     std::vector<uint16_t> find_row_edges(uint16_t y); // y indicates the current row.
     std::vector<Chunk> find_row_chunks(const std::vector<uint16_t>& edges);
-    std::vector<uint8_t> make_row_data(const std::vector<Chunk>& chunks, uint16_t y);
+    void append_row_data(const std::vector<Chunk>& chunks, uint16_t y, std::vector<uint8_t>& data);
 
 private:
     const std::vector<uint8_t>& m_pixels;
@@ -54,140 +203,97 @@ private:
     uint16_t  m_xdim;
     uint16_t  m_ydim;
     GRFFormat m_format;
-    
-    uint16_t  m_pixel_size   = 0; 
-    uint16_t  m_trans_offset = 0;
-    uint16_t  m_last_chunk   = 0;
-};
-
+    uint8_t   m_chunk_gap;
 
-std::vector<uint8_t> encode_tile(const std::vector<uint8_t>& pixels, uint16_t xdim, uint16_t ydim, 
-    uint8_t compression, GRFFormat format)
-{
-    ChunkEncoder encoder(pixels, xdim, ydim, compression, format);
-    return encoder.encode(); 
-}
+    // One bit per pixel in the current row, set for visible pixels.
+    std::vector<uint64_t> m_visible;
+};
 
 
-std::vector<uint8_t> decode_tile(const std::vector<uint8_t>& chunks, uint16_t xdim, uint16_t ydim, 
-    uint8_t compression, GRFFormat format)
+template <uint16_t PIXEL_SIZE, bool LONG_CHUNKS>
+std::vector<uint8_t> decode_chunks(const std::vector<uint8_t>& chunks, uint16_t xdim, uint16_t ydim, bool long_offset)
 {
-    const uint16_t LAST_CHUNK = (xdim > 0x100) ? LONG_LAST_CHUNK : SHORT_LAST_CHUNK;
+    constexpr uint32_t HEADER_SIZE = LONG_CHUNKS ? 4 : 2;
+    constexpr uint16_t LAST_CHUNK  = LONG_CHUNKS ? LONG_LAST_CHUNK : SHORT_LAST_CHUNK;
 
-    bool     long_offset  = chunks.size() > 0x10000;
-    uint16_t pixel_size   = 0; 
-    uint16_t trans_offset = 0;
+    const uint8_t* data = chunks.data();
+    const uint32_t size = uint32_t(chunks.size());
+    if (size < (ydim * (long_offset ? 4U : 2U)))
+    {
+        throw RUNTIME_ERROR("Chunked sprite data is too short for its row offsets");
+    }
 
-    // Interpret the compression information
-    if (format == GRFFormat::Container2)
+    // Offset of the first chunk for a row. The end of the last row is the end of the data.
+    auto row_offset = [&](uint16_t y) -> uint32_t
     {
-        // Is this format really supported? Have seen examples in 
-        // zbase-v5588/zbase_extra.grf. Makes no sense to me.
-        if ((compression & RealSpriteRecord::HAS_RGB) && 
-            (compression & RealSpriteRecord::HAS_ALPHA) && 
-            (compression & RealSpriteRecord::HAS_PALETTE))
+        if (y == ydim)
         {
-            pixel_size   = 5;
-            trans_offset = 3;
+            return size;
         }
-        // Is it possible to have only RGB? Or are such images converted to 
-        // RGBA with all alpha fully opaque?
-        else if ((compression & RealSpriteRecord::HAS_RGB) && 
-                 (compression & RealSpriteRecord::HAS_ALPHA))
-        {
-            pixel_size   = 4;
-            trans_offset = 3;
-        }
-        else if (compression & RealSpriteRecord::HAS_PALETTE)
-        {
-            pixel_size   = 1;
-            trans_offset = 0;
-        }
-    }
-    else
-    {
-        pixel_size   = 1;
-        trans_offset = 0;
-    }
-    
-    // Create a array of the lengths for the chunk data in each row. We care about this to more 
-    // clearly work out which rows are empty and which are not. It seems that the length of the 
-    // first chunk cannot be entirely trusted in the case of zero or full width chunks.
-    std::vector<uint32_t> offsets;
-    for (uint16_t y = 0; y < ydim; ++y)
-    {
-        // Index of the row offset in the chunked data's index array. 
-        uint32_t index = y * (long_offset ? sizeof(uint32_t) : sizeof(uint16_t));
-        // Offset of the first chunk for the current row.
-        uint32_t offset = chunks[index++];
-        offset |= (chunks[index++] << 8);
         if (long_offset)
         {
-            offset |= (chunks[index++] << 16);
-            offset |= (chunks[index++] << 24);
+            const uint8_t* p = data + y * 4;
+            return p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24);
         }
-
-        offsets.push_back(offset);
-    }
-    offsets.push_back(static_cast<uint32_t>(chunks.size()));
+        const uint8_t* p = data + y * 2;
+        return p[0] | (p[1] << 8);
+    };
 
     // This will contain the decompressed image.
     // Make sure it is all initialised to zeroes.
-    std::vector<uint8_t>  output(xdim * ydim * pixel_size, 0);
+    std::vector<uint8_t> output(size_t(xdim) * ydim * PIXEL_SIZE, 0);
 
+    uint32_t next = row_offset(0);
     for (uint16_t y = 0; y < ydim; ++y)
     {
-        // Skips empty rows. These are indicated by rows whose length are the size of one null chunk.
+        uint32_t offset = next;
+        next = row_offset(y + 1);
+
+        // Skips empty rows. These are indicated by rows whose length is the size of one null chunk.
         // An empty row contains a single chunk header (byte/word cinfo and byte/word cofs), but no 
         // further bytes. cinfo should have length zero in this case, but this doesn't seem entirely 
-        // reliable.
-        uint32_t offset = offsets[y];
-        if ((offsets[y+1] - offset) == (long_offset ? sizeof(uint32_t) : sizeof(uint16_t)))
+        // reliable: dutchtrains.grf seems to have a length of xdim instead.
+        if ((next - offset) == HEADER_SIZE)
         {
             continue;
         }
 
-        // Now read out the data for each chunk.
-        uint32_t chunk_len;
-        uint32_t chunk_off;
-        bool     is_last_chunk;
+        // Now read out the data for each chunk. Each chunk is checked and then copied in one go.
+        bool is_last_chunk;
         do
         {
-            // Access the chunks for the current row.
-            // Length of the current chunk, and the flag for last chunk.
-            chunk_len = chunks[offset++];
-            if (LAST_CHUNK == LONG_LAST_CHUNK)
+            if ((offset + HEADER_SIZE) > size)
             {
-                chunk_len |= (chunks[offset++] << 8);
+                throw RUNTIME_ERROR("Chunked sprite data ends in a chunk header");
             }
-            is_last_chunk  = (chunk_len >= LAST_CHUNK);
-            chunk_len     &= ~LAST_CHUNK;
 
-            // Row offset for the current chunk.
-            chunk_off = chunks[offset++];
-            if (LAST_CHUNK == LONG_LAST_CHUNK)
+            // Length of the current chunk, with the flag for last chunk, followed by the 
+            // row offset for the current chunk.
+            uint32_t chunk_len;
+            uint32_t chunk_off;
+            if constexpr (LONG_CHUNKS)
+            {
+                chunk_len = data[offset] | (data[offset + 1] << 8);
+                chunk_off = data[offset + 2] | (data[offset + 3] << 8);
+            }
+            else
             {
-                chunk_off |= (chunks[offset++] << 8);
+                chunk_len = data[offset];
+                chunk_off = data[offset + 1];
             }
+            offset += HEADER_SIZE;
+
+            is_last_chunk  = (chunk_len & LAST_CHUNK) != 0;
+            chunk_len     &= ~LAST_CHUNK;
 
-            // Empty rows still in chunked data. This supposed to be with a length of zero and 
-            // the last chunk bit set. dutchtrains.grf seems to have a length of xdim instead. I
-            // have used % to get rid of this. Linux builds were fine, but this caused an exception
-            // on Windows (correctly). 
-            //if (is_last_chunk && (chunk_len == 0)) 
-            //{
-            //    break;
-            //}
-
-            uint32_t imax  = (chunk_len & ~LAST_CHUNK) * pixel_size;
-            uint32_t pixel = (y * xdim + chunk_off) * pixel_size;
-            for (uint16_t i = 0; i < imax ; ++i) 
-            { 
-                uint8_t pix = chunks[offset];
-                output[pixel] = pix;
-                ++pixel;
-                ++offset;
+            uint32_t chunk_bytes = chunk_len * PIXEL_SIZE;
+            if (((chunk_off + chunk_len) > xdim) || ((offset + chunk_bytes) > size))
+            {
+                throw RUNTIME_ERROR("Chunked sprite data has a chunk outside the image");
             }
+
+            std::memcpy(output.data() + (size_t(y) * xdim + chunk_off) * PIXEL_SIZE, data + offset, chunk_bytes);
+            offset += chunk_bytes;
         }
         // High bit means this is the last chunk for the current row.
         while (!is_last_chunk);
@@ -197,49 +303,49 @@ std::vector<uint8_t> decode_tile(const std::vector<uint8_t>& chunks, uint16_t xd
 }
 
 
-ChunkEncoder::ChunkEncoder(const std::vector<uint8_t>& pixels, uint16_t xdim, uint16_t ydim, uint8_t compression, GRFFormat format)
+} // namespace {
+
+
+std::vector<uint8_t> encode_tile(const std::vector<uint8_t>& pixels, uint16_t xdim, uint16_t ydim, 
+    uint8_t compression, GRFFormat format, uint8_t chunk_gap)
+{
+    uint16_t pixel_size = chunked_pixel_size(compression, format);
+    return with_chunk_format(pixel_size, has_long_chunks(xdim, format), [&](auto size, auto long_chunks)
+    {
+        ChunkEncoder<decltype(size)::value, decltype(long_chunks)::value> encoder(pixels, xdim, ydim, format, chunk_gap);
+        return encoder.encode(); 
+    });
+}
+
+
+std::vector<uint8_t> decode_tile(const std::vector<uint8_t>& chunks, uint16_t xdim, uint16_t ydim, 
+    uint8_t compression, GRFFormat format)
+{
+    uint16_t pixel_size  = chunked_pixel_size(compression, format);
+    bool     long_offset = has_long_offsets(chunks.size(), format);
+    return with_chunk_format(pixel_size, has_long_chunks(xdim, format), [&](auto size, auto long_chunks)
+    {
+        return decode_chunks<decltype(size)::value, decltype(long_chunks)::value>(chunks, xdim, ydim, long_offset);
+    });
+}
+
+
+template <uint16_t PIXEL_SIZE, bool LONG_CHUNKS>
+ChunkEncoder<PIXEL_SIZE, LONG_CHUNKS>::ChunkEncoder(const std::vector<uint8_t>& pixels, uint16_t xdim, uint16_t ydim, GRFFormat format, uint8_t chunk_gap)
 : m_pixels{pixels}
 , m_xdim{xdim}
 , m_ydim{ydim}
 , m_format{format}
+, m_chunk_gap{chunk_gap}
 {
-    // Interpret the compression information
-    if (format == GRFFormat::Container2)
+    if (m_pixels.size() < (size_t(m_xdim) * m_ydim * PIXEL_SIZE))
     {
-        // Is this format really supported? Have seen examples in 
-        // zbase-v5588/zbase_extra.grf. Makes no sense to me.
-        if ((compression & RealSpriteRecord::HAS_RGB) && 
-            (compression & RealSpriteRecord::HAS_ALPHA) && 
-            (compression & RealSpriteRecord::HAS_PALETTE))
-        {
-            m_pixel_size   = 5;
-            m_trans_offset = 3;
-        }
-        // Is it possible to have only RGB? Or are such images converted to 
-        // RGBA with all alpha fully opaque?
-        else if ((compression & RealSpriteRecord::HAS_RGB) && 
-                 (compression & RealSpriteRecord::HAS_ALPHA))
-        {
-            m_pixel_size   = 4;
-            m_trans_offset = 3;
-        }
-        else if (compression & RealSpriteRecord::HAS_PALETTE)
-        {
-            m_pixel_size   = 1;
-            m_trans_offset = 0;
-        }
+        throw RUNTIME_ERROR("Sprite has fewer pixels than its dimensions require");
     }
-    else
-    {
-        m_pixel_size   = 1;
-        m_trans_offset = 0;
-    }
-
-    m_last_chunk = (m_xdim > 0x100) ? LONG_LAST_CHUNK : SHORT_LAST_CHUNK;
 }
 
 
-static std::vector<uint16_t> trim_row_edges(const std::vector<uint16_t>& edges)
+static std::vector<uint16_t> trim_row_edges(const std::vector<uint16_t>& edges, uint8_t chunk_gap)
 {
     std::vector<uint16_t> trim;
 
@@ -250,7 +356,7 @@ static std::vector<uint16_t> trim_row_edges(const std::vector<uint16_t>& edges)
     {
         uint16_t beg2 = *it++;
         uint16_t end2 = *it++;
-        if ((beg2 - end1) >= CommandLineOptions::options().chunk_gap())
+        if ((beg2 - end1) >= chunk_gap)
         {
             trim.push_back(beg1);
             trim.push_back(end1);
@@ -270,43 +376,34 @@ static std::vector<uint16_t> trim_row_edges(const std::vector<uint16_t>& edges)
 }
 
 
-std::vector<uint16_t> ChunkEncoder::find_row_edges(uint16_t y)
+template <uint16_t PIXEL_SIZE, bool LONG_CHUNKS>
+std::vector<uint16_t> ChunkEncoder<PIXEL_SIZE, LONG_CHUNKS>::find_row_edges(uint16_t y)
 {
     // Scan a single row of the image data to find edges where pixels transition from 
     // transparent to visible, and vice versa.
     std::vector<uint16_t> edges;
 
-    // Index of the first pixel in the current row.
-    uint32_t byte_index = y * m_xdim * m_pixel_size + m_trans_offset;
+    const uint8_t* row = m_pixels.data() + size_t(y) * m_xdim * PIXEL_SIZE;
+    m_visible.assign((m_xdim + 63) / 64, 0);
+    find_visible_pixels<PIXEL_SIZE, TRANS_OFFSET>(row, m_xdim, m_visible.data());
 
-    // Scan through the row to find all the edges.
-    uint16_t x = 0;
-    while (x < m_xdim)
+    // The edges are where a bit differs from the one before it. The row starts off 
+    // transparent. Bits past the end of the row are clear, so a visible last pixel may 
+    // give an edge at m_xdim, as it would be added below anyway.
+    uint64_t previous = 0;
+    for (size_t word = 0; word < m_visible.size(); ++word)
     {
-        // Scan through the line to find a visible pixel.
-        for (; x < m_xdim; ++x)
-        {
-            if (m_pixels[byte_index] == 0x00)
-            {
-                byte_index += m_pixel_size;
-                continue;
-            }
-            edges.push_back(x);
-            break;
-        }
+        uint64_t bits    = m_visible[word];
+        uint64_t changes = bits ^ ((bits << 1) | previous);
+        previous = bits >> 63;
 
-        // Scan through the line to find a transparent pixel.
-        for (; x < m_xdim; ++x)
+        while (changes != 0)
         {
-            if (m_pixels[byte_index] != 0x00)
-            {
-                byte_index += m_pixel_size;
-                continue;
-            }
-            edges.push_back(x);
-            break;
+            edges.push_back(uint16_t(word * 64 + lowest_set_bit(changes)));
+            changes &= changes - 1;
         }
     }
+
     // Ensure that we have pairs of edges. Each pair represents a 
     // chunk in the row. We will combine chunks with only small gaps.
     if ((edges.size() % 2) == 1)
@@ -317,13 +414,14 @@ std::vector<uint16_t> ChunkEncoder::find_row_edges(uint16_t y)
     // Trim out any non-visible gaps that are really short.
     if (edges.size() > 2)
     {
-        return trim_row_edges(edges);
+        return trim_row_edges(edges, m_chunk_gap);
     }
     return edges;
 }
 
 
-std::vector<ChunkEncoder::Chunk> ChunkEncoder::find_row_chunks(const std::vector<uint16_t>& edges)
+template <uint16_t PIXEL_SIZE, bool LONG_CHUNKS>
+auto ChunkEncoder<PIXEL_SIZE, LONG_CHUNKS>::find_row_chunks(const std::vector<uint16_t>& edges) -> std::vector<Chunk>
 {
     // Create a collection of chunks for the current row.
     std::vector<Chunk> chunks; 
@@ -332,14 +430,14 @@ std::vector<ChunkEncoder::Chunk> ChunkEncoder::find_row_chunks(const std::vector
     while (it != edges.end())
     {
         // Start and end of a chunk. Need to divide into 
-        // two or more if the length is greater than m_last_chunk.
+        // two or more if the length is greater than LAST_CHUNK.
         uint16_t beg = *it++;
         uint16_t end = *it++;
         do 
         {
             Chunk chunk;
             chunk.offset = beg;
-            chunk.length = std::min<uint16_t>(end - beg, m_last_chunk - 1); 
+            chunk.length = std::min<uint16_t>(end - beg, LAST_CHUNK - 1); 
             chunks.push_back(chunk);
 
             beg += chunk.length; 
@@ -349,89 +447,95 @@ std::vector<ChunkEncoder::Chunk> ChunkEncoder::find_row_chunks(const std::vector
 
     if (chunks.size() > 0)
     {
-        chunks.back().length |= m_last_chunk;
+        chunks.back().length |= LAST_CHUNK;
     }
 
     return chunks;
 }
 
 
-std::vector<uint8_t> ChunkEncoder::make_row_data(const std::vector<ChunkEncoder::Chunk>& chunks, uint16_t y)
+template <uint16_t PIXEL_SIZE, bool LONG_CHUNKS>
+void ChunkEncoder<PIXEL_SIZE, LONG_CHUNKS>::append_row_data(const std::vector<Chunk>& chunks, uint16_t y, std::vector<uint8_t>& data)
 {
-    // Created the chunked data for a single row. 
-    std::vector<uint8_t> data;
+    // Append the chunked data for a single row. 
     if (chunks.size() > 0)
     {
         for (const auto& chunk: chunks)
         {
-            // Store the length in pixels of the chunk. This may be in short or long format.
-            data.push_back(chunk.length & 0xFF);
-            if (m_last_chunk == LONG_LAST_CHUNK)
+            // Store the length in pixels of the chunk, and then the offset in pixels from 
+            // the start of the row. These may be in short or long format.
+            if constexpr (LONG_CHUNKS)
             {
+                data.push_back(chunk.length & 0xFF);
                 data.push_back(chunk.length >> 8);
-            }
-
-            // Store the offset in pixels from the start of the row. This may be in short or long format.
-            data.push_back(chunk.offset & 0xFF);
-            if (m_last_chunk == LONG_LAST_CHUNK)
-            {
+                data.push_back(chunk.offset & 0xFF);
                 data.push_back(chunk.offset >> 8);
             }
-
-            // Store the data for the pixels in the chunk.
-            uint32_t offset = (y * m_xdim + chunk.offset) * m_pixel_size;  
-            uint16_t imax   = chunk.length & ~m_last_chunk;  
-            for (uint16_t i = 0; i < imax; ++i)
+            else
             {
-                for (uint8_t p = 0; p < m_pixel_size; ++p)
+                // Only Container1 sprites can be wide enough for this to fail.
+                if (chunk.offset > 0xFF)
                 {
-                    data.push_back(m_pixels[offset++]);
+                    throw RUNTIME_ERROR("Chunked Container1 sprites cannot be more than 256 pixels wide");
                 }
+                data.push_back(uint8_t(chunk.length));
+                data.push_back(uint8_t(chunk.offset));
             }
+
+            // Store the data for the pixels in the chunk.
+            const uint8_t* pixels = m_pixels.data() + (size_t(y) * m_xdim + chunk.offset) * PIXEL_SIZE;  
+            uint32_t       bytes  = (chunk.length & ~LAST_CHUNK) * PIXEL_SIZE;  
+            data.insert(data.end(), pixels, pixels + bytes);
         }
     }
     else
     {
-        // There are no chunks in this line of the image.
-        data.push_back(0x80);
-        data.push_back(0x00);
-        if (m_last_chunk == LONG_LAST_CHUNK)
+        // There are no chunks in this line of the image: a single empty chunk which 
+        // is marked as the last.
+        if constexpr (LONG_CHUNKS)
         {
+            data.push_back(LAST_CHUNK & 0xFF);
+            data.push_back(LAST_CHUNK >> 8);
+            data.push_back(0x00);
             data.push_back(0x00);
+        }
+        else
+        {
+            data.push_back(uint8_t(LAST_CHUNK));
             data.push_back(0x00);
         }
     }  
-
-    return data;
 }
 
 
-std::vector<uint8_t> ChunkEncoder::encode()
+template <uint16_t PIXEL_SIZE, bool LONG_CHUNKS>
+std::vector<uint8_t> ChunkEncoder<PIXEL_SIZE, LONG_CHUNKS>::encode()
 {
-    // Preliminaries: create chunked data for each row in the image.
-    uint32_t chunked_size = 0;
-    std::vector<std::vector<uint8_t>> chunked_rows;
-    for (uint32_t y = 0; y < m_ydim; ++y)
+    // Preliminaries: create chunked data for each row in the image, all in one buffer.
+    std::vector<uint8_t>  chunked_rows;
+    std::vector<uint32_t> row_starts(m_ydim);
+    for (uint16_t y = 0; y < m_ydim; ++y)
     {
         // Find edges in the row is a preliminary to finding visible chunks.
-        std::vector<uint16_t> edges       = find_row_edges(y);
-        std::vector<Chunk>    chunks      = find_row_chunks(edges);
-        std::vector<uint8_t>  chunked_row = make_row_data(chunks, y);       
-        chunked_size += uint32_t(chunked_row.size());
-        chunked_rows.push_back(chunked_row);
+        std::vector<uint16_t> edges  = find_row_edges(y);
+        std::vector<Chunk>    chunks = find_row_chunks(edges);
+        row_starts[y] = uint32_t(chunked_rows.size());
+        append_row_data(chunks, y, chunked_rows);
     }
 
-    bool long_offset = (chunked_size + (m_ydim * 2)) > 0x10000;
-    uint32_t offset  = m_ydim * (long_offset ? 4 : 2);
+    bool     long_offset = has_long_offsets(chunked_rows.size() + (m_ydim * 2), m_format);
+    uint32_t table_size  = m_ydim * (long_offset ? 4 : 2);
 
     // This is what we are going to return.
     std::vector<uint8_t> output;
+    output.reserve(table_size + chunked_rows.size());
 
     // First create an array of offsets for the chunked row data.
     // This may use a long or short format depending on the final 
     // length of the output.
-    for (const auto& chunked_row: chunked_rows)
+    for (uint32_t row_start: row_starts)
     {
+        uint32_t offset = table_size + row_start;
         output.push_back(offset & 0xFF);
         output.push_back((offset >> 8) & 0xFF);
         if (long_offset)
@@ -439,21 +543,104 @@ std::vector<uint8_t> ChunkEncoder::encode()
             output.push_back((offset >> 16) & 0xFF);
             output.push_back((offset >> 24) & 0xFF);
         }
-
-        offset += uint32_t(chunked_row.size());
     }
 
     // Then store the chunked data for each row. 
-    for (const auto& chunked_row: chunked_rows)
+    output.insert(output.end(), chunked_rows.begin(), chunked_rows.end());
+    return output;
+}
+
+
+bool ChunkGapTable::Key::operator<(const Key& other) const
+{
+    return std::tie(sprite_id, zoom, colour, pixels) < std::tie(other.sprite_id, other.zoom, other.colour, other.pixels);
+}
+
+
+ChunkGapTable& ChunkGapTable::table()
+{
+    static ChunkGapTable table;
+    return table;
+}
+
+
+void ChunkGapTable::load(const std::string& file_name)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_gaps.clear();
+    if (!fs::is_regular_file(file_name))
     {
-        for (const auto byte: chunked_row)
+        return;
+    }
+
+    std::ifstream is(file_name);
+    std::string   line;
+    while (std::getline(is, line))
+    {
+        if (line.empty() || (line[0] == '#'))
+        {
+            continue;
+        }
+
+        // Each line is: sprite_id zoom colour pixels gap. The pixels are given by a hash so 
+        // that a gap is not used for a sprite which has been edited since it was chosen. 
+        // Lines written by older versions have no hash, and are ignored.
+        std::istringstream ss(line);
+        std::string        field;
+        uint16_t           fields = 0;
+        while (ss >> field) 
         {
-            output.push_back(byte);
+            ++fields;
         }
+        if (fields == 4)
+        {
+            continue;
+        }
+
+        ss.clear();
+        ss.str(line);
+        uint32_t sprite_id, zoom, colour, gap;
+        uint64_t pixels;
+        if (!(ss >> sprite_id >> zoom >> colour >> std::hex >> pixels >> std::dec >> gap) || 
+            (zoom > 0xFF) || (colour > 0xFF) || (gap == 0) || (gap > 0xFF))
+        {
+            std::ostringstream os;
+            os << "Invalid line in chunk gaps file " << file_name << ": " << line;
+            throw RUNTIME_ERROR(os.str());
+        }
+        m_gaps[Key{sprite_id, uint8_t(zoom), uint8_t(colour), pixels}] = uint8_t(gap);
     }
+}
 
-    return output;
+
+void ChunkGapTable::save(const std::string& file_name) const
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    std::ofstream os(file_name);
+    if (os.fail())
+    {
+        throw RUNTIME_ERROR("Error opening file for writing: " + file_name);
+    }
+
+    os << "# Chunk gaps chosen by yagl --auto_chunk_gap: sprite_id zoom colour pixels gap\n";
+    for (const auto& [key, gap]: m_gaps)
+    {
+        os << key.sprite_id << ' ' << uint16_t(key.zoom) << ' ' << uint16_t(key.colour) << ' ';
+        os << std::hex << key.pixels << std::dec << ' ' << uint16_t(gap) << '\n';
+    }
+}
+
+
+uint8_t ChunkGapTable::gap(const Key& key, uint8_t default_gap) const
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    auto it = m_gaps.find(key);
+    return (it != m_gaps.end()) ? it->second : default_gap;
 }
 
 
-        
+void ChunkGapTable::set_gap(const Key& key, uint8_t gap)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_gaps[key] = gap;
+}
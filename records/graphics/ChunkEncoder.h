@@ -20,14 +20,51 @@
 #include "Record.h"
 #include <vector>
 #include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
 
 
 bool has_transparency(uint8_t compression, const GRFInfo& info);
 
+// Transparent gaps in a row shorter than chunk_gap pixels are included in the chunks 
+// either side of them, rather than splitting the row into more chunks.
 std::vector<uint8_t> encode_tile(const std::vector<uint8_t>& pixels, uint16_t xdim, uint16_t ydim, 
-    uint8_t compression, GRFFormat format);
+    uint8_t compression, GRFFormat format, uint8_t chunk_gap);
 
 std::vector<uint8_t> decode_tile(const std::vector<uint8_t>& chunks, uint16_t xdim, uint16_t ydim, 
     uint8_t compression, GRFFormat format);
 
 void encode_tile_test();
+
+
+// The chunk gap chosen for each chunked sprite by --auto_chunk_gap. This is saved next to 
+// the YAGL script so that later encodes use the same values without searching again. The 
+// key includes a hash of the pixels, so an edited sprite goes back to the default gap.
+class ChunkGapTable
+{
+public:
+    struct Key
+    {
+        uint32_t sprite_id;
+        uint8_t  zoom;
+        uint8_t  colour;
+        uint64_t pixels;   // PixelPool::hash() of the sprite's pixels.
+
+        bool operator<(const Key& other) const;
+    };
+
+public:
+    static ChunkGapTable& table();
+
+    void    load(const std::string& file_name);
+    void    save(const std::string& file_name) const;
+
+    // These are called while sprites are being encoded on several threads.
+    uint8_t gap(const Key& key, uint8_t default_gap) const;
+    void    set_gap(const Key& key, uint8_t gap);
+
+private:
+    std::map<Key, uint8_t> m_gaps;
+    mutable std::mutex     m_mutex;
+};
@@ -23,7 +23,7 @@
 static constexpr const char* str_null_sprite = "null_sprite";
 
 
-void FakeSpriteRecord::write(std::ostream& os, const GRFInfo& info) const
+void FakeSpriteRecord::write(ByteWriter& os, const GRFInfo& info) const
 {
     write_uint8(os, 0x00);
 }
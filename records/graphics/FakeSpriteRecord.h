@@ -29,7 +29,7 @@ public:
     using Record::Record;
     virtual ~FakeSpriteRecord() {}
 
-    void write(std::ostream& os, const GRFInfo& info) const;
+    void write(ByteWriter& os, const GRFInfo& info) const;
     void print(std::ostream& os, const SpriteZoomMap& sprites, uint16_t indent) const override;
     void parse(TokenStream& is, SpriteZoomMap& sprites) override;
 };
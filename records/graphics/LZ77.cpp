@@ -0,0 +1,388 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#include "LZ77.h"
+#include "MatchLength.h"
+#include "StreamHelpers.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <sstream>
+#include <deque>
+
+
+namespace {
+
+
+// Offsets are 11 bits, and a zero offset makes no sense.
+constexpr int32_t MAX_OFFSET   = (1 << 11) - 1;
+// Shorter matches are no smaller than literals. The format allows 16 byte matches, but
+// we stop at 15 as NML does.
+constexpr int32_t MIN_MATCH    = 3;
+constexpr int32_t MAX_MATCH    = 15;
+constexpr int32_t MAX_LITERALS = 0x80;
+
+// Hash chains are indexed by the first three bytes at each position.
+constexpr int32_t HASH_BITS    = 13;
+constexpr int32_t HASH_SIZE    = 1 << HASH_BITS;
+constexpr int32_t WINDOW_MASK  = (1 << 11) - 1;
+// The window is small enough that the whole chain can be searched, so we always find the
+// longest match, as the original brute force search did. The candidates are visited nearest
+// first, and for very repetitive data one of the nearest is usually as long as a match can 
+// be, which ends the search early. The fast level gives up after a few candidates.
+constexpr int32_t MAX_CHAIN    = MAX_OFFSET;
+constexpr int32_t FAST_CHAIN   = 8;
+
+
+struct Match
+{
+    int32_t length = 0;
+    int32_t offset = 0;
+};
+
+
+// Finds the longest earlier match for each position in the input using hash chains. Only 
+// the last MAX_OFFSET positions can be referenced, so the links are kept in a ring buffer. 
+// The matches do not overlap the current position, as some decoders copy the bytes in a 
+// single block rather than one at a time.
+class MatchFinder
+{
+public:
+    MatchFinder(const std::vector<uint8_t>& input, int32_t max_chain)
+    : m_data{input.data()}
+    , m_size{int32_t(input.size())}
+    , m_max_chain{max_chain}
+    {
+        m_head.fill(-1);
+        m_prev.fill(-1);
+    }
+
+    // Positions before pos must have been inserted with insert_up_to().
+    Match find(int32_t pos) const
+    {
+        Match   best;
+        int32_t max_length = std::min(MAX_MATCH, m_size - pos);
+        if (max_length < MIN_MATCH)
+        {
+            return best;
+        }
+
+        int32_t chain = m_max_chain;
+        int32_t cand  = m_head[hash(pos)];
+        while ((cand >= 0) && ((pos - cand) <= MAX_OFFSET) && (chain-- > 0))
+        {
+            // Matches can be no longer than their offset.
+            int32_t offset = pos - cand;
+            int32_t limit  = std::min(max_length, offset);
+            // Checking the byte which would make this match longer than the best so far 
+            // rejects most candidates straight away.
+            if ((limit > best.length) && (m_data[cand + best.length] == m_data[pos + best.length]))
+            {
+                int32_t length = int32_t(match_length(m_data + cand, m_data + pos, limit, m_size - pos));
+
+                if ((length >= MIN_MATCH) && (length > best.length))
+                {
+                    best.length = length;
+                    best.offset = offset;
+                    if (length == max_length)
+                    {
+                        break;
+                    }
+                }
+            }
+
+            cand = m_prev[cand & WINDOW_MASK];
+        }
+
+        return best;
+    }
+
+    void insert_up_to(int32_t pos)
+    {
+        // The last couple of positions have no hash, but could not start a match anyway.
+        int32_t end = std::min(pos, m_size - MIN_MATCH + 1);
+        for (; m_inserted < end; ++m_inserted)
+        {
+            uint32_t h = hash(m_inserted);
+            m_prev[m_inserted & WINDOW_MASK] = m_head[h];
+            m_head[h] = m_inserted;
+        }
+    }
+
+private:
+    uint32_t hash(int32_t pos) const
+    {
+        const uint8_t* p = m_data + pos;
+        uint32_t value = uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16);
+        return (value * 2654435761U) >> (32 - HASH_BITS);
+    }
+
+private:
+    const uint8_t*                        m_data;
+    int32_t                               m_size;
+    int32_t                               m_max_chain;
+    int32_t                               m_inserted = 0;
+    std::array<int32_t, HASH_SIZE>        m_head;
+    std::array<int32_t, WINDOW_MASK + 1>  m_prev;
+};
+
+
+void flush_literals(std::vector<uint8_t>& output, const uint8_t* literals, int32_t count)
+{
+    if (count > 0)
+    {
+        output.push_back(uint8_t(count & 0x7F));
+        output.insert(output.end(), literals, literals + count);
+    }
+}
+
+
+void write_match(std::vector<uint8_t>& output, const Match& match)
+{
+    output.push_back(uint8_t(0x80 | ((16 - match.length) << 3) | (match.offset >> 8)));
+    output.push_back(uint8_t(match.offset & 0xFF));
+}
+
+
+// Literals only, for when speed matters more than size.
+std::vector<uint8_t> encode_store(const std::vector<uint8_t>& input)
+{
+    std::vector<uint8_t> output;
+    output.reserve(input.size() + (input.size() / MAX_LITERALS) + 1);
+    for (size_t position = 0; position < input.size(); position += MAX_LITERALS)
+    {
+        int32_t count = int32_t(std::min<size_t>(MAX_LITERALS, input.size() - position));
+        flush_literals(output, input.data() + position, count);
+    }
+    return output;
+}
+
+
+// This is a greedy parse, as in _lz77.c in the NML source, from which this was originally 
+// copied. The brute force search for matches has been replaced with hash chains.
+std::vector<uint8_t> encode_greedy(const std::vector<uint8_t>& input, int32_t max_chain)
+{
+    std::vector<uint8_t> output;
+    // Worst case is all literals.
+    output.reserve(input.size() + (input.size() / MAX_LITERALS) + 1);
+
+    MatchFinder finder{input, max_chain};
+    int32_t     input_size    = int32_t(input.size());
+    int32_t     literal_start = 0;
+    int32_t     position      = 0;
+    while (position < input_size) 
+    {
+        finder.insert_up_to(position);
+        Match match = finder.find(position);
+        if (match.length > 0) 
+        {
+            flush_literals(output, input.data() + literal_start, position - literal_start);
+            write_match(output, match);
+            position     += match.length;
+            literal_start = position;
+        } 
+        else 
+        {
+            position += 1;
+            if ((position - literal_start) == MAX_LITERALS)
+            {
+                flush_literals(output, input.data() + literal_start, MAX_LITERALS);
+                literal_start = position;
+            }
+        }
+    }
+    
+    flush_literals(output, input.data() + literal_start, position - literal_start);
+    return output;
+}
+
+
+// Dynamic programming over the whole input. Working backwards from the end, cost[i] is the 
+// smallest number of bytes needed to encode the data from position i onwards, given that 
+// a new block starts at i. That block is either: 
+//   - a match of any length from MIN_MATCH up to the longest found at i (any shorter prefix 
+//     of a match is also a match at the same offset), costing 2 bytes; or 
+//   - a run of 1 to MAX_LITERALS literals, costing one byte more than its length. 
+// For the literal runs, cost[i] = 1 - i + min(j + cost[j]) over j in (i, i + MAX_LITERALS],
+// which is tracked as a sliding window minimum so that each position is O(1).
+std::vector<uint8_t> encode_optimal(const std::vector<uint8_t>& input)
+{
+    int32_t input_size = int32_t(input.size());
+
+    std::vector<Match> matches(input_size);
+    MatchFinder finder{input, MAX_CHAIN};
+    for (int32_t position = 0; position < input_size; ++position)
+    {
+        finder.insert_up_to(position);
+        matches[position] = finder.find(position);
+    }
+
+    // A positive step is the length of a match, and a negative step the length of a 
+    // literal run.
+    std::vector<int32_t> cost(input_size + 1);
+    std::vector<int32_t> step(input_size + 1);
+    std::deque<int32_t>  window;
+    auto key = [&cost](int32_t j) { return j + cost[j]; };
+
+    cost[input_size] = 0;
+    for (int32_t i = input_size - 1; i >= 0; --i)
+    {
+        while (!window.empty() && (key(window.back()) >= key(i + 1)))
+        {
+            window.pop_back();
+        }
+        window.push_back(i + 1);
+        while ((window.front() - i) > MAX_LITERALS)
+        {
+            window.pop_front();
+        }
+
+        cost[i] = 1 - i + key(window.front());
+        step[i] = i - window.front();
+
+        // On a tie the match wins, as it is quicker to decode.
+        for (int32_t length = matches[i].length; length >= MIN_MATCH; --length)
+        {
+            if ((2 + cost[i + length]) <= cost[i])
+            {
+                cost[i] = 2 + cost[i + length];
+                step[i] = length;
+            }
+        }
+    }
+
+    std::vector<uint8_t> output;
+    output.reserve(cost[0]);
+    int32_t position = 0;
+    while (position < input_size)
+    {
+        if (step[position] > 0)
+        {
+            write_match(output, Match{ step[position], matches[position].offset });
+            position += step[position];
+        }
+        else
+        {
+            flush_literals(output, input.data() + position, -step[position]);
+            position -= step[position];
+        }
+    }
+
+    return output;
+}
+
+
+} // namespace {
+
+
+std::vector<uint8_t> encode_lz77(const std::vector<uint8_t>& input, LZ77Level level)
+{
+    switch (level)
+    {
+        case LZ77Level::Store: return encode_store(input);
+        case LZ77Level::Fast:  return encode_greedy(input, FAST_CHAIN);
+        case LZ77Level::Max:   return encode_optimal(input);
+        default:               return encode_greedy(input, MAX_CHAIN);
+    }
+}
+
+
+size_t decode_lz77(const uint8_t* input, size_t input_size, uint8_t* output, size_t output_size)
+{
+    const uint8_t* in      = input;
+    const uint8_t* in_end  = input + input_size;
+    uint8_t*       out     = output;
+    uint8_t*       out_end = output + output_size;
+
+    // Each block is checked once, and then copied without further checks.
+    while (out < out_end)
+    {
+        if (in >= in_end)
+        {
+            throw LZ77Error("LZ77 decoding error: data ends before the image is complete");
+        }
+
+        int8_t code = int8_t(*in++);
+        if (code < 0)
+        {
+            // The high bit is set, so we are going to copy data from earlier in the sprite.
+            if (in >= in_end)
+            {
+                throw LZ77Error("LZ77 decoding error: data ends in a back-reference");
+            }
+
+            size_t length = size_t(-(code >> 3));
+            size_t offset = ((size_t(code) & 0x07) << 8) | *in++;
+            size_t index  = size_t(out - output);
+            if (offset > index)
+            {
+                std::ostringstream os;
+                os << "LZ77 decoding error: offset (=" << to_hex(uint16_t(offset)) << ") greater than current byte index (=" << to_hex(uint32_t(index)) << ")";
+                throw LZ77Error(os.str());
+            }
+            if (length > size_t(out_end - out))
+            {
+                std::ostringstream os;
+                os << "LZ77 decoding error: length (=" << length << ") greater than remaining image bytes (=" << (out_end - out) << ")";
+                throw LZ77Error(os.str());
+            }
+
+            const uint8_t* from = out - offset;
+            if (offset >= length)
+            {
+                std::memcpy(out, from, length);
+            }
+            else if (offset == 1)
+            {
+                // A run of the same byte.
+                std::memset(out, *from, length);
+            }
+            else
+            {
+                // The source overlaps the destination, so the pattern repeats. Copies are 
+                // at most 16 bytes, so a simple loop is fine.
+                for (size_t i = 0; i < length; ++i)
+                {
+                    out[i] = from[i];
+                }
+            }
+            out += length;
+        }
+        else
+        {
+            // The high bit is not set, so the next length bytes are copied as they are.
+            size_t length = (code == 0) ? 0x80 : size_t(code);
+            if (length > size_t(out_end - out))
+            {
+                std::ostringstream os;
+                os << "LZ77 decoding error: length (=" << length << ") greater than remaining image bytes (=" << (out_end - out) << ")";
+                throw LZ77Error(os.str());
+            }
+            if (length > size_t(in_end - in))
+            {
+                throw LZ77Error("LZ77 decoding error: data ends in a literal block");
+            }
+
+            std::memcpy(out, in, length);
+            in  += length;
+            out += length;
+        }
+    }
+
+    return size_t(in - input);
+}
@@ -0,0 +1,55 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+
+
+// The sprite data in GRF files is compressed with a simple form of LZ77. The data is a 
+// series of blocks of two kinds:
+//   - Literal: a code byte 0x01..0x7F (0x00 means 0x80) followed by that many bytes which
+//     are copied to the output.
+//   - Back-reference: 0x80 | (16 - length) << 3 | offset >> 8 followed by offset & 0xFF. 
+//     This copies length bytes starting offset bytes back in the output.
+//
+// The compression level trades the size of the output for the time taken:
+//   - Store:  literal blocks only. The output is valid but a little larger than the input.
+//   - Fast:   greedy parse, only trying the nearest few candidates for each match.
+//   - Normal: greedy parse, always taking the longest match at each position.
+//   - Max:    optimal parse, the smallest possible encoding for the matches available.
+enum class LZ77Level : uint8_t { Store = 0, Fast = 1, Normal = 2, Max = 3 };
+
+std::vector<uint8_t> encode_lz77(const std::vector<uint8_t>& input, LZ77Level level = LZ77Level::Normal);
+
+
+// Thrown by decode_lz77() for invalid data. The caller adds the context, such as which 
+// sprite was being read.
+class LZ77Error : public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// Decompresses input into exactly output_size bytes at output, and returns the number 
+// of input bytes used. The compressed size is not always known in advance, so reading 
+// stops as soon as the output is full. Back-references which overlap the bytes being 
+// written are allowed, as they are in OpenTTD.
+size_t decode_lz77(const uint8_t* input, size_t input_size, uint8_t* output, size_t output_size);
@@ -0,0 +1,85 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#include "PixelPool.h"
+#include "Fnv1aHash.h"
+#include <algorithm>
+
+
+PixelPool& PixelPool::pool()
+{
+    static PixelPool instance;
+    return instance;
+}
+
+
+// This is quick compared to decompressing the sprite in the first place.
+uint64_t PixelPool::hash(const std::vector<uint8_t>& pixels, uint16_t xdim, uint16_t ydim, uint8_t colour)
+{
+    Fnv1aHash hash;
+    hash.add(uint8_t(xdim)); 
+    hash.add(uint8_t(xdim >> 8));
+    hash.add(uint8_t(ydim)); 
+    hash.add(uint8_t(ydim >> 8));
+    hash.add(colour);
+    hash.add(pixels.data(), pixels.size());
+    return hash.value();
+}
+
+
+PixelPool::Buffer PixelPool::intern(std::vector<uint8_t>&& pixels, uint16_t xdim, uint16_t ydim, uint8_t colour)
+{
+    // The hash is calculated outside the lock so that threads only wait for the lookup.
+    uint64_t pixels_hash = hash(pixels, xdim, ydim, colour);
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+    std::vector<Entry>& entries = m_entries[pixels_hash];
+
+    // Entries whose buffers have been freed are dropped.
+    entries.erase(std::remove_if(entries.begin(), entries.end(), 
+        [](const Entry& entry) { return entry.pixels.expired(); }), entries.end());
+
+    for (const auto& entry: entries)
+    {
+        Buffer buffer = entry.pixels.lock();
+        if (buffer && (entry.xdim == xdim) && (entry.ydim == ydim) && (entry.colour == colour) && (*buffer == pixels))
+        {
+            ++m_shared_sprites;
+            m_shared_bytes += pixels.size();
+            return buffer;
+        }
+    }
+
+    Buffer buffer = std::make_shared<const std::vector<uint8_t>>(std::move(pixels));
+    entries.push_back(Entry{xdim, ydim, colour, buffer});
+    return buffer;
+}
+
+
+uint32_t PixelPool::shared_sprites() const
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_shared_sprites;
+}
+
+
+uint64_t PixelPool::shared_bytes() const
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_shared_bytes;
+}
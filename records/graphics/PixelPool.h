@@ -0,0 +1,66 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+
+// Decoded sprites frequently repeat: ground tiles, blank placeholders, shared vehicle views
+// and so on. The pool hashes the pixels of each decoded sprite so that identical images 
+// share a single buffer. Two sprites have the same buffer only if their pixels, dimensions
+// and colour depth are all the same. Buffers are immutable, and the pool only holds weak 
+// references to them, so a buffer is freed once no sprite uses it.
+class PixelPool
+{
+public:
+    using Buffer = std::shared_ptr<const std::vector<uint8_t>>;
+
+public:
+    static PixelPool& pool();
+
+    // Returns the buffer already holding these pixels if there is one, or else a new buffer
+    // holding them. This is called while sprites are being read on several threads.
+    Buffer intern(std::vector<uint8_t>&& pixels, uint16_t xdim, uint16_t ydim, uint8_t colour);
+
+    // Hash of a sprite image, which is also useful for finding duplicates elsewhere.
+    static uint64_t hash(const std::vector<uint8_t>& pixels, uint16_t xdim, uint16_t ydim, uint8_t colour);
+
+    // The number of sprites which were found to be copies of others, and the bytes saved.
+    uint32_t shared_sprites() const;
+    uint64_t shared_bytes() const;
+
+private:
+    struct Entry
+    {
+        uint16_t xdim;
+        uint16_t ydim;
+        uint8_t  colour;
+        std::weak_ptr<const std::vector<uint8_t>> pixels;
+    };
+
+private:
+    // Entries are indexed by a hash of the pixels, with a list in case of collisions.
+    std::unordered_map<uint64_t, std::vector<Entry>> m_entries;
+    uint32_t                                          m_shared_sprites = 0;
+    uint64_t                                          m_shared_bytes   = 0;
+    mutable std::mutex                                m_mutex;
+};
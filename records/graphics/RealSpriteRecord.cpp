@@ -20,12 +20,19 @@
 #include "SpriteSheetReader.h"
 #include "StreamHelpers.h"
 #include "ChunkEncoder.h"
+#include "LZ77.h"
+#include "Palettes.h"
+#include "PixelPool.h"
+#include "SpriteCache.h"
+#include "Fnv1aHash.h"
 #include <string>
 #include <sstream>
 #include <png.h>
 #include <png.h>
 #include <cstdio>
 #include <algorithm>
+#include <atomic>
+#include <unordered_map>
 #include "FileSystem.h"
 #include "CommandLineOptions.h"
 #include "EnumDescriptor.h"
@@ -33,7 +40,7 @@
 
 
 
-void RealSpriteRecord::read(std::istream& is, const GRFInfo& info)
+void RealSpriteRecord::read(ByteReader& is, const GRFInfo& info)
 {
     // We already have the sprite ID, the size (whatever it actually means), and the compression.
     // Zoom level is only used in Format2 files. 
@@ -88,63 +95,19 @@ void RealSpriteRecord::read(std::istream& is, const GRFInfo& info)
     // Read the image data. This decompression is based on LZ77 in some way. I just followed 
     // the description in the GRF container documentation. Place the expanded data into a 
     // pre-sized buffer. Have subsequently compared the code to OpenTTD, and it looks fine.
+    // The compressed size is not known, so the decoder reads from the rest of the data and
+    // tells us how much it used.
     std::vector<uint8_t> pixdata(img_size);
-    uint32_t index = 0;
-    while (img_size > 0)
+    try
     {
-        int8_t code = read_uint8(is);
-        if (code < 0)
-        {
-            // The high bit is set, so we are going to copy data from earlier
-            // in the sprite.
-            uint16_t length = -(code >> 3);
-            uint8_t  byte   = read_uint8(is);            
-            uint16_t offset = ((static_cast<uint16_t>(code) & 0x07) << 8) | byte;
-            if (offset > index)
-            {
-                std::ostringstream os;
-                os << "LZ77 decoding error: sprite=" << to_hex(m_sprite_id);
-                os << " offset (=" << to_hex(offset) << ") greater than current byte index (=" << to_hex(index) << ")";
-                throw RUNTIME_ERROR(os.str());
-            }
-            if (img_size < length)
-            {
-                std::ostringstream os;
-                os << "LZ77 decoding error: sprite=" << to_hex(m_sprite_id);
-                os << " length (=" << length << ") greater than remaining image bytes (=" << img_size << ")";
-                throw RUNTIME_ERROR(os.str());
-            }
-
-            img_size -= length;
-            for (; length > 0; length--)
-            {
-                if (index < offset) throw RUNTIME_ERROR("1");
-                if (index >= pixdata.size()) throw RUNTIME_ERROR("2");
-
-                pixdata[index] = pixdata[index - offset];
-                index++;
-            }
-        }
-        else
-        {
-            // The high bit is not set so we have to read the next number 
-            // of bytes from the file.
-            uint16_t length = (code == 0) ? 0x80 : code;
-            if (img_size < length)
-            {
-                throw RUNTIME_ERROR("3");
-            }
-
-            img_size -= length;
-            for (; length > 0; length--)
-            {
-                if (index >= pixdata.size()) throw RUNTIME_ERROR("4");
-
-                uint8_t pix = read_uint8(is);
-                pixdata[index] = pix;
-                ++index;
-            }
-        }
+        size_t used = decode_lz77(is.data(), is.remaining(), pixdata.data(), pixdata.size());
+        is.skip(used);
+    }
+    catch (const LZ77Error& e)
+    {
+        std::ostringstream os;
+        os << e.what() << ": sprite=" << to_hex(m_sprite_id);
+        throw RUNTIME_ERROR(os.str());
     }
 
     // This bit in the compression indicates that the image contains transparent sections.
@@ -152,12 +115,11 @@ void RealSpriteRecord::read(std::istream& is, const GRFInfo& info)
     // to obtain the actual pixel data.
     if (m_compression & CHUNKED_FORMAT)
     {
-        m_pixels = decode_tile(pixdata, m_xdim, m_ydim, m_compression, info.format);
-    }
-    else
-    {
-        m_pixels = std::move(pixdata);
+        pixdata = decode_tile(pixdata, m_xdim, m_ydim, m_compression, info.format);
     }
+
+    // Many sprites are exact copies of others, so they share a buffer to save memory.
+    m_pixels = PixelPool::pool().intern(std::move(pixdata), m_xdim, m_ydim, m_colour);
 }
 
 
@@ -171,21 +133,22 @@ RealSpriteRecord::Pixel RealSpriteRecord::pixel(uint32_t x, uint32_t y) const
     pix_size += (m_colour & HAS_PALETTE) ? 1 : 0;
 
     uint32_t offset = (y * m_xdim + x) * pix_size;
+    const std::vector<uint8_t>& pixels = *m_pixels;
 
     Pixel pixel = {};
     if (m_colour & HAS_RGB)
     {
-        pixel.red   = m_pixels[offset++];
-        pixel.green = m_pixels[offset++];
-        pixel.blue  = m_pixels[offset++];
+        pixel.red   = pixels[offset++];
+        pixel.green = pixels[offset++];
+        pixel.blue  = pixels[offset++];
     }    
     if (m_colour & HAS_ALPHA)
     {
-        pixel.alpha = m_pixels[offset++];
+        pixel.alpha = pixels[offset++];
     }    
     if (m_colour & HAS_PALETTE)
     {
-        pixel.index = m_pixels[offset++];
+        pixel.index = pixels[offset++];
     }    
 
     return pixel;
@@ -193,6 +156,16 @@ RealSpriteRecord::Pixel RealSpriteRecord::pixel(uint32_t x, uint32_t y) const
 
 
 void RealSpriteRecord::set_pixel(uint32_t x, uint32_t y, const Pixel& pixel)
+{
+    // The buffer is immutable and may be shared with other sprites, so it is replaced by 
+    // a changed copy.
+    std::vector<uint8_t> pixels = *m_pixels;
+    set_pixel(pixels, x, y, pixel);
+    m_pixels = std::make_shared<const std::vector<uint8_t>>(std::move(pixels));
+}
+
+
+void RealSpriteRecord::set_pixel(std::vector<uint8_t>& pixels, uint32_t x, uint32_t y, const Pixel& pixel) const
 {
     // This is probably slow. Need a better implementation/interaction with 
     // sprite sheet generator.
@@ -205,22 +178,199 @@ void RealSpriteRecord::set_pixel(uint32_t x, uint32_t y, const Pixel& pixel)
 
     if (m_colour & HAS_RGB)
     {
-        m_pixels[offset++] = pixel.red;
-        m_pixels[offset++] = pixel.green;
-        m_pixels[offset++] = pixel.blue;
+        pixels[offset++] = pixel.red;
+        pixels[offset++] = pixel.green;
+        pixels[offset++] = pixel.blue;
     }    
     if (m_colour & HAS_ALPHA)
     {
-        m_pixels[offset++] = pixel.alpha;
+        pixels[offset++] = pixel.alpha;
     }    
     if (m_colour & HAS_PALETTE)
     {
-        m_pixels[offset++] = pixel.index;
+        pixels[offset++] = pixel.index;
     }    
 }
 
 
-void RealSpriteRecord::write(std::ostream& os, const GRFInfo& info) const
+bool RealSpriteRecord::same_image(const RealSpriteRecord& other) const
+{
+    // Comparing the buffers is enough for sprites which were read from a GRF, because the 
+    // pool has already compared their pixels. 
+    return (m_pixels == other.m_pixels) && (m_xdim == other.m_xdim) && 
+           (m_ydim == other.m_ydim) && (m_colour == other.m_colour);
+}
+
+
+uint64_t RealSpriteRecord::content_hash() const
+{
+    // Collisions are resolved by same_content(), so a simple mix of the other fields will do.
+    uint64_t hash = PixelPool::hash(*m_pixels, m_xdim, m_ydim, m_colour);
+    hash ^= (uint64_t(uint16_t(m_xrel)) << 40) | (uint64_t(uint16_t(m_yrel)) << 24) | 
+            (uint64_t(m_zoom) << 8) | m_compression;
+    return hash;
+}
+
+
+bool RealSpriteRecord::same_content(const RealSpriteRecord& other) const
+{
+    return (m_zoom == other.m_zoom) && (m_compression == other.m_compression) && (m_colour == other.m_colour) && 
+           (m_xdim == other.m_xdim) && (m_ydim == other.m_ydim) && 
+           (m_xrel == other.m_xrel) && (m_yrel == other.m_yrel) && 
+           ((m_pixels == other.m_pixels) || (*m_pixels == *other.m_pixels));
+}
+
+
+static LZ77Level lz77_level()
+{
+    return static_cast<LZ77Level>(CommandLineOptions::options().compression());
+}
+
+
+std::vector<uint8_t> RealSpriteRecord::encode_chunked(GRFFormat format, uint32_t& chunked_size) const
+{
+    const CommandLineOptions& options = CommandLineOptions::options();
+    ChunkGapTable&            gaps    = ChunkGapTable::table();
+    ChunkGapTable::Key        key{m_sprite_id, static_cast<uint8_t>(m_zoom), m_colour, 
+                                  PixelPool::hash(*m_pixels, m_xdim, m_ydim, m_colour)};
+
+    if (!options.auto_chunk_gap())
+    {
+        // Use the gap chosen by an earlier encode, if there was one.
+        uint8_t gap = gaps.gap(key, options.chunk_gap());
+        std::vector<uint8_t> chunked_data = encode_tile(*m_pixels, m_xdim, m_ydim, m_colour, format, gap);
+        chunked_size = uint32_t(chunked_data.size());
+        return encode_lz77(chunked_data, lz77_level());
+    }
+
+    // Try each gap and keep the smallest result. The default gap is first so that it wins 
+    // any ties. The sprites are already divided among the worker threads, so the candidates 
+    // are tried in turn on this sprite's thread.
+    static constexpr uint8_t CANDIDATE_GAPS[] = { 3, 1, 2, 4, 6, 8, 12, 16 };
+
+    std::vector<uint8_t> best;
+    uint8_t              best_gap = 0;
+    for (uint8_t gap: CANDIDATE_GAPS)
+    {
+        std::vector<uint8_t> chunked_data = encode_tile(*m_pixels, m_xdim, m_ydim, m_colour, format, gap);
+        std::vector<uint8_t> output_data  = encode_lz77(chunked_data, lz77_level());
+        if ((best_gap == 0) || (output_data.size() < best.size()))
+        {
+            best         = std::move(output_data);
+            best_gap     = gap;
+            chunked_size = uint32_t(chunked_data.size());
+        }
+    }
+
+    gaps.set_gap(key, best_gap);
+    return best;
+}
+
+
+std::vector<uint8_t> RealSpriteRecord::encode_pixels(GRFFormat format, uint8_t& compression, uint32_t& chunked_size) const
+{
+    SpriteCache& cache = SpriteCache::cache();
+    if (!cache.enabled())
+    {
+        return compress_pixels(format, compression, chunked_size);
+    }
+
+    const CommandLineOptions& options = CommandLineOptions::options();
+    ChunkGapTable&            gaps    = ChunkGapTable::table();
+
+    // Everything which affects the compressed data is part of the key. The gap is zero when
+    // it is chosen by searching.
+    const uint64_t     pixels_hash = PixelPool::hash(*m_pixels, m_xdim, m_ydim, m_colour);
+    ChunkGapTable::Key gap_key{m_sprite_id, static_cast<uint8_t>(m_zoom), m_colour, pixels_hash};
+    auto make_key = [&](uint8_t gap)
+    {
+        const uint8_t settings[] = 
+        { 
+            static_cast<uint8_t>(format), m_compression, options.compression(), 
+            options.auto_chunking(), options.auto_chunk_gap(), gap, uint8_t(SpriteCache::ENCODER_VERSION) 
+        };
+        Fnv1aHash key{pixels_hash};
+        key.add(settings, sizeof(settings));
+        return key.value();
+    };
+
+    const uint8_t  gap = gaps.gap(gap_key, options.auto_chunk_gap() ? 0 : options.chunk_gap());
+    const uint64_t key = make_key(gap);
+
+    SpriteCache::Entry entry;
+    if (cache.lookup(key, *m_pixels, m_xdim, m_ydim, m_colour, format, entry))
+    {
+        // Later encodes should use the same gap as the one which made the cached data.
+        if (entry.chunk_gap != 0)
+        {
+            gaps.set_gap(gap_key, entry.chunk_gap);
+        }
+    }
+    else
+    {
+        entry.data      = compress_pixels(format, entry.compression, entry.chunked_size);
+        entry.chunk_gap = (gap == 0) ? gaps.gap(gap_key, 0) : 0;
+        cache.store(key, entry);
+
+        // The next encode will read the chosen gap from the gaps file, so store the data 
+        // under that key too.
+        if (entry.chunk_gap != 0)
+        {
+            uint8_t chosen_gap = entry.chunk_gap;
+            entry.chunk_gap    = 0;
+            cache.store(make_key(chosen_gap), entry);
+        }
+    }
+
+    compression  = entry.compression;
+    chunked_size = entry.chunked_size;
+    return std::move(entry.data);
+}
+
+
+std::vector<uint8_t> RealSpriteRecord::compress_pixels(GRFFormat format, uint8_t& compression, uint32_t& chunked_size) const
+{
+    compression = m_compression;
+    if (!CommandLineOptions::options().auto_chunking())
+    {
+        return (m_compression & CHUNKED_FORMAT) ? encode_chunked(format, chunked_size) : encode_lz77(*m_pixels, lz77_level());
+    }
+
+    // Compress the sprite both ways and keep the smaller.
+    compression &= ~CHUNKED_FORMAT;
+    std::vector<uint8_t> plain = encode_lz77(*m_pixels, lz77_level());
+    if ((format == GRFFormat::Container1) && (m_xdim > 0x100))
+    {
+        return plain;
+    }
+
+    uint32_t size = 0;
+    std::vector<uint8_t> chunked = encode_chunked(format, size);
+    if (prefer_chunked(format, m_xdim, plain.size(), chunked.size(), size))
+    {
+        compression |= CHUNKED_FORMAT;
+        chunked_size = size;
+        return chunked;
+    }
+    return plain;
+}
+
+
+bool RealSpriteRecord::prefer_chunked(GRFFormat format, uint16_t xdim, size_t plain_size, 
+    size_t chunked_size, uint32_t chunked_data_size)
+{
+    // Chunked Container1 sprites cannot be wider than 256 pixels, and their size must fit 
+    // in 16 bits with the header. Chunked Container2 sprites have an extra 4 bytes for the 
+    // size of the chunked data.
+    if (format == GRFFormat::Container1)
+    {
+        return (xdim <= 0x100) && ((chunked_data_size + 8) <= 0xFFFF) && (chunked_size < plain_size);
+    }
+    return (chunked_size + 4) < plain_size;
+}
+
+
+void RealSpriteRecord::write(ByteWriter& os, const GRFInfo& info) const
 {
     if (info.format == GRFFormat::Container2)
     {
@@ -233,27 +383,20 @@ void RealSpriteRecord::write(std::ostream& os, const GRFInfo& info) const
 }
 
 
-void RealSpriteRecord::write_format1(std::ostream& os) const
+void RealSpriteRecord::write_format1(ByteWriter& os) const
 {
     // This is a fake sprite used where there is no image at all, but a slot for one in the NFO.
-    if (m_pixels.size() == 0)
+    if (m_pixels->empty())
     {
         write_uint8(os, 0x00);
         return;
     }
 
-    std::vector<uint8_t> output_data;
+    uint8_t  compression = 0;
     uint32_t uncomp_size = 0;
-
-    if (m_compression & CHUNKED_FORMAT)
-    {
-        std::vector<uint8_t> chunked_data = encode_tile(m_pixels, m_xdim, m_ydim, m_colour, GRFFormat::Container1); 
-        uncomp_size = uint32_t(chunked_data.size());            
-        output_data = encode_lz77(chunked_data);
-    }
-    else
+    std::vector<uint8_t> output_data = encode_pixels(GRFFormat::Container1, compression, uncomp_size);
+    if ((compression & CHUNKED_FORMAT) == 0)
     {
-        output_data = encode_lz77(m_pixels);
         uncomp_size = uint32_t(m_xdim) * uint32_t(m_ydim);    
     }
 
@@ -267,43 +410,31 @@ void RealSpriteRecord::write_format1(std::ostream& os) const
     //         file. If it is unset, you *must* decompress it to find out
     //          how large it is in the file.
     // 3   8  Has transparency (i.e. is a tile), see below.
-    write_uint8(os,  m_compression | 0x01); // Not entirely sure about bit 2 - see examples...
+    write_uint8(os,  compression | 0x01); // Not entirely sure about bit 2 - see examples...
     
     write_uint8(os,  uint8_t(m_ydim));
     write_uint16(os, m_xdim);
     write_uint16(os, m_xrel);
     write_uint16(os, m_yrel);
 
-    for (const auto byte: output_data)
-    {
-        write_uint8(os, byte);
-    }
+    os.write_bytes(output_data.data(), output_data.size());
 }   
 
 
-void RealSpriteRecord::write_format2(std::ostream& os) const
+void RealSpriteRecord::write_format2(ByteWriter& os) const
 {
     // This is a fake sprite used where there is no image at all, but a slot for one in the NFO.
-    if (m_pixels.size() == 0)
+    if (m_pixels->empty())
     {
         write_uint8(os, 0x00);
         return;
     }
 
-    std::vector<uint8_t> output_data;
+    uint8_t  compression = 0;
     uint32_t uncomp_size = 0;
-    if (m_compression & CHUNKED_FORMAT)
-    {
-        std::vector<uint8_t> chunked_data = encode_tile(m_pixels, m_xdim, m_ydim, m_colour, GRFFormat::Container2);
-        output_data = encode_lz77(chunked_data);
-        uncomp_size = uint32_t(chunked_data.size());
-    }
-    else
-    {
-        output_data = encode_lz77(m_pixels);
-    }
+    std::vector<uint8_t> output_data = encode_pixels(GRFFormat::Container2, compression, uncomp_size);
 
-    uint32_t output_size = uint32_t(output_data.size() + ((m_compression & CHUNKED_FORMAT) ? 14 : 10));
+    uint32_t output_size = uint32_t(output_data.size() + ((compression & CHUNKED_FORMAT) ? 14 : 10));
 
     // TODO this isn't quite right - a different size is written sometimes.
     // We need to know this value for reading chunked sprites.
@@ -314,7 +445,7 @@ void RealSpriteRecord::write_format2(std::ostream& os) const
     // 1   2  Pixel format contains alpha component.
     // 2   4  Pixel format contains mask/palette component.
     // 3   8  Has transparency (i.e. is a tile), see below.
-    write_uint8(os,  m_compression | m_colour);
+    write_uint8(os,  compression | m_colour);
 
     write_uint8(os,  static_cast<uint8_t>(m_zoom));
     write_uint16(os, m_ydim);
@@ -325,126 +456,15 @@ void RealSpriteRecord::write_format2(std::ostream& os) const
     // The uncompressed size is only given in certain cases. The transparency bit tells us how to decode the 
     // data after reading if from the file. It is the size of the data before chunk-compression (tiles). I think.
     //if (has_transparency(m_compression, GRFFormat::Container2))
-    if (m_compression & CHUNKED_FORMAT)
+    if (compression & CHUNKED_FORMAT)
     {
         write_uint32(os, uncomp_size);
     }
 
-    uint32_t size = uint32_t(output_data.size());
-    for (uint32_t i = 0; i < size; ++i)
-    //for (const auto byte: output_data)
-    {
-        //write_uint8(os, byte);
-        write_uint8(os, output_data[i]);
-    }
+    os.write_bytes(output_data.data(), output_data.size());
 }  
 
 
-static void append_byte(std::vector<uint8_t>& output, uint8_t byte)
-{
-    output.push_back(byte);
-}
-
-
-static void append_bytes(std::vector<uint8_t>& output, const uint8_t* bytes, uint8_t length)
-{
-    for (uint8_t b = 0; b < length; ++b)
-    {
-        output.push_back(bytes[b]);
-    }
-}
-
-
-static inline int find(const uint8_t* pat_data, int32_t pat_size, const uint8_t* data, int32_t data_size)
-{
-    for (int32_t i = 0; i + pat_size <= data_size; ++i) 
-    {
-        int32_t j = 0;
-        while (j < pat_size && pat_data[j] == data[i + j]) ++j;
-        if (j == pat_size)
-        {
-            return i;
-        } 
-    }
-    return -1;
-}
-
-
-// This implementation is directly copied from _lz77.c found in the NML source.
-// Some types and whatnot have been changed, but the algorithm is the same.
-std::vector<uint8_t> RealSpriteRecord::encode_lz77(const std::vector<uint8_t>& input_data) const
-{
-    std::vector<uint8_t> output;
-
-    std::array<uint8_t, 0x80> literal;
-    uint8_t literal_size = 0;
-    int32_t input_size  = int32_t(input_data.size());
-    
-    int32_t position = 0;
-    while (position < input_size) 
-    {
-        int32_t start_pos = position - (1 << 11) + 1;
-        if (start_pos < 0) start_pos = 0;
-
-        // Loop through the lookahead buffer. 
-        int32_t max_look = input_size - position + 1;
-        if (max_look > 16) 
-        {
-            max_look = 16;
-        }
-
-        int32_t overlap_pos = 0;
-        int32_t overlap_len = 0;
-        int32_t i;
-        for (i = 3; i < max_look; ++i) 
-        {
-            // Find the pattern match in the window. 
-            int result = find(&input_data[0] + position, i, &input_data[0] + start_pos, position - start_pos);
-            // If match failed, we've found the longest. 
-            if (result < 0) break;
-
-            overlap_pos = position - start_pos - result;
-            overlap_len = i;
-            start_pos += result;
-        }
-
-        if (overlap_len > 0) 
-        {
-            if (literal_size > 0) 
-            {
-                append_byte(output, literal_size);
-                append_bytes(output, &literal[0], literal_size);
-                literal_size = 0;
-            }
-            int32_t val = 0x80 | (16 - overlap_len) << 3 | overlap_pos >> 8;
-            append_byte(output, val);
-            append_byte(output, overlap_pos & 0xFF);
-            position += overlap_len;
-        } 
-        else 
-        {
-            literal[literal_size++] = input_data[position];
-            if (literal_size == sizeof(literal)) 
-            {
-                append_byte(output, 0);
-                append_bytes(output, &literal[0], literal_size);
-                literal_size = 0;
-            }
-            position += 1;
-        }
-    }
-    
-    if (literal_size > 0) 
-    {
-        append_byte(output, literal_size);
-        append_bytes(output, &literal[0], literal_size);
-        literal_size = 0;
-    }
-
-    return output;
-}
-
-
 namespace {
 
 
@@ -617,7 +637,7 @@ void RealSpriteRecord::parse(TokenStream& is, SpriteZoomMap& sprites)
     pix_size  = (m_colour & HAS_RGB)     ? 3 : 0;
     pix_size += (m_colour & HAS_ALPHA)   ? 1 : 0;
     pix_size += (m_colour & HAS_PALETTE) ? 1 : 0;
-    m_pixels.resize(m_xdim * m_ydim * pix_size);
+    std::vector<uint8_t> pixdata(m_xdim * m_ydim * pix_size);
 
     // TODO this wants to be in a more global scope.
     SpriteSheetPool& pool = SpriteSheetPool::pool();
@@ -671,9 +691,10 @@ void RealSpriteRecord::parse(TokenStream& is, SpriteZoomMap& sprites)
 
             }
 
-            set_pixel(x, y, pixel);
+            set_pixel(pixdata, x, y, pixel);
         }
     }
+    m_pixels = std::make_shared<const std::vector<uint8_t>>(std::move(pixdata));
 
     if (pure_white_pixels > 0)
     {
@@ -683,6 +704,276 @@ void RealSpriteRecord::parse(TokenStream& is, SpriteZoomMap& sprites)
     }
 
     check_white_border(image_sheet);
+
+    if (CommandLineOptions::options().crop())
+    {
+        crop_transparent_border();
+    }
+}
+
+
+// Tally of the pixels removed by cropping, for reporting at the end of the encode.
+static std::atomic<uint64_t> g_cropped_pixels{0};
+static std::atomic<uint32_t> g_cropped_sprites{0};
+
+
+uint64_t RealSpriteRecord::cropped_pixels()  { return g_cropped_pixels; }
+uint32_t RealSpriteRecord::cropped_sprites() { return g_cropped_sprites; }
+
+
+void RealSpriteRecord::crop_transparent_border()
+{
+    // The no_crop flag means the sprite must be left as it is.
+    if ((m_compression & CROP_TRANSARENT_BORDER) || m_pixels->empty())
+    {
+        return;
+    }
+
+    // Without an alpha channel every RGB pixel is opaque, so there is nothing to crop.
+    if ((m_colour & HAS_RGB) && !(m_colour & HAS_ALPHA))
+    {
+        return;
+    }
+
+    uint8_t pix_size = 0;
+    pix_size  = (m_colour & HAS_RGB)     ? 3 : 0;
+    pix_size += (m_colour & HAS_ALPHA)   ? 1 : 0;
+    pix_size += (m_colour & HAS_PALETTE) ? 1 : 0;
+
+    // A pixel is transparent if its alpha is zero and its palette index (if it has one) 
+    // is zero, so that masks are not cropped either.
+    const uint8_t alpha_offset = 3;
+    const uint8_t index_offset = pix_size - 1;
+    auto is_visible = [&](uint32_t x, uint32_t y)
+    {
+        const uint8_t* pixel = &(*m_pixels)[(size_t(y) * m_xdim + x) * pix_size];
+        return ((m_colour & HAS_ALPHA) && (pixel[alpha_offset] != 0)) ||
+               ((m_colour & HAS_PALETTE) && (pixel[index_offset] != 0));
+    };
+
+    // Bounds of the visible pixels.
+    uint16_t left   = m_xdim;
+    uint16_t right  = 0;
+    uint16_t top    = m_ydim;
+    uint16_t bottom = 0;
+    for (uint16_t y = 0; y < m_ydim; ++y)
+    {
+        for (uint16_t x = 0; x < m_xdim; ++x)
+        {
+            if (is_visible(x, y))
+            {
+                left   = std::min(left, x);
+                right  = std::max<uint16_t>(right, x + 1);
+                top    = std::min(top, y);
+                bottom = std::max<uint16_t>(bottom, y + 1);
+            }
+        }
+    }
+
+    // A completely transparent sprite is reduced to a single pixel, as grfcodec does.
+    if (left >= right)
+    {
+        left   = 0;
+        right  = 1;
+        top    = 0;
+        bottom = 1;
+    }
+
+    uint16_t xdim = right - left;
+    uint16_t ydim = bottom - top;
+    if ((xdim == m_xdim) && (ydim == m_ydim))
+    {
+        return;
+    }
+
+    std::vector<uint8_t> pixels(size_t(xdim) * ydim * pix_size);
+    for (uint16_t y = 0; y < ydim; ++y)
+    {
+        const uint8_t* from = &(*m_pixels)[(size_t(y + top) * m_xdim + left) * pix_size];
+        std::copy(from, from + size_t(xdim) * pix_size, &pixels[size_t(y) * xdim * pix_size]);
+    }
+
+    g_cropped_pixels  += uint64_t(m_xdim) * m_ydim - uint64_t(xdim) * ydim;
+    g_cropped_sprites += 1;
+
+    // The offsets move so that the visible pixels are drawn in the same place.
+    m_pixels = std::make_shared<const std::vector<uint8_t>>(std::move(pixels));
+    m_xdim   = xdim;
+    m_ydim   = ydim;
+    m_xrel   = int16_t(m_xrel + left);
+    m_yrel   = int16_t(m_yrel + top);
+}
+
+
+// Tallies of the images changed by colour depth reduction, for reporting at the end of the encode.
+static std::atomic<uint32_t> g_dropped_masks{0};
+static std::atomic<uint32_t> g_demoted_sprites{0};
+
+
+uint32_t RealSpriteRecord::dropped_masks()   { return g_dropped_masks; }
+uint32_t RealSpriteRecord::demoted_sprites() { return g_demoted_sprites; }
+
+
+// Maps RGB colours to the palette indices which may stand in for them. Index 0 is transparent,
+// the company colours are recoloured, and the animated colours cycle, so none of these would 
+// look the same as the original pixel. Where a colour appears more than once, the lowest 
+// index is used.
+using PaletteLookup = std::unordered_map<uint32_t, uint8_t>;
+
+
+static PaletteLookup make_palette_lookup(PaletteType type)
+{
+    const PaletteArray& palette = get_palette_data(type);
+
+    PaletteLookup lookup;
+    for (uint16_t index = 1; index < 0xE3; ++index)
+    {
+        bool company_colour = ((index >= 0x50) && (index <= 0x57)) || ((index >= 0xC6) && (index <= 0xCD));
+        if (!company_colour)
+        {
+            uint32_t rgb = (palette[index * 3] << 16) | (palette[index * 3 + 1] << 8) | palette[index * 3 + 2];
+            lookup.emplace(rgb, uint8_t(index));
+        }
+    }
+
+    return lookup;
+}
+
+
+static const PaletteLookup& palette_lookup(PaletteType type)
+{
+    static const std::array<PaletteLookup, 5> lookups = 
+    {
+        make_palette_lookup(PaletteType::Default),
+        make_palette_lookup(PaletteType::DOS),
+        make_palette_lookup(PaletteType::Windows),
+        make_palette_lookup(PaletteType::DOSToyland),
+        make_palette_lookup(PaletteType::WindowsToyland)
+    };
+
+    return lookups[static_cast<size_t>(type)];
+}
+
+
+void RealSpriteRecord::reduce_colour_depth(SpriteZoomVector& images)
+{
+    std::vector<RealSpriteRecord*> sprites;
+    for (auto& image: images)
+    {
+        // A sound effect has no pixels to reduce.
+        if (image->record_type() != RecordType::REAL_SPRITE)
+        {
+            return;
+        }
+        sprites.push_back(static_cast<RealSpriteRecord*>(image.get()));
+    }
+
+    bool demote = !sprites.empty();
+    for (auto sprite: sprites)
+    {
+        if (sprite->drop_empty_mask())
+        {
+            ++g_dropped_masks;
+        }
+
+        // OpenTTD only falls back on 8bpp images when a sprite has no 32bpp images, so all 
+        // of them have to be demoted or none. A sprite which already has 8bpp images is left
+        // alone so that the 8bpp blitter draws the same images as before.
+        demote = demote && ((sprite->m_colour & HAS_PALETTE) == 0);
+    }
+
+    if (!demote)
+    {
+        return;
+    }
+
+    std::vector<std::vector<uint8_t>> indices(sprites.size());
+    for (size_t i = 0; i < sprites.size(); ++i)
+    {
+        if (!sprites[i]->find_palette_indices(indices[i]))
+        {
+            return;
+        }
+    }
+
+    for (size_t i = 0; i < sprites.size(); ++i)
+    {
+        sprites[i]->m_colour = HAS_PALETTE;
+        sprites[i]->m_pixels = std::make_shared<const std::vector<uint8_t>>(std::move(indices[i]));
+        ++g_demoted_sprites;
+    }
+}
+
+
+bool RealSpriteRecord::drop_empty_mask()
+{
+    if (m_colour != (HAS_RGB | HAS_ALPHA | HAS_PALETTE))
+    {
+        return false;
+    }
+
+    // A mask index of zero means the pixel is not recoloured, so a mask which is zero 
+    // everywhere does nothing.
+    const std::vector<uint8_t>& old_pixels = *m_pixels;
+    const uint8_t pix_size = 5;
+    for (size_t i = pix_size - 1; i < old_pixels.size(); i += pix_size)
+    {
+        if (old_pixels[i] != 0)
+        {
+            return false;
+        }
+    }
+
+    std::vector<uint8_t> pixels;
+    pixels.reserve(old_pixels.size() / pix_size * 4);
+    for (size_t i = 0; i < old_pixels.size(); i += pix_size)
+    {
+        pixels.insert(pixels.end(), &old_pixels[i], &old_pixels[i + 4]);
+    }
+
+    m_pixels = std::make_shared<const std::vector<uint8_t>>(std::move(pixels));
+    m_colour = HAS_RGB | HAS_ALPHA;
+    m_mask_filename.clear();
+    return true;
+}
+
+
+bool RealSpriteRecord::find_palette_indices(std::vector<uint8_t>& indices) const
+{
+    if ((m_colour & HAS_RGB) == 0)
+    {
+        return false;
+    }
+
+    const PaletteLookup& lookup   = palette_lookup(CommandLineOptions::options().palette());
+    const uint8_t        pix_size = (m_colour & HAS_ALPHA) ? 4 : 3;
+
+    indices.resize(m_pixels->size() / pix_size);
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        const uint8_t* pixel = &(*m_pixels)[i * pix_size];
+        uint8_t        alpha = (m_colour & HAS_ALPHA) ? pixel[3] : 0xFF;
+
+        if (alpha == 0)
+        {
+            indices[i] = 0;
+            continue;
+        }
+        // Partly transparent pixels have no 8bpp equivalent.
+        if (alpha != 0xFF)
+        {
+            return false;
+        }
+
+        auto it = lookup.find((pixel[0] << 16) | (pixel[1] << 8) | pixel[2]);
+        if (it == lookup.end())
+        {
+            return false;
+        }
+        indices[i] = it->second;
+    }
+
+    return true;
 }
 
 
@@ -18,6 +18,7 @@
 ///////////////////////////////////////////////////////////////////////////////
 #pragma once 
 #include "Record.h"
+#include <memory>
 #include <vector>
 
 
@@ -76,8 +77,8 @@ public:
     }
 
     // Binary serialisation
-    void read(std::istream& is, const GRFInfo& info) override;
-    void write(std::ostream& os, const GRFInfo& info) const override;   
+    void read(ByteReader& is, const GRFInfo& info) override;
+    void write(ByteWriter& os, const GRFInfo& info) const override;   
     // Text serialisation
     void print(std::ostream& os, const SpriteZoomMap& sprites, uint16_t indent) const override;
     void parse(TokenStream& is, SpriteZoomMap& sprites) override;
@@ -108,21 +109,63 @@ public:
     };
     Pixel pixel(uint32_t x, uint32_t y) const;
     void  set_pixel(uint32_t x, uint32_t y, const Pixel& pix);
+
+    // Decoded sprites with identical images share the same pixel buffer.
+    const std::vector<uint8_t>& pixels() const { return *m_pixels; }
+    bool same_image(const RealSpriteRecord& other) const;
+
+    // Compares everything written to the GRF except the sprite ID. This is used to find
+    // sprites which could be written once and shared.
+    uint64_t content_hash() const;
+    bool     same_content(const RealSpriteRecord& other) const;
     
     void set_xoff(uint16_t offset) { m_xoff = offset; }
     void set_yoff(uint16_t offset) { m_yoff = offset; }
     void set_filename(const std::string& filename) { m_filename = filename; }
+    const std::string& filename() const { return m_filename; }
+
+    // Remove fully transparent rows and columns from the edges of the sprite, unless it 
+    // has the no_crop flag, and adjust the offsets to match. The totals are reported at 
+    // the end of an encode.
+    void crop_transparent_border();
+    static uint64_t cropped_pixels();
+    static uint32_t cropped_sprites();
+
+    // Reduce the colour depth of the images of a sprite where this does not change how 
+    // they look. An RGBAP image whose mask is entirely zero loses the mask. If every image 
+    // is 32bpp with binary alpha, and every opaque colour is in the palette, they all become 
+    // 8bpp. The totals are reported at the end of an encode.
+    static void reduce_colour_depth(SpriteZoomVector& images);
+    static uint32_t dropped_masks();
+    static uint32_t demoted_sprites();
+
+    // Whether --auto_chunking stores a sprite chunked, given the sizes of its compressed 
+    // pixels both ways and the size of the chunked data before compression.
+    static bool prefer_chunked(GRFFormat format, uint16_t xdim, size_t plain_size, 
+        size_t chunked_size, uint32_t chunked_data_size);
 
     // Only necessary for RGB[A]P sprites which contain both sprite and mask.
     void set_mask_xoff(uint16_t offset) { m_mask_xoff = offset; }
     void set_mask_yoff(uint16_t offset) { m_mask_yoff = offset; }
     void set_mask_filename(const std::string& filename) { m_mask_filename = filename; }
+    const std::string& mask_filename() const { return m_mask_filename; }
 
 private:
-    void write_format1(std::ostream& os) const;
-    void write_format2(std::ostream& os) const;     
-    
-    std::vector<uint8_t> encode_lz77(const std::vector<uint8_t>& input) const;
+    void set_pixel(std::vector<uint8_t>& pixels, uint32_t x, uint32_t y, const Pixel& pix) const;
+
+    bool drop_empty_mask();
+    // Fills indices with the palette index of each pixel, and returns false if any 
+    // pixel has no exact match.
+    bool find_palette_indices(std::vector<uint8_t>& indices) const;
+
+    void write_format1(ByteWriter& os) const;
+    void write_format2(ByteWriter& os) const;     
+    // Compresses the pixels, chunked or not, and returns the compression flags used. The 
+    // size of the chunked data is returned for chunked sprites.
+    // The result is taken from the sprite cache if it is enabled and has this sprite.
+    std::vector<uint8_t> encode_pixels(GRFFormat format, uint8_t& compression, uint32_t& chunked_size) const;
+    std::vector<uint8_t> compress_pixels(GRFFormat format, uint8_t& compression, uint32_t& chunked_size) const;
+    std::vector<uint8_t> encode_chunked(GRFFormat format, uint32_t& chunked_size) const;
 
     // Check whether a pixel is pure white - we warn about this, and perhaps fix.
     bool is_pure_white(const Pixel& pixel);
@@ -155,5 +198,6 @@ private:
     uint16_t  m_mask_yoff        = 0;
     std::string m_mask_filename;
 
-    std::vector<uint8_t> m_pixels = {};
+    // Immutable, and may be shared with other sprites. See PixelPool.
+    std::shared_ptr<const std::vector<uint8_t>> m_pixels = std::make_shared<const std::vector<uint8_t>>();
 };
@@ -20,7 +20,7 @@
 #include "StreamHelpers.h"
 
 
-void RecolourRecord::read(std::istream& is, const GRFInfo& info)
+void RecolourRecord::read(ByteReader& is, const GRFInfo& info)
 {
     for (auto& item: m_colour_map)
     {
@@ -29,7 +29,7 @@ void RecolourRecord::read(std::istream& is, const GRFInfo& info)
 }
 
 
-void RecolourRecord::write(std::ostream& os, const GRFInfo& info) const
+void RecolourRecord::write(ByteWriter& os, const GRFInfo& info) const
 {
     // The first byte in the record is literal zero. This makes it 
     // look like an Action00, but it can be disambiguated by context on
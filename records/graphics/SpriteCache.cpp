@@ -0,0 +1,191 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#include "SpriteCache.h"
+#include "RealSpriteRecord.h"
+#include "ChunkEncoder.h"
+#include "LZ77.h"
+#include "FileSystem.h"
+#include <array>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+
+namespace {
+
+constexpr std::array<char, 4> ENTRY_MAGIC = { 'Y', 'S', 'C', '1' };
+
+// The header of each entry file: magic, compression, chunk gap, chunked size, data size.
+constexpr size_t HEADER_SIZE = 4 + 1 + 1 + 4 + 4;
+
+
+void put_uint32(std::vector<char>& buffer, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        buffer.push_back(char(value & 0xFF));
+        value >>= 8;
+    }
+}
+
+
+uint32_t get_uint32(const char* data)
+{
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; --i)
+    {
+        value = (value << 8) | uint8_t(data[i]);
+    }
+    return value;
+}
+
+} // namespace {
+
+
+SpriteCache& SpriteCache::cache()
+{
+    static SpriteCache instance;
+    return instance;
+}
+
+
+void SpriteCache::set_directory(const std::string& directory)
+{
+    m_directory = directory;
+    if (!m_directory.empty())
+    {
+        fs::create_directories(m_directory);
+    }
+}
+
+
+std::string SpriteCache::entry_path(uint64_t key) const
+{
+    // Entries are spread over subdirectories so that none of them gets too large.
+    std::ostringstream os;
+    os << std::hex << std::setfill('0') << std::setw(16) << key;
+    std::string name = os.str();
+    return fs::path(m_directory).append(name.substr(0, 2)).append(name.substr(2)).string();
+}
+
+
+bool SpriteCache::read_entry(uint64_t key, Entry& entry) const
+{
+    std::ifstream is(entry_path(key), std::ios::binary);
+    if (!is)
+    {
+        return false;
+    }
+
+    std::array<char, HEADER_SIZE> header;
+    if (!is.read(header.data(), header.size()) || !std::equal(ENTRY_MAGIC.begin(), ENTRY_MAGIC.end(), header.begin()))
+    {
+        return false;
+    }
+
+    entry.compression  = uint8_t(header[4]);
+    entry.chunk_gap    = uint8_t(header[5]);
+    entry.chunked_size = get_uint32(&header[6]);
+    entry.data.resize(get_uint32(&header[10]));
+    return bool(is.read(reinterpret_cast<char*>(entry.data.data()), entry.data.size()));
+}
+
+
+bool SpriteCache::lookup(uint64_t key, const std::vector<uint8_t>& pixels, uint16_t xdim, uint16_t ydim, 
+    uint8_t colour, GRFFormat format, Entry& entry)
+{
+    if (!enabled())
+    {
+        return false;
+    }
+
+    // Decompressing the entry is much quicker than compressing the pixels, and makes 
+    // certain that the entry really does hold these pixels.
+    bool found = false;
+    try
+    {
+        if (read_entry(key, entry))
+        {
+            const bool chunked = (entry.compression & RealSpriteRecord::CHUNKED_FORMAT) != 0;
+
+            std::vector<uint8_t> decoded(chunked ? entry.chunked_size : pixels.size());
+            size_t used = decode_lz77(entry.data.data(), entry.data.size(), decoded.data(), decoded.size());
+            if (chunked && (used == entry.data.size()))
+            {
+                decoded = decode_tile(decoded, xdim, ydim, colour, format);
+            }
+            found = (used == entry.data.size()) && (decoded == pixels);
+        }
+    }
+    catch (const std::exception&)
+    {
+        found = false;
+    }
+
+    if (found)
+    {
+        ++m_hits;
+    }
+    else
+    {
+        ++m_misses;
+    }
+    return found;
+}
+
+
+void SpriteCache::store(uint64_t key, const Entry& entry)
+{
+    if (!enabled())
+    {
+        return;
+    }
+
+    std::vector<char> buffer(ENTRY_MAGIC.begin(), ENTRY_MAGIC.end());
+    buffer.push_back(char(entry.compression));
+    buffer.push_back(char(entry.chunk_gap));
+    put_uint32(buffer, entry.chunked_size);
+    put_uint32(buffer, uint32_t(entry.data.size()));
+    buffer.insert(buffer.end(), entry.data.begin(), entry.data.end());
+
+    // Write to a temporary file and then rename it, so that a reader never sees a partial 
+    // entry. Identical sprites on different threads may store the same entry at once.
+    fs::path path = entry_path(key);
+    std::error_code ec;
+    fs::create_directories(path.parent_path(), ec);
+
+    fs::path temp = path;
+    temp += ".tmp" + std::to_string(m_temp_index++);
+    {
+        std::ofstream os(temp, std::ios::binary);
+        os.write(buffer.data(), buffer.size());
+        if (!os)
+        {
+            fs::remove(temp, ec);
+            return;
+        }
+    }
+
+    // A failure to cache the sprite is not an error: it will just be compressed again.
+    fs::rename(temp, path, ec);
+    if (ec)
+    {
+        fs::remove(temp, ec);
+    }
+}
@@ -0,0 +1,70 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include "Record.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// A cache on disk of compressed sprites, so that an encode only compresses the sprites
+// which have changed since the last one. Each entry is a file named by a hash of the
+// pixels, the dimensions, the colour and chunking flags, the format, and the options which 
+// affect compression. Entries are decompressed and compared with the pixels before they
+// are used, so a stale or damaged entry is just a miss.
+class SpriteCache
+{
+public:
+    // Bump this whenever the encoders change their output, so that old entries are not used.
+    static constexpr uint32_t ENCODER_VERSION = 1;
+
+    struct Entry
+    {
+        uint8_t              compression  = 0; // The flags returned by RealSpriteRecord::encode_pixels().
+        uint8_t              chunk_gap    = 0; // The gap chosen by --auto_chunk_gap, or zero if none. 
+        uint32_t             chunked_size = 0; // Size of the chunked data for tile sprites.
+        std::vector<uint8_t> data;
+    };
+
+public:
+    static SpriteCache& cache();
+
+    // The cache is disabled until it has a directory.
+    void set_directory(const std::string& directory);
+    bool enabled() const { return !m_directory.empty(); }
+
+    // These are called while sprites are being encoded on several threads.
+    bool lookup(uint64_t key, const std::vector<uint8_t>& pixels, uint16_t xdim, uint16_t ydim, 
+        uint8_t colour, GRFFormat format, Entry& entry);
+    void store(uint64_t key, const Entry& entry);
+
+    uint32_t hits() const   { return m_hits; }
+    uint32_t misses() const { return m_misses; }
+
+private:
+    std::string entry_path(uint64_t key) const;
+    bool        read_entry(uint64_t key, Entry& entry) const;
+
+private:
+    std::string           m_directory;
+    std::atomic<uint32_t> m_hits{0};
+    std::atomic<uint32_t> m_misses{0};
+    std::atomic<uint32_t> m_temp_index{0};
+};
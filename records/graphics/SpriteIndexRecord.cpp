@@ -24,15 +24,16 @@
 #include "SpriteWrapperRecord.h"
 #include "NewGRFData.h"
 #include "CommandLineOptions.h"
+#include "ByteWriter.h"
 
 
-void SpriteIndexRecord::read(std::istream& is, const GRFInfo& info)
+void SpriteIndexRecord::read(ByteReader& is, const GRFInfo& info)
 {
     m_sprite_id = read_uint32(is);
 }
 
 
-void SpriteIndexRecord::write(std::ostream& os, const GRFInfo& info) const
+void SpriteIndexRecord::write(ByteWriter& os, const GRFInfo& info) const
 {
     write_uint32(os, m_sprite_id);
 }  
@@ -66,13 +67,62 @@ void SpriteIndexRecord::print(std::ostream& os, const SpriteZoomMap& sprites, ui
 }
 
 
+namespace {
+
+
+// True if the images given for a repeated sprite ID are the same as those stored for it.
+bool same_images(const SpriteZoomVector& images, const SpriteZoomVector& stored)
+{
+    if (images.size() != stored.size())
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < images.size(); ++i)
+    {
+        if (images[i]->record_type() != stored[i]->record_type())
+        {
+            return false;
+        }
+
+        if (images[i]->record_type() == RecordType::REAL_SPRITE)
+        {
+            const auto& image = static_cast<const RealSpriteRecord&>(*images[i]);
+            if (!image.same_content(static_cast<const RealSpriteRecord&>(*stored[i])))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            // Sound effects are compared by their binary data.
+            ByteWriter os1;
+            ByteWriter os2;
+            images[i]->write(os1, GRFInfo{});
+            stored[i]->write(os2, GRFInfo{});
+            if (os1.buffer() != os2.buffer())
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+} // namespace {
+
+
 void SpriteIndexRecord::parse(TokenStream& is, SpriteZoomMap& sprites)
 {
+    const TokenValue token = is.peek();
     is.match_ident(str_sprite_id);
     is.match(TokenType::OpenAngle);
     m_sprite_id = is.match_uint32();
     is.match(TokenType::CloseAngle);
 
+    SpriteZoomVector images;
     is.match(TokenType::OpenBrace);
     while (is.peek().type != TokenType::CloseBrace)
     {
@@ -99,16 +149,41 @@ void SpriteIndexRecord::parse(TokenStream& is, SpriteZoomMap& sprites)
             record = std::make_unique<SpriteWrapperRecord>(m_sprite_id, std::move(effect));
         }
 
-        // This adds the sprite to the m_sprites map inside NewGRFData.
-        //append_real_sprite(m_sprite_id, record);
-        // Sprites with the same ID are stored in map indexed by zoom level. 
-        // These maps are stored in a map index by the sprite ID.
-        if (sprites.find(m_sprite_id) == sprites.end())
+        images.push_back(std::move(record));
+    }
+
+    is.match(TokenType::CloseBrace);
+
+    // Several index records may refer to the same sprite in Container2 GRFs, and the 
+    // YAGL repeats its images for each of them. With --alias_sprites, the images are only 
+    // kept once, so they must be the same each time. Otherwise, they are written again for 
+    // each record, as they always have been.
+    const bool repeated = (sprites.find(m_sprite_id) != sprites.end());
+    if (repeated && CommandLineOptions::options().alias_sprites())
+    {
+        if (CommandLineOptions::options().reduce_colours() && !images.empty())
+        {
+            RealSpriteRecord::reduce_colour_depth(images);
+        }
+
+        if (!same_images(images, sprites[m_sprite_id]))
         {
-            sprites[m_sprite_id] = SpriteZoomVector{};
+            throw PARSER_ERROR("The images for sprite_id " + to_hex(m_sprite_id) + 
+                " differ from those given earlier for the same sprite_id", token);
         }
-        sprites[m_sprite_id].push_back(std::move(record));
+        return;
     }
 
-    is.match(TokenType::CloseBrace);
+    // Sprites with the same ID are stored in a vector of zoom levels. These vectors are 
+    // stored in a map indexed by the sprite ID.
+    for (auto& image: images)
+    {
+        sprites[m_sprite_id].push_back(std::move(image));
+    }
+
+    // All the images of the sprite are needed to decide whether they can be reduced.
+    if (CommandLineOptions::options().reduce_colours() && (sprites.find(m_sprite_id) != sprites.end()))
+    {
+        RealSpriteRecord::reduce_colour_depth(sprites[m_sprite_id]);
+    }
 }
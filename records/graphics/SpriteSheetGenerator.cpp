@@ -21,7 +21,11 @@
 #include "RealSpriteRecord.h"
 #include "CommandLineOptions.h"
 #include "SpriteIDLabel.h"
+#include "ConversionCache.h"
+#include "PixelPool.h"
+#include "Fnv1aHash.h"
 #include "png.hpp"
+#include <algorithm>
 #include <sstream>
 #include "FileSystem.h"
 
@@ -38,6 +42,7 @@ SpriteSheetGenerator::SpriteSheetGenerator(const std::map<uint32_t, SpriteZoomVe
 void SpriteSheetGenerator::generate()
 {
     partition_sprites();
+    remove_unused_sheets();
 }
 
 
@@ -123,6 +128,133 @@ void SpriteSheetGenerator::partition_sprites()
 
 
 void SpriteSheetGenerator::layout_sprites(Category category, SpriteVector sprites)
+{
+    // Sprites which are copies of one already placed in the sheet can use the same pixels.
+    // They are given its position once the sprite sheets have been written.
+    const bool dedup = CommandLineOptions::options().dedup_sprites();
+    std::map<const std::vector<uint8_t>*, const RealSpriteRecord*> placed;
+    std::vector<std::pair<RealSpriteRecord*, const RealSpriteRecord*>> copies;
+
+    // With --incremental, the sprites are put back where they were in the sprite sheets
+    // written by the last decode. A sprite ID can have more than one image in a category,
+    // so the images are numbered.
+    SpriteSheetLayout& layout = SpriteSheetLayout::layout();
+    SpriteKeyMap keys;
+    std::map<uint32_t, uint16_t> images;
+
+    SpriteVector unique;
+    for (const auto sprite: sprites)
+    {
+        if (layout.enabled())
+        {
+            keys[sprite] = SpriteSheetLayout::SpriteKey{static_cast<uint8_t>(category.zoom), 
+                static_cast<uint8_t>(category.colour), sprite->sprite_id(), images[sprite->sprite_id()]++};
+        }
+
+        if (dedup)
+        {
+            auto it = placed.find(&sprite->pixels());
+            if ((it != placed.end()) && sprite->same_image(*it->second))
+            {
+                copies.push_back({sprite, it->second});
+                continue;
+            }
+            placed[&sprite->pixels()] = sprite;
+        }
+
+        unique.push_back(sprite);
+    }
+
+    SheetMap sheets;
+    if (layout.enabled())
+    {
+        pack_sprites(category, reuse_layout(category, unique, keys, sheets), sheets);
+    }
+    else
+    {
+        pack_sprites(category, unique, sheets);
+    }
+
+    for (auto& [index, sheet]: sheets)
+    {
+        // Reused sprites are drawn in the same order as they would be if packed, so that
+        // the labels come out the same.
+        std::stable_sort(sheet.sprites.begin(), sheet.sprites.end(), 
+            [category](const RealSpriteRecord* a, const RealSpriteRecord* b)
+            {
+                return std::make_pair(position_y(category, a), position_x(category, a)) < 
+                       std::make_pair(position_y(category, b), position_x(category, b));
+            });
+
+        create_sprite_sheet(category, sheet.sprites, index, sheet.width, sheet.height);
+
+        if (layout.enabled())
+        {
+            for (const auto sprite: sheet.sprites)
+            {
+                layout.set_placement(keys.at(sprite), SpriteSheetLayout::Placement{index, 
+                    position_x(category, sprite), position_y(category, sprite), sprite->xdim(), sprite->ydim()});
+            }
+        }
+    }
+
+    for (const auto& copy: copies)
+    {
+        RealSpriteRecord*       sprite   = copy.first;
+        const RealSpriteRecord* original = copy.second;
+        if (category.colour == ColourType::Mask)
+        {
+            sprite->set_mask_xoff(original->mask_xoff());
+            sprite->set_mask_yoff(original->mask_yoff());
+            sprite->set_mask_filename(original->mask_filename());
+        }
+        else
+        {
+            sprite->set_xoff(original->xoff());
+            sprite->set_yoff(original->yoff());
+            sprite->set_filename(original->filename());
+        }
+    }
+}
+
+
+// Returns the sprites which could not be put back in the same place as before.
+SpriteSheetGenerator::SpriteVector SpriteSheetGenerator::reuse_layout(Category category, 
+    const SpriteVector& sprites, const SpriteKeyMap& keys, SheetMap& sheets)
+{
+    const SpriteSheetLayout& layout = SpriteSheetLayout::layout();
+
+    SpriteVector others;
+    for (const auto sprite: sprites)
+    {
+        // A sprite whose size has changed no longer fits the space it had. Sheets keep
+        // their size, even if some of their sprites have gone.
+        SpriteSheetLayout::Placement placement;
+        SpriteSheetLayout::Sheet     previous;
+        if (layout.find_placement(keys.at(sprite), placement) && 
+            (placement.xdim == sprite->xdim()) && (placement.ydim == sprite->ydim()) &&
+            layout.find_sheet(SpriteSheetLayout::SheetKey{static_cast<uint8_t>(category.zoom), 
+                static_cast<uint8_t>(category.colour), placement.sheet}, previous) &&
+            ((placement.xoff + placement.xdim) <= previous.width) && 
+            ((placement.yoff + placement.ydim) <= previous.height))
+        {
+            Sheet& sheet = sheets[placement.sheet];
+            sheet.width  = previous.width;
+            sheet.height = previous.height;
+            sheet.sprites.push_back(sprite);
+            set_position(category, sprite, placement.xoff, placement.yoff);
+        }
+        else
+        {
+            others.push_back(sprite);
+        }
+    }
+
+    return others;
+}
+
+
+void SpriteSheetGenerator::pack_sprites(Category category, const SpriteVector& sprites, SheetMap& sheets)
 {
     // Constants
     const uint32_t max_width  = CommandLineOptions::options().width();
@@ -130,6 +262,11 @@ void SpriteSheetGenerator::layout_sprites(Category category, SpriteVector sprite
     const uint32_t xmargin    = 10; 
     const uint32_t ymargin    = 10;
 
+    if (sprites.empty())
+    {
+        return;
+    }
+
     // Image file index
     uint16_t index = 0;
 
@@ -142,7 +279,46 @@ void SpriteSheetGenerator::layout_sprites(Category category, SpriteVector sprite
     uint32_t xoffset    = xmargin;  
     uint32_t yoffset    = ymargin;
 
+    // Sprites are added in new rows after any already on the last sheet, unless the first 
+    // row would make it taller than the limit. Then they start a new sheet.
+    if (!sheets.empty())
+    {
+        uint32_t first_row = 0;
+        uint32_t x         = xmargin;
+        for (const auto sprite: sprites)
+        {
+            if ((x + sprite->xdim() + xmargin) > max_width)
+            {
+                break;
+            }
+            first_row = std::max<uint32_t>(first_row, sprite->ydim());
+            x        += sprite->xdim() + xmargin;
+        }
+
+        const Sheet& last = sheets.rbegin()->second;
+        index = sheets.rbegin()->first;
+        if ((last.height + first_row + ymargin) > max_height)
+        {
+            ++index;
+        }
+        else
+        {
+            image_width  = last.width;
+            image_height = last.height;
+            yoffset      = image_height;
+        }
+    }
+
     SpriteVector layout;
+    auto add_sheet = [&]()
+    {
+        Sheet& sheet = sheets[index];
+        sheet.width  = std::max(sheet.width, image_width);
+        sheet.height = std::max(sheet.height, image_height);
+        sheet.sprites.insert(sheet.sprites.end(), layout.begin(), layout.end());
+        layout.clear();
+    };
+
     for (const auto sprite: sprites)
     {
         if ((xoffset + sprite->xdim() + xmargin) > max_width)
@@ -157,8 +333,7 @@ void SpriteSheetGenerator::layout_sprites(Category category, SpriteVector sprite
             // problem? Nah.
             if (image_height > max_height)
             {
-                create_sprite_sheet(category, layout, index, image_width, image_height);
-                layout.clear(); 
+                add_sheet();
 
                 image_width  = 0;
                 image_height = 0;
@@ -167,19 +342,7 @@ void SpriteSheetGenerator::layout_sprites(Category category, SpriteVector sprite
             }
         }
 
-        // Distinguish mask from regular file offsets. This is only relevant for 
-        // RGB[A]P sprites.
-        if (category.colour == ColourType::Mask)
-        {
-            sprite->set_mask_xoff(xoffset);
-            sprite->set_mask_yoff(yoffset);
-        }
-        else
-        {
-            sprite->set_xoff(xoffset);
-            sprite->set_yoff(yoffset);
-        }
-        
+        set_position(category, sprite, xoffset, yoffset);
         layout.push_back(sprite);
 
         row_height   = std::max<uint32_t>(row_height, sprite->ydim());
@@ -188,12 +351,62 @@ void SpriteSheetGenerator::layout_sprites(Category category, SpriteVector sprite
     }  
 
     image_height = std::max(image_height, yoffset + row_height + ymargin);
-    create_sprite_sheet(category, layout, index, image_width, image_height);
+    add_sheet();
 }
 
 
-void SpriteSheetGenerator::create_sprite_sheet(Category category, SpriteVector sprites, 
-    uint32_t index, uint32_t width, uint32_t height)
+void SpriteSheetGenerator::set_position(Category category, RealSpriteRecord* sprite, uint32_t xoff, uint32_t yoff)
+{
+    // Distinguish mask from regular file offsets. This is only relevant for 
+    // RGB[A]P sprites.
+    if (category.colour == ColourType::Mask)
+    {
+        sprite->set_mask_xoff(xoff);
+        sprite->set_mask_yoff(yoff);
+    }
+    else
+    {
+        sprite->set_xoff(xoff);
+        sprite->set_yoff(yoff);
+    }
+}
+
+
+uint32_t SpriteSheetGenerator::position_x(Category category, const RealSpriteRecord* sprite)
+{
+    return (category.colour == ColourType::Mask) ? sprite->mask_xoff() : sprite->xoff();
+}
+
+
+uint32_t SpriteSheetGenerator::position_y(Category category, const RealSpriteRecord* sprite)
+{
+    return (category.colour == ColourType::Mask) ? sprite->mask_yoff() : sprite->yoff();
+}
+
+
+// A hash of everything which is drawn on a sprite sheet.
+uint64_t SpriteSheetGenerator::sheet_hash(Category category, const SpriteVector& sprites, 
+    uint32_t width, uint32_t height) const
+{
+    // Each value is mixed in whole.
+    Fnv1aHash hash;
+    hash.add_word(SpriteSheetLayout::LAYOUT_VERSION);
+    hash.add_word(width);
+    hash.add_word(height);
+    // The palette is used for 8bpp sheets and masks.
+    hash.add_word(static_cast<uint64_t>(CommandLineOptions::options().palette()));
+    for (const auto sprite: sprites)
+    {
+        hash.add_word(sprite->sprite_id());
+        hash.add_word(position_x(category, sprite));
+        hash.add_word(position_y(category, sprite));
+        hash.add_word(PixelPool::hash(sprite->pixels(), sprite->xdim(), sprite->ydim(), sprite->colour()));
+    }
+    return hash.value();
+}
+
+
+std::string SpriteSheetGenerator::sheet_path(Category category, uint32_t index) const
 {
     // Manufacture a file name for the sprite sheet. Maybe it makes
     // no sense to partition the sprites by zoom level, but let's do it 
@@ -229,7 +442,50 @@ void SpriteSheetGenerator::create_sprite_sheet(Category category, SpriteVector s
         case ZoomLevel::ZoomOutX8: os << "-zout8-";  break;
     }
     os << index << ".png";
-    const std::string image_path = os.str();
+    return os.str();
+}
+
+
+void SpriteSheetGenerator::create_sprite_sheet(Category category, SpriteVector sprites, 
+    uint32_t index, uint32_t width, uint32_t height)
+{
+    const std::string image_path = sheet_path(category, index);
+
+    ConversionCache::cache().add_output(image_path);
+
+    // With --incremental, a sprite sheet is left alone if the same sprites would be drawn 
+    // on it in the same places as in the last decode, and the file has not been changed.
+    SpriteSheetLayout& layout = SpriteSheetLayout::layout();
+    const SpriteSheetLayout::SheetKey key{static_cast<uint8_t>(category.zoom), 
+        static_cast<uint8_t>(category.colour), static_cast<uint16_t>(index)};
+    SpriteSheetLayout::Sheet sheet{width, height, 0, 0};
+    if (layout.enabled())
+    {
+        sheet.content_hash = sheet_hash(category, sprites, width, height);
+
+        SpriteSheetLayout::Sheet previous;
+        if (layout.find_sheet(key, previous) && (previous.content_hash == sheet.content_hash) &&
+            ConversionCache::hash_file(image_path, sheet.file_hash) && (previous.file_hash == sheet.file_hash))
+        {
+            std::cout << "Keeping sprite sheet: " << image_path << "..." << std::endl;
+            std::string image_file = fs::path(image_path).filename().string();
+            for (const auto sprite: sprites)
+            {
+                if (category.colour == ColourType::Mask)
+                {
+                    sprite->set_mask_filename(image_file);
+                }
+                else
+                {
+                    sprite->set_filename(image_file);
+                }
+            }
+
+            layout.set_sheet(key, sheet);
+            layout.keep_sheet();
+            return;
+        }
+    }
 
     std::cout << "Writing sprite sheet: " << image_path << "..." << std::endl;
 
@@ -249,6 +505,46 @@ void SpriteSheetGenerator::create_sprite_sheet(Category category, SpriteVector s
             create_sprite_sheet_mask(image_path, sprites, width, height);
             break;
     }
+
+    if (layout.enabled())
+    {
+        ConversionCache::hash_file(image_path, sheet.file_hash);
+        layout.set_sheet(key, sheet);
+    }
+}
+
+
+// With --incremental, a sheet from the last decode which now has no sprites on it would be 
+// left behind. It is removed, unless it has been edited since it was written.
+void SpriteSheetGenerator::remove_unused_sheets() const
+{
+    const SpriteSheetLayout& layout = SpriteSheetLayout::layout();
+    if (!layout.enabled())
+    {
+        return;
+    }
+
+    for (const auto& [key, sheet]: layout.unused_sheets())
+    {
+        const Category    category{static_cast<ZoomLevel>(key.zoom), static_cast<ColourType>(key.colour)};
+        const std::string image_path = sheet_path(category, key.index);
+
+        uint64_t file_hash = 0;
+        if (!ConversionCache::hash_file(image_path, file_hash))
+        {
+            continue;
+        }
+
+        if (file_hash == sheet.file_hash)
+        {
+            std::cout << "Removing unused sprite sheet: " << image_path << "..." << std::endl;
+            fs::remove(image_path);
+        }
+        else
+        {
+            std::cout << "WARNING: Sprite sheet " << image_path << " is no longer used, but has been edited so it was not removed." << std::endl;
+        }
+    }
 }
 
 
@@ -18,6 +18,7 @@
 ///////////////////////////////////////////////////////////////////////////////
 #pragma once 
 #include "RealSpriteRecord.h"
+#include "SpriteSheetLayout.h"
 
 
 class SpriteSheetGenerator
@@ -54,14 +55,35 @@ class SpriteSheetGenerator
             }
         };
 
+        // The sprites placed on each sprite sheet of a category, indexed by the number of the sheet.
+        struct Sheet
+        {
+            uint32_t     width  = 0;
+            uint32_t     height = 0;
+            SpriteVector sprites;
+        };
+        using SheetMap     = std::map<uint16_t, Sheet>;
+        using SpriteKeyMap = std::map<const RealSpriteRecord*, SpriteSheetLayout::SpriteKey>;
+
     private:
         void partition_sprites();
         void partition_sprite(std::map<Category, SpriteVector>& partitions, 
             Category cat, RealSpriteRecord* sprite);
         void layout_sprites(Category category, SpriteVector sprites);
+        SpriteVector reuse_layout(Category category, const SpriteVector& sprites, 
+            const SpriteKeyMap& keys, SheetMap& sheets);
+        void pack_sprites(Category category, const SpriteVector& sprites, SheetMap& sheets);
+
+        // Masks are placed separately from the images they belong to.
+        static void     set_position(Category category, RealSpriteRecord* sprite, uint32_t xoff, uint32_t yoff);
+        static uint32_t position_x(Category category, const RealSpriteRecord* sprite);
+        static uint32_t position_y(Category category, const RealSpriteRecord* sprite);
+        uint64_t sheet_hash(Category category, const SpriteVector& sprites, uint32_t width, uint32_t height) const;
 
+        std::string sheet_path(Category category, uint32_t index) const;
         void create_sprite_sheet(Category category, SpriteVector sprites, 
             uint32_t index, uint32_t width, uint32_t height);
+        void remove_unused_sheets() const;
 
         // png++ uses a template for different colour depths. This is not 
         // dynamic polymorphism, so create methods to handle the cases we need.
@@ -0,0 +1,200 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#include "SpriteSheetLayout.h"
+#include "Exceptions.h"
+#include "FileSystem.h"
+#include <fstream>
+#include <sstream>
+#include <tuple>
+
+
+bool SpriteSheetLayout::SheetKey::operator<(const SheetKey& other) const
+{
+    return std::tie(zoom, colour, index) < std::tie(other.zoom, other.colour, other.index);
+}
+
+
+bool SpriteSheetLayout::SpriteKey::operator<(const SpriteKey& other) const
+{
+    return std::tie(zoom, colour, sprite_id, image) < std::tie(other.zoom, other.colour, other.sprite_id, other.image);
+}
+
+
+SpriteSheetLayout& SpriteSheetLayout::layout()
+{
+    static SpriteSheetLayout instance;
+    return instance;
+}
+
+
+void SpriteSheetLayout::load(const std::string& file_name)
+{
+    m_enabled = true;
+    m_previous_sheets.clear();
+    m_previous_placements.clear();
+    m_sheets.clear();
+    m_placements.clear();
+    m_kept_sheets = 0;
+
+    if (!fs::is_regular_file(file_name))
+    {
+        return;
+    }
+
+    std::ifstream is(file_name);
+    std::string   line;
+    while (std::getline(is, line))
+    {
+        if (line.empty() || (line[0] == '#'))
+        {
+            continue;
+        }
+
+        // Each line is one of:
+        //   version <version>
+        //   sheet <zoom> <colour> <index> <width> <height> <content_hash> <file_hash>
+        //   sprite <zoom> <colour> <sprite_id> <image> <sheet> <xoff> <yoff> <xdim> <ydim>
+        std::istringstream ss(line);
+        std::string type;
+        uint32_t    zoom   = 0;
+        uint32_t    colour = 0;
+        bool        valid  = false;
+        ss >> type;
+        if (type == "version")
+        {
+            uint32_t version = 0;
+            valid = bool(ss >> version);
+            if (valid && (version != LAYOUT_VERSION))
+            {
+                // Everything will be laid out and drawn again.
+                m_previous_sheets.clear();
+                m_previous_placements.clear();
+                return;
+            }
+        }
+        else if (type == "sheet")
+        {
+            uint32_t index = 0;
+            Sheet    sheet{};
+            valid = bool(ss >> zoom >> colour >> index >> sheet.width >> sheet.height >> 
+                std::hex >> sheet.content_hash >> sheet.file_hash);
+            valid = valid && (zoom <= 0xFF) && (colour <= 0xFF) && (index <= 0xFFFF);
+            m_previous_sheets[SheetKey{uint8_t(zoom), uint8_t(colour), uint16_t(index)}] = sheet;
+        }
+        else if (type == "sprite")
+        {
+            uint32_t  sprite_id = 0;
+            uint32_t  image     = 0;
+            uint32_t  sheet     = 0;
+            uint32_t  xdim      = 0;
+            uint32_t  ydim      = 0;
+            Placement placement{};
+            valid = bool(ss >> zoom >> colour >> sprite_id >> image >> sheet >> 
+                placement.xoff >> placement.yoff >> xdim >> ydim);
+            valid = valid && (zoom <= 0xFF) && (colour <= 0xFF) && (image <= 0xFFFF) && 
+                (sheet <= 0xFFFF) && (xdim <= 0xFFFF) && (ydim <= 0xFFFF);
+            placement.sheet = uint16_t(sheet);
+            placement.xdim  = uint16_t(xdim);
+            placement.ydim  = uint16_t(ydim);
+            m_previous_placements[SpriteKey{uint8_t(zoom), uint8_t(colour), sprite_id, uint16_t(image)}] = placement;
+        }
+
+        if (!valid)
+        {
+            std::ostringstream os;
+            os << "Invalid line in sprite sheet layout file " << file_name << ": " << line;
+            throw RUNTIME_ERROR(os.str());
+        }
+    }
+}
+
+
+void SpriteSheetLayout::save(const std::string& file_name) const
+{
+    std::ofstream os(file_name);
+    if (os.fail())
+    {
+        throw RUNTIME_ERROR("Error opening file for writing: " + file_name);
+    }
+
+    os << "# Sprite sheet layout written by yagl --incremental\n";
+    os << "version " << LAYOUT_VERSION << '\n';
+    for (const auto& [key, sheet]: m_sheets)
+    {
+        os << "sheet " << uint16_t(key.zoom) << ' ' << uint16_t(key.colour) << ' ' << key.index << ' ';
+        os << sheet.width << ' ' << sheet.height << ' ';
+        os << std::hex << sheet.content_hash << ' ' << sheet.file_hash << std::dec << '\n';
+    }
+    for (const auto& [key, placement]: m_placements)
+    {
+        os << "sprite " << uint16_t(key.zoom) << ' ' << uint16_t(key.colour) << ' ' << key.sprite_id << ' ' << key.image << ' ';
+        os << placement.sheet << ' ' << placement.xoff << ' ' << placement.yoff << ' ';
+        os << placement.xdim << ' ' << placement.ydim << '\n';
+    }
+}
+
+
+bool SpriteSheetLayout::find_sheet(const SheetKey& key, Sheet& sheet) const
+{
+    auto it = m_previous_sheets.find(key);
+    if (it == m_previous_sheets.end())
+    {
+        return false;
+    }
+    sheet = it->second;
+    return true;
+}
+
+
+bool SpriteSheetLayout::find_placement(const SpriteKey& key, Placement& placement) const
+{
+    auto it = m_previous_placements.find(key);
+    if (it == m_previous_placements.end())
+    {
+        return false;
+    }
+    placement = it->second;
+    return true;
+}
+
+
+void SpriteSheetLayout::set_sheet(const SheetKey& key, const Sheet& sheet)
+{
+    m_sheets[key] = sheet;
+}
+
+
+void SpriteSheetLayout::set_placement(const SpriteKey& key, const Placement& placement)
+{
+    m_placements[key] = placement;
+}
+
+
+std::map<SpriteSheetLayout::SheetKey, SpriteSheetLayout::Sheet> SpriteSheetLayout::unused_sheets() const
+{
+    std::map<SheetKey, Sheet> sheets;
+    for (const auto& [key, sheet]: m_previous_sheets)
+    {
+        if (m_sheets.find(key) == m_sheets.end())
+        {
+            sheets[key] = sheet;
+        }
+    }
+    return sheets;
+}
@@ -0,0 +1,102 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <cstdint>
+#include <map>
+#include <string>
+
+
+// The positions of the sprites in the sprite sheets written by a decode, and a hash of the
+// contents of each sheet. This is saved next to the YAGL script so that a later decode of 
+// a newer version of the GRF can put the sprites which are still there in the same places, 
+// and leave the sprite sheets which have not changed alone. 
+class SpriteSheetLayout
+{
+public:
+    // Bump this whenever the way sprite sheets are drawn changes, so that they are redrawn.
+    static constexpr uint32_t LAYOUT_VERSION = 1;
+
+    // Sprite sheets are identified by their category (zoom and colour) and index.
+    struct SheetKey
+    {
+        uint8_t  zoom;
+        uint8_t  colour;
+        uint16_t index;
+
+        bool operator<(const SheetKey& other) const;
+    };
+
+    struct Sheet
+    {
+        uint32_t width;
+        uint32_t height;
+        uint64_t content_hash; // The sprites drawn on the sheet, and where.
+        uint64_t file_hash;    // The PNG file, so that a sheet which has been edited is redrawn.
+    };
+
+    // A sprite ID can have more than one image of the same category, so these are numbered.
+    struct SpriteKey
+    {
+        uint8_t  zoom;
+        uint8_t  colour;
+        uint32_t sprite_id;
+        uint16_t image;
+
+        bool operator<(const SpriteKey& other) const;
+    };
+
+    struct Placement
+    {
+        uint16_t sheet;
+        uint32_t xoff;
+        uint32_t yoff;
+        uint16_t xdim;
+        uint16_t ydim;
+    };
+
+public:
+    static SpriteSheetLayout& layout();
+
+    // The layout is disabled until it has been loaded, even if the file does not exist. 
+    void load(const std::string& file_name);
+    void save(const std::string& file_name) const;
+    bool enabled() const { return m_enabled; }
+
+    // The previous layout is looked up, and the new one built up as sheets are created.
+    bool find_sheet(const SheetKey& key, Sheet& sheet) const;
+    bool find_placement(const SpriteKey& key, Placement& placement) const;
+    void set_sheet(const SheetKey& key, const Sheet& sheet);
+    void set_placement(const SpriteKey& key, const Placement& placement);
+
+    // The sheets of the previous layout which have not been set in the new one.
+    std::map<SheetKey, Sheet> unused_sheets() const;
+
+    uint32_t kept_sheets() const { return m_kept_sheets; }
+    void     keep_sheet()        { ++m_kept_sheets; }
+
+private:
+    bool m_enabled = false;
+
+    std::map<SheetKey, Sheet>      m_previous_sheets;
+    std::map<SpriteKey, Placement> m_previous_placements;
+    std::map<SheetKey, Sheet>      m_sheets;
+    std::map<SpriteKey, Placement> m_placements;
+
+    uint32_t m_kept_sheets = 0;
+};
@@ -17,6 +17,7 @@
 // along with yagl. If not, see <https://www.gnu.org/licenses/>.
 ///////////////////////////////////////////////////////////////////////////////
 #include "SpriteSheetReader.h"
+#include "ConversionCache.h"
 
 
 // class RGBSpriteSheet : public SpriteSheet
@@ -104,6 +105,7 @@ SpriteSheet& SpriteSheetPool::get_sprite_sheet(const std::string file_name, Spri
         using Colour = SpriteSheet::Colour;
 
         std::cout << "Opening sprite sheet: " << file_name << "..." << std::endl;
+        ConversionCache::cache().add_input(file_name);
 
         std::unique_ptr<SpriteSheet> sheet;
         switch (colour)
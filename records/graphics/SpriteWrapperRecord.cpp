@@ -21,24 +21,23 @@
 #include <sstream>
 
 
-void SpriteWrapperRecord::read(std::istream& is, const GRFInfo& info)
+void SpriteWrapperRecord::read(ByteReader& is, const GRFInfo& info)
 {
     // Nothing to read as this is done externally.
 }
 
 
-void SpriteWrapperRecord::write(std::ostream& os, const GRFInfo& info) const
+void SpriteWrapperRecord::write(ByteWriter& os, const GRFInfo& info) const
 {
     // sprite ID
-    std::ostringstream ss;
-    m_sprite->write(ss, info);
-    uint32_t size = static_cast<uint32_t>(ss.str().size());
-    
     write_uint32(os, m_sprite_id);
-    write_uint32(os, size + 1); // +1 to account for the extra 0xFF.
-    write_uint8(os, 0xFF);
 
+    // The size is filled in once the sprite has been written.
+    size_t size_pos = os.reserve_uint32();
+    size_t start    = os.position();
+    write_uint8(os, 0xFF);
     m_sprite->write(os, info);
+    os.patch_uint32(size_pos, uint32_t(os.position() - start)); // Includes the extra 0xFF.
 }  
 
 
@@ -19,6 +19,40 @@
 #pragma once
 #include "catch.hpp"
 #include "StreamHelpers.h"
+#include "Record.h"
+#include "CommandLineOptions.h"
+#include <cstring>
+#include <string>
+#include <vector>
+
+
+// Sets the command line options for the duration of a test, and puts back the previous 
+// ones afterwards. The arguments are those which would follow "yagl -t" on the command 
+// line, such as the GRF file and YAGL directory and any optional arguments. With none, the 
+// optional arguments take their default values.
+class TestOptions
+{
+public:
+    TestOptions(std::vector<std::string> args = {})
+    : m_saved{CommandLineOptions::options()}
+    {
+        args.insert(args.begin(), {"yagl", "-t"});
+        std::vector<char*> argv;
+        for (auto& arg: args)
+        {
+            argv.push_back(arg.data());
+        }
+        CommandLineOptions::options().parse(int(argv.size()), argv.data());
+    }
+
+    ~TestOptions()
+    {
+        CommandLineOptions::options() = m_saved;
+    }
+
+private:
+    CommandLineOptions m_saved;
+};
 
 
 template <typename ActionRecord, uint8_t ACTION>
@@ -81,17 +115,17 @@ void test_yagl(const char* YAGL_IN, const char* NFO, const char* YAGL_OUT = null
     }
 
     // Confirm that the written binary matches the sample.
-    os.str("");
     GRFInfo info; // Defaults to Container2 and GRF8.
-    action.write(os, info);
-    auto str = os.str();
+    ByteWriter bos;
+    action.write(bos, info);
+    std::string str{bos.buffer().begin(), bos.buffer().end()};
     CHECK(str.size() == (std::strlen(NFO) / 3));
     CHECK(hex_dump(str) == NFO);
 
     // Confirm that reading the binary and printing the 
     // result gets us back to the example.
-    std::istringstream is2(str);
-    CHECK(uint8_t(is2.get()) == ACTION);
+    ByteReader is2{bos.buffer().data(), bos.buffer().size()};
+    CHECK(is2.read_uint8() == ACTION);
     ActionRecord action2;
     action2.read(is2, info);
     os.str("");
@@ -132,17 +166,17 @@ void test_container(const char* YAGL_IN, const char* NFO, const char* YAGL_OUT =
     }
 
     // Confirm that the written binary matches the sample.
-    os.str("");
     GRFInfo info; // Defaults to Container2 and GRF8.
-    action.write(os, info);
-    auto str = os.str();
+    ByteWriter bos;
+    action.write(bos, info);
+    std::string str{bos.buffer().begin(), bos.buffer().end()};
     CHECK(str.size() == (std::strlen(NFO) / 3));
     CHECK(hex_dump(str) == NFO);
 
     // Confirm that reading the binary and printing the 
     // result gets us back to the example.
-    std::istringstream is2(str);
-    CHECK(uint8_t(is2.get()) == ACTION);
+    ByteReader is2{bos.buffer().data(), bos.buffer().size()};
+    CHECK(is2.read_uint8() == ACTION);
 
     // Don't test that the read content matches. This is because we don't 
     // read and write the child records which contain the actual sprites, nor
@@ -83,17 +83,17 @@ void test_yagl_action07(const char* YAGL, const char* NFO)
     CHECK(os.str() == YAGL);
 
     // Confirm that the written binary matches the sample.
-    os.str("");
     GRFInfo info; // Defaults to Container2 and GRF8.
-    action.write(os, info);
-    auto str = os.str();
+    ByteWriter bos;
+    action.write(bos, info);
+    std::string str{bos.buffer().begin(), bos.buffer().end()};
     CHECK(str.size() == (std::strlen(NFO) / 3));
     CHECK(hex_dump(str) == NFO);
 
     // Confirm that reading the binary and printing the 
     // result gets us back to the example.
-    std::istringstream is2(str);
-    CHECK(uint8_t(is2.get()) == ACTION);
+    ByteReader is2{bos.buffer().data(), bos.buffer().size()};
+    CHECK(is2.read_uint8() == ACTION);
     Action07Record action2{TYPE};
     action2.read(is2, info);
     os.str("");
@@ -0,0 +1,90 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#include "catch.hpp"
+#include "ByteReader.h"
+#include "StreamHelpers.h"
+#include <array>
+
+
+TEST_CASE("ByteReader tests", "[integers]")
+{
+    static constexpr std::array<uint8_t, 11> data =
+        { 0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF0, 0x11, 0x22, 0x33 };
+
+    SECTION("Little-endian values")
+    {
+        ByteReader is{data.data(), data.size()};
+        CHECK(is.read_uint8()  == 0x12);
+        CHECK(is.read_uint16() == 0x5634);
+        CHECK(is.read_uint32() == 0xDEBC9A78);
+        CHECK(is.position()    == 7);
+        CHECK(is.remaining()   == 4);
+        CHECK(!is.at_end());
+    }
+
+    SECTION("Reading past the end throws")
+    {
+        ByteReader is{data.data(), data.size()};
+        is.skip(8);
+        CHECK_THROWS(is.read_uint32());
+        // The failed read does not move the cursor.
+        CHECK(is.position() == 8);
+        CHECK(is.read_uint16() == 0x2211);
+        CHECK_THROWS(is.read_uint16());
+        CHECK(is.read_uint8() == 0x33);
+        CHECK(is.at_end());
+        CHECK_THROWS(is.read_uint8());
+        CHECK_THROWS(is.read_bytes(1));
+        CHECK_THROWS(is.seek(12));
+    }
+
+    SECTION("Byte spans are views into the buffer")
+    {
+        ByteReader is{data.data(), data.size()};
+        is.seek(3);
+        const uint8_t* bytes = is.read_bytes(4);
+        CHECK(bytes == &data[3]);
+        CHECK(is.position() == 7);
+    }
+
+    SECTION("Peeking does not consume")
+    {
+        ByteReader is{data.data(), data.size()};
+        is.seek(10);
+        CHECK(is.peek() == 0x33);
+        CHECK(is.position() == 10);
+        is.skip(1);
+        CHECK(is.peek() == EOF);
+    }
+
+    SECTION("Stream helpers")
+    {
+        ByteReader is{data.data() + 1, data.size() - 1};
+        CHECK(read_uint<uint16_t>(is) == 0x5634);
+        CHECK(read_uint<uint32_t>(is) == 0xDEBC9A78);
+        CHECK(read_uint<uint8_t>(is)  == 0xF0);
+        CHECK(read_uint8_ext(is)      == 0x11);
+
+        // Extended bytes with a 0xFF prefix.
+        static constexpr std::array<uint8_t, 3> ext = { 0xFF, 0x34, 0x12 };
+        ByteReader is2{ext.data(), ext.size()};
+        CHECK(read_uint<uint16_t, true>(is2) == 0x1234);
+        CHECK_THROWS(read_uint8(is2));
+    }
+}
@@ -0,0 +1,86 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#include "catch.hpp"
+#include "ByteWriter.h"
+#include "StreamHelpers.h"
+#include <sstream>
+
+
+static std::string to_string(const std::vector<uint8_t>& data)
+{
+    return std::string(data.begin(), data.end());
+}
+
+
+TEST_CASE("ByteWriter tests", "[integers]")
+{
+    SECTION("Little-endian values")
+    {
+        ByteWriter os;
+        os.write_uint8(0x12);
+        os.write_uint16(0x5634);
+        os.write_uint32(0xDEBC9A78);
+        CHECK(os.position() == 7);
+        CHECK(hex_dump(to_string(os.buffer())) == "12 34 56 78 9A BC DE ");
+    }
+
+    SECTION("Back-patched lengths")
+    {
+        ByteWriter os;
+        os.write_uint8(0xFF);
+        size_t pos16 = os.reserve_uint16();
+        size_t pos32 = os.reserve_uint32();
+        os.write_uint8(0xEE);
+        os.patch_uint16(pos16, 0x0201);
+        os.patch_uint32(pos32, 0x06050403);
+        CHECK(hex_dump(to_string(os.buffer())) == "FF 01 02 03 04 05 06 EE ");
+        CHECK_THROWS(os.patch_uint32(6, 0));
+    }
+
+    SECTION("Stream helpers")
+    {
+        ByteWriter os;
+        write_uint<uint8_t>(os, 0x01);
+        write_uint<uint16_t>(os, 0x0302);
+        write_uint<uint32_t>(os, 0x07060504);
+        write_uint<uint16_t, true>(os, 0x0908);
+        write_uint8_ext(os, 0x0A, ExtByteFormat::Short);
+        CHECK(hex_dump(to_string(os.buffer())) == "01 02 03 04 05 06 07 FF 08 09 0A ");
+    }
+
+    SECTION("Flushing to a sink")
+    {
+        std::ostringstream sink;
+        ByteWriter os{&sink};
+        os.write_uint32(0x04030201);
+        os.flush();
+        CHECK(sink.str().empty());
+        os.flush(true);
+        CHECK(hex_dump(sink.str()) == "01 02 03 04 ");
+        CHECK(os.buffer().empty());
+        CHECK(os.position() == 4);
+
+        // Reserved values which have been flushed cannot be patched.
+        size_t pos = os.reserve_uint16();
+        CHECK(pos == 4);
+        os.flush(true);
+        CHECK_THROWS(os.patch_uint16(pos, 0xFFFF));
+        CHECK(hex_dump(sink.str()) == "01 02 03 04 00 00 ");
+    }
+}
@@ -0,0 +1,189 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#include "catch.hpp"
+#include "ChunkEncoder.h"
+#include "RealSpriteRecord.h"
+#include "FileSystem.h"
+#include <fstream>
+#include <random>
+
+
+// An image with transparent stripes and some completely empty rows. Transparent pixels are
+// all zero, as the decoder leaves them.
+static std::vector<uint8_t> make_image(uint16_t xdim, uint16_t ydim, uint16_t pixel_size)
+{
+    const uint16_t trans_offset = (pixel_size == 1) ? 0 : 3;
+
+    std::mt19937 rng{42};
+    std::vector<uint8_t> pixels(xdim * ydim * pixel_size, 0);
+    for (uint16_t y = 0; y < ydim; ++y)
+    {
+        if ((y % 4) == 1)
+        {
+            continue;
+        }
+
+        for (uint16_t x = 0; x < xdim; ++x)
+        {
+            if (((x / 7) % 3) == 0)
+            {
+                continue;
+            }
+
+            uint8_t* pixel = &pixels[(y * xdim + x) * pixel_size];
+            for (uint16_t p = 0; p < pixel_size; ++p)
+            {
+                pixel[p] = uint8_t(rng());
+            }
+            pixel[trans_offset] |= 0x01;
+        }
+    }
+    return pixels;
+}
+
+
+TEST_CASE("Chunked tiles", "[chunks]")
+{
+    constexpr uint8_t PALETTE = RealSpriteRecord::HAS_PALETTE;
+    constexpr uint8_t RGBA    = RealSpriteRecord::HAS_RGB | RealSpriteRecord::HAS_ALPHA;
+    constexpr uint8_t RGBAP   = RGBA | RealSpriteRecord::HAS_PALETTE;
+
+    SECTION("Round trip")
+    {
+        struct Format { uint8_t compression; uint16_t pixel_size; };
+        for (auto format: { Format{ PALETTE, 1 }, Format{ RGBA, 4 }, Format{ RGBAP, 5 } })
+        {
+            // Narrow and wide images have short and long chunk headers. The large image 
+            // has long row offsets.
+            for (uint16_t xdim: { 1, 60, 256, 300, 600 })
+            {
+                uint16_t ydim   = (xdim == 600) ? 100 : 20;
+                auto     pixels = make_image(xdim, ydim, format.pixel_size);
+                auto     chunks = encode_tile(pixels, xdim, ydim, format.compression, GRFFormat::Container2, 3);
+                CHECK(decode_tile(chunks, xdim, ydim, format.compression, GRFFormat::Container2) == pixels);
+            }
+        }
+
+        auto pixels = make_image(100, 20, 1);
+        auto chunks = encode_tile(pixels, 100, 20, PALETTE, GRFFormat::Container1, 3);
+        CHECK(decode_tile(chunks, 100, 20, PALETTE, GRFFormat::Container1) == pixels);
+    }
+
+    SECTION("Edges either side of vector boundaries")
+    {
+        // A single visible pixel is one chunk: the last chunk flag with length 1, the
+        // offset, and then the pixel.
+        for (uint16_t xdim: { 15, 16, 17, 63, 64, 65, 130, 256 })
+        {
+            for (uint16_t x = 0; x < xdim; ++x)
+            {
+                std::vector<uint8_t> pixels(xdim * 4, 0);
+                pixels[x * 4 + 3] = 0xFF;
+                auto chunks = encode_tile(pixels, xdim, 1, RGBA, GRFFormat::Container2, 3);
+                CHECK(chunks == std::vector<uint8_t>{ 0x02, 0x00, 0x81, uint8_t(x), 0x00, 0x00, 0x00, 0xFF });
+            }
+        }
+
+        // Runs ending at the end of the row, with widths which are and are not multiples 
+        // of the vector size.
+        for (uint16_t xdim: { 3, 16, 40, 64, 100, 128 })
+        {
+            std::vector<uint8_t> pixels(xdim, 0);
+            for (uint16_t x = xdim / 2; x < xdim; ++x)
+            {
+                pixels[x] = uint8_t(x + 1);
+            }
+            auto chunks = encode_tile(pixels, xdim, 1, PALETTE, GRFFormat::Container2, 3);
+            CHECK(chunks.size() == 4U + (xdim - (xdim / 2)));
+            CHECK(chunks[2] == (0x80 | (xdim - (xdim / 2))));
+            CHECK(chunks[3] == (xdim / 2));
+            CHECK(decode_tile(chunks, xdim, 1, PALETTE, GRFFormat::Container2) == pixels);
+        }
+    }
+
+    SECTION("Chunk gaps")
+    {
+        // Two visible pixels with a gap of two between them.
+        std::vector<uint8_t> pixels = { 0, 5, 0, 0, 6, 0 };
+        auto joined = encode_tile(pixels, 6, 1, PALETTE, GRFFormat::Container2, 3);
+        CHECK(joined == std::vector<uint8_t>{ 0x02, 0x00, 0x84, 0x01, 5, 0, 0, 6 });
+        auto split  = encode_tile(pixels, 6, 1, PALETTE, GRFFormat::Container2, 2);
+        CHECK(split == std::vector<uint8_t>{ 0x02, 0x00, 0x01, 0x01, 5, 0x81, 0x04, 6 });
+        CHECK(decode_tile(joined, 6, 1, PALETTE, GRFFormat::Container2) == pixels);
+        CHECK(decode_tile(split, 6, 1, PALETTE, GRFFormat::Container2) == pixels);
+
+        ChunkGapTable table;
+        ChunkGapTable::Key key{ 10, 0, PALETTE, 0x1234 };
+        CHECK(table.gap(key, 3) == 3);
+        table.set_gap(key, 8);
+        CHECK(table.gap(key, 3) == 8);
+        CHECK(table.gap(ChunkGapTable::Key{ 10, 2, PALETTE, 0x1234 }, 3) == 3);
+        // The same sprite with different pixels uses the default.
+        CHECK(table.gap(ChunkGapTable::Key{ 10, 0, PALETTE, 0x5678 }, 3) == 3);
+
+        // Gaps saved without a hash of the pixels by older versions are ignored.
+        fs::path file = fs::temp_directory_path().append("yagl-test-chunk-gaps");
+        table.save(file.string());
+        {
+            std::ofstream os(file, std::ios::app);
+            os << "11 0 1 6\n";
+        }
+        ChunkGapTable table2;
+        table2.load(file.string());
+        CHECK(table2.gap(key, 3) == 8);
+        CHECK(table2.gap(ChunkGapTable::Key{ 11, 0, PALETTE, 0 }, 3) == 3);
+        fs::remove(file);
+    }
+
+    SECTION("Empty rows")
+    {
+        // Short headers: 0x80 is an empty chunk marked as the last.
+        std::vector<uint8_t> pixels(10 * 2, 0);
+        auto chunks = encode_tile(pixels, 10, 2, PALETTE, GRFFormat::Container2, 3);
+        CHECK(chunks == std::vector<uint8_t>{ 0x04, 0x00, 0x06, 0x00, 0x80, 0x00, 0x80, 0x00 });
+        CHECK(decode_tile(chunks, 10, 2, PALETTE, GRFFormat::Container2) == pixels);
+
+        // Long headers: the length is a word, so the last chunk flag is 0x8000.
+        std::vector<uint8_t> wide(300 * 2, 0);
+        chunks = encode_tile(wide, 300, 2, PALETTE, GRFFormat::Container2, 3);
+        CHECK(chunks == std::vector<uint8_t>{ 0x04, 0x00, 0x08, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0x80, 0x00, 0x00 });
+        CHECK(decode_tile(chunks, 300, 2, PALETTE, GRFFormat::Container2) == wide);
+
+        // Earlier versions wrote 0x0080 for long format empty rows. Such rows are still 
+        // skipped because they contain only a chunk header.
+        chunks = { 0x04, 0x00, 0x08, 0x00, 0x80, 0x00, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00 };
+        CHECK(decode_tile(chunks, 300, 2, PALETTE, GRFFormat::Container2) == wide);
+    }
+
+    SECTION("Invalid data")
+    {
+        // Chunk extends beyond the width of the image.
+        std::vector<uint8_t> chunks = { 0x02, 0x00, 0x82, 0x09, 0x01, 0x02 };
+        CHECK_THROWS(decode_tile(chunks, 10, 1, PALETTE, GRFFormat::Container2));
+        // Chunk extends beyond the end of the data.
+        chunks = { 0x02, 0x00, 0x83, 0x00, 0x01, 0x02 };
+        CHECK_THROWS(decode_tile(chunks, 10, 1, PALETTE, GRFFormat::Container2));
+        // Too short for the row offsets.
+        chunks = { 0x02, 0x00 };
+        CHECK_THROWS(decode_tile(chunks, 10, 2, PALETTE, GRFFormat::Container2));
+        // No alpha channel or palette.
+        std::vector<uint8_t> pixels(30, 1);
+        CHECK_THROWS(encode_tile(pixels, 10, 1, RealSpriteRecord::HAS_RGB, GRFFormat::Container2, 3));
+    }
+}
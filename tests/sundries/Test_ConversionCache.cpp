@@ -0,0 +1,269 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#include "catch.hpp"
+#include "ConversionCache.h"
+#include "FileSystem.h"
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+
+static void write_file(const fs::path& path, const std::string& text)
+{
+    std::ofstream os(path, std::ios::binary);
+    os << text;
+}
+
+
+static std::string read_file(const fs::path& path)
+{
+    std::ifstream is(path, std::ios::binary);
+    std::ostringstream os;
+    os << is.rdbuf();
+    return os.str();
+}
+
+
+TEST_CASE("ConversionCache tests", "[cache]")
+{
+    fs::path base = fs::temp_directory_path().append("yagl-test-conversion-cache");
+    fs::remove_all(base);
+    fs::create_directories(base);
+
+    const fs::path input    = fs::path(base).append("input.txt");
+    const fs::path optional = fs::path(base).append("optional.txt");
+    const fs::path output   = fs::path(base).append("output.txt");
+    const fs::path cache    = fs::path(base).append("cache");
+    write_file(input, "input");
+    write_file(output, "output");
+
+    {
+        ConversionCache converter;
+        converter.set_directory(cache.string(), base.string());
+        CHECK(!converter.lookup("key"));
+        converter.add_input(input.string());
+        converter.add_input(optional.string());
+        converter.add_output(output.string());
+        converter.save("key");
+    }
+
+    SECTION("Outputs are restored if the inputs are unchanged")
+    {
+        fs::remove(output);
+        ConversionCache converter;
+        converter.set_directory(cache.string(), base.string());
+        CHECK(!converter.lookup("other key"));
+        REQUIRE(converter.lookup("key"));
+        converter.restore();
+        CHECK(read_file(output) == "output");
+
+        // The totals are kept in the cache directory.
+        CHECK(converter.hits() == 1);
+        CHECK(converter.misses() == 2);
+    }
+
+    SECTION("Jobs sharing the cache directory keep all the counts")
+    {
+        ConversionCache job1;
+        ConversionCache job2;
+        job1.set_directory(cache.string(), base.string());
+        job2.set_directory(cache.string(), base.string());
+        CHECK(job1.lookup("key"));
+        CHECK(!job2.lookup("other key"));
+        CHECK(job2.lookup("key"));
+        CHECK(job2.hits() == 2);
+        CHECK(job2.misses() == 2);
+    }
+
+    SECTION("The counts are kept as totals rather than a line for each lookup")
+    {
+        ConversionCache converter;
+        converter.set_directory(cache.string(), base.string());
+        for (uint32_t lookup = 0; lookup < 20; ++lookup)
+        {
+            converter.lookup("key");
+        }
+        CHECK(converter.hits() == 20);
+        CHECK(converter.misses() == 1);
+        CHECK(read_file(fs::path(cache).append("stats")) == "hits 20\nmisses 1\n");
+        CHECK(!fs::exists(fs::path(cache).append("stats.lock")));
+    }
+
+    SECTION("Jobs counting at the same time do not lose counts")
+    {
+        std::vector<std::thread> jobs;
+        for (uint32_t job = 0; job < 4; ++job)
+        {
+            jobs.emplace_back([&]()
+            {
+                ConversionCache converter;
+                converter.set_directory(cache.string(), base.string());
+                for (uint32_t lookup = 0; lookup < 10; ++lookup)
+                {
+                    converter.lookup("key");
+                }
+            });
+        }
+        for (auto& job: jobs)
+        {
+            job.join();
+        }
+
+        ConversionCache converter;
+        converter.set_directory(cache.string(), base.string());
+        CHECK(converter.hits() == 40);
+        CHECK(converter.misses() == 1);
+    }
+
+    SECTION("Saving an entry again does not disturb a job restoring the previous one")
+    {
+        ConversionCache job1;
+        job1.set_directory(cache.string(), base.string());
+        REQUIRE(job1.lookup("key"));
+
+        ConversionCache job2;
+        job2.set_directory(cache.string(), base.string());
+        write_file(input, "changed");
+        write_file(output, "changed output");
+        CHECK(!job2.lookup("key"));
+        job2.add_input(input.string());
+        job2.add_output(output.string());
+        job2.save("key");
+
+        job1.restore();
+        CHECK(read_file(output) == "output");
+        CHECK(job2.lookup("key"));
+        job2.restore();
+        CHECK(read_file(output) == "changed output");
+    }
+
+    SECTION("Outputs are kept for each version of the inputs")
+    {
+        ConversionCache converter;
+        converter.set_directory(cache.string(), base.string());
+        write_file(input, "changed");
+        write_file(output, "changed output");
+        CHECK(!converter.lookup("key"));
+        converter.add_input(input.string());
+        converter.add_input(optional.string());
+        converter.add_output(output.string());
+        converter.save("key");
+
+        write_file(input, "input");
+        REQUIRE(converter.lookup("key"));
+        converter.restore();
+        CHECK(read_file(output) == "output");
+
+        write_file(input, "changed");
+        REQUIRE(converter.lookup("key"));
+        converter.restore();
+        CHECK(read_file(output) == "changed output");
+    }
+
+    SECTION("Only the most recently used versions of the inputs are kept")
+    {
+        for (uint32_t version = 0; version < 10; ++version)
+        {
+            // Looking up the original inputs keeps them in use.
+            write_file(input, "input");
+            ConversionCache converter;
+            converter.set_directory(cache.string(), base.string());
+            REQUIRE(converter.lookup("key"));
+
+            write_file(input, "version " + std::to_string(version));
+            write_file(output, "output " + std::to_string(version));
+            CHECK(!converter.lookup("key"));
+            converter.add_input(input.string());
+            converter.add_input(optional.string());
+            converter.add_output(output.string());
+            converter.save("key");
+        }
+
+        ConversionCache converter;
+        converter.set_directory(cache.string(), base.string());
+        write_file(input, "version 9");
+        CHECK(converter.lookup("key"));
+        write_file(input, "version 3");
+        CHECK(converter.lookup("key"));
+        write_file(input, "version 2");
+        CHECK(!converter.lookup("key"));
+        write_file(input, "input");
+        CHECK(converter.lookup("key"));
+    }
+
+    SECTION("Inputs are hashed when they are read")
+    {
+        ConversionCache converter;
+        converter.set_directory(cache.string(), base.string());
+        converter.add_input(input.string());
+        write_file(input, "edited during the conversion");
+        converter.add_output(output.string());
+        converter.save("edited key");
+
+        CHECK(!converter.lookup("edited key"));
+        write_file(input, "input");
+        CHECK(converter.lookup("edited key"));
+    }
+
+    SECTION("A file which is read and written is compared with what was written")
+    {
+        const fs::path both = fs::path(base).append("both.txt");
+        write_file(both, "before");
+
+        ConversionCache converter;
+        converter.set_directory(cache.string(), base.string());
+        converter.add_input(both.string());
+        write_file(both, "after");
+        converter.add_output(both.string());
+        converter.save("both key");
+
+        CHECK(converter.lookup("both key"));
+        write_file(both, "before");
+        CHECK(!converter.lookup("both key"));
+    }
+
+    SECTION("Conversions which write special files are not saved")
+    {
+        // A directory stands in for a pipe, which would block if it were hashed.
+        const fs::path special = fs::path(base).append("special");
+        fs::create_directories(special);
+
+        ConversionCache converter;
+        converter.set_directory(cache.string(), base.string());
+        converter.add_input(input.string());
+        converter.add_output(special.string());
+        converter.save("special key");
+        CHECK(!converter.lookup("special key"));
+    }
+
+    SECTION("A changed or new input is a miss")
+    {
+        ConversionCache converter;
+        converter.set_directory(cache.string(), base.string());
+        write_file(input, "changed");
+        CHECK(!converter.lookup("key"));
+        write_file(input, "input");
+        CHECK(converter.lookup("key"));
+        write_file(optional, "optional");
+        CHECK(!converter.lookup("key"));
+    }
+
+    fs::remove_all(base);
+}
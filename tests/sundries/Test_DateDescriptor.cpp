@@ -71,9 +71,9 @@ TEST_CASE("Long and short dates", "[integers]")
         CHECK(date2.day()   == 14);
 
         // Short years are offset from 1920 and must be positive values.
-        std::ostringstream os2;
+        ByteWriter os2;
         date2.write(os2);
-        CHECK(os2.str().size() == 4);
+        CHECK(os2.buffer().size() == 4);
 
         const uint32_t days_max = days_from_years(3'000);
         LongDate date3{0, 1, 1};
@@ -108,9 +108,9 @@ TEST_CASE("Long and short dates", "[integers]")
         CHECK(date2.day()   == 29);
 
         // Short years are offset from 1920 and must be positive values.
-        std::ostringstream os2;
+        ByteWriter os2;
         date2.write(os2);
-        CHECK(os2.str().size() == 2);
+        CHECK(os2.buffer().size() == 2);
 
         const uint32_t days_max = days_from_years(3'000) - 701'265;
         ShortDate date3;
@@ -0,0 +1,54 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#include "catch.hpp"
+#include "Fnv1aHash.h"
+
+
+TEST_CASE("Fnv1aHash tests", "[hash]")
+{
+    SECTION("Bytes are hashed as in the reference implementation")
+    {
+        CHECK(Fnv1aHash{}.value() == 0xCBF29CE484222325ULL);
+
+        Fnv1aHash hash;
+        hash.add(std::string{"a"});
+        CHECK(hash.value() == 0xAF63DC4C8601EC8CULL);
+
+        Fnv1aHash hash2;
+        hash2.add(std::string{"foobar"});
+        CHECK(hash2.value() == 0x85944171F73967E8ULL);
+    }
+
+    SECTION("A hash can be continued from an earlier value")
+    {
+        Fnv1aHash hash;
+        hash.add(std::string{"foo"});
+        Fnv1aHash hash2{hash.value()};
+        hash2.add(std::string{"bar"});
+        hash.add(std::string{"bar"});
+        CHECK(hash2.value() == hash.value());
+    }
+
+    SECTION("Words are mixed in whole")
+    {
+        Fnv1aHash hash;
+        hash.add_word(0x0102);
+        CHECK(hash.value() == ((0xCBF29CE484222325ULL ^ 0x0102) * 0x100000001B3ULL));
+    }
+}
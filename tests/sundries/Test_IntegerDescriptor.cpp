@@ -105,14 +105,14 @@ TEST_CASE("UInt types", "[integers]")
         {
             UInt8 value;
             value.set(static_cast<uint8_t>(i));
-            std::ostringstream os;
+            ByteWriter os;
             value.write(os);
 
-            auto str = os.str();
+            auto str = os.buffer();
             CHECK(str.size() == 1);
             CHECK(uint8_t(str[0]) == i);
 
-            std::istringstream is(str);
+            ByteReader is{str.data(), str.size()};
             UInt8 value2;
             value2.read(is);
             CHECK(value2.get() == i);
@@ -146,18 +146,18 @@ TEST_CASE("UInt types", "[integers]")
         {
             UInt8Ext value;
             value.set(static_cast<uint16_t>(i));
-            std::ostringstream os;
+            ByteWriter os;
             value.write(os);
 
             // Always used the long format for extended bytes. 
             // May need to change this later.
-            auto str = os.str();
+            auto str = os.buffer();
             CHECK(str.size() == 3);
             CHECK(uint8_t(str[0]) == 0xFF);
             CHECK(uint8_t(str[1]) == (i & 0xFF));
             CHECK(uint8_t(str[2]) == (i >> 8));
 
-            std::istringstream is(str);
+            ByteReader is{str.data(), str.size()};
             UInt8Ext value2;
             value2.read(is);
             CHECK(value2.get() == i);
@@ -191,15 +191,15 @@ TEST_CASE("UInt types", "[integers]")
         {
             UInt16 value;
             value.set(static_cast<uint16_t>(i));
-            std::ostringstream os;
+            ByteWriter os;
             value.write(os);
 
-            auto str = os.str();
+            auto str = os.buffer();
             CHECK(str.size() == 2);
             CHECK(uint8_t(str[0]) == (i & 0xFF));
             CHECK(uint8_t(str[1]) == ((i >> 8) & 0xFF));
 
-            std::istringstream is(str);
+            ByteReader is{str.data(), str.size()};
             UInt16 value2;
             value2.read(is);
             CHECK(value2.get() == i);
@@ -233,17 +233,17 @@ TEST_CASE("UInt types", "[integers]")
         {
             UInt32 value;
             value.set(static_cast<uint32_t>(i));
-            std::ostringstream os;
+            ByteWriter os;
             value.write(os);
 
-            auto str = os.str();
+            auto str = os.buffer();
             CHECK(str.size() == 4);
             CHECK(uint8_t(str[0]) == (i & 0xFF));
             CHECK(uint8_t(str[1]) == ((i >> 8) & 0xFF));
             CHECK(uint8_t(str[2]) == ((i >> 16) & 0xFF));
             CHECK(uint8_t(str[3]) == ((i >> 24) & 0xFF));
 
-            std::istringstream is(str);
+            ByteReader is{str.data(), str.size()};
             UInt32 value2;
             value2.read(is);
             CHECK(value2.get() == i);
@@ -260,9 +260,9 @@ TEST_CASE("UIntArray", "[integers]")
     UIntArray<UInt8, 6> values;
     values.parse(ts);
 
-    std::ostringstream os;
-    values.write(os);
-    auto str = os.str();
+    ByteWriter bos;
+    values.write(bos);
+    auto str = bos.buffer();
     CHECK(str.size() == 6);
     CHECK(uint8_t(str[0]) == 0x01);
     CHECK(uint8_t(str[1]) == 0x02);
@@ -271,12 +271,12 @@ TEST_CASE("UIntArray", "[integers]")
     CHECK(uint8_t(str[4]) == 0x05);
     CHECK(uint8_t(str[5]) == 0xF6);
 
-    std::istringstream is2(str);
+    ByteReader is2{str.data(), str.size()};
     UIntArray<UInt8, 6> values2;
     values2.read(is2);
     CHECK(values == values2);
 
-    os.str("");
+    std::ostringstream os;
     values2.print(os, UIntFormat::Hex);
     CHECK(os.str() == "[ 0x01 0x02 0x03 0xF4 0x05 0xF6 ]");
     os.str("");
@@ -294,9 +294,9 @@ TEST_CASE("UIntVector", "[integers]")
     values.parse(ts);
     CHECK(values.size() == 6);
 
-    std::ostringstream os;
-    values.write(os);
-    auto str = os.str();
+    ByteWriter bos;
+    values.write(bos);
+    auto str = bos.buffer();
     CHECK(str.size() == 7);
     CHECK(uint8_t(str[0]) == 0x06); // Length
     CHECK(uint8_t(str[1]) == 0x01);
@@ -306,12 +306,12 @@ TEST_CASE("UIntVector", "[integers]")
     CHECK(uint8_t(str[5]) == 0x05);
     CHECK(uint8_t(str[6]) == 0xF6);
 
-    std::istringstream is2(str);
+    ByteReader is2{str.data(), str.size()};
     UIntVector<UInt8> values2;
     values2.read(is2);
     CHECK(values == values2);
 
-    os.str("");
+    std::ostringstream os;
     values2.print(os, UIntFormat::Hex);
     CHECK(os.str() == "[ 0x01 0x02 0x03 0xF4 0x05 0xF6 ]");
     os.str("");
@@ -0,0 +1,299 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#include "catch.hpp"
+#include "LZ77.h"
+#include "MatchLength.h"
+#include <algorithm>
+#include <random>
+
+
+// Simple decoder for checking the output. This copies one byte at a time so it would also
+// accept overlapping back-references, but the encoder should not produce any.
+static std::vector<uint8_t> decode(const std::vector<uint8_t>& input)
+{
+    std::vector<uint8_t> output;
+    size_t pos = 0;
+    while (pos < input.size())
+    {
+        int8_t code = int8_t(input[pos++]);
+        if (code < 0)
+        {
+            size_t length = size_t(-(code >> 3));
+            size_t offset = ((code & 0x07) << 8) | input.at(pos++);
+            REQUIRE(offset >= length);
+            REQUIRE(offset <= output.size());
+            for (size_t i = 0; i < length; ++i)
+            {
+                output.push_back(output[output.size() - offset]);
+            }
+        }
+        else
+        {
+            size_t length = (code == 0) ? 0x80 : code;
+            REQUIRE((pos + length) <= input.size());
+            output.insert(output.end(), &input[pos], &input[pos] + length);
+            pos += length;
+        }
+    }
+    return output;
+}
+
+
+// The original brute force search from NML, which finds the longest match at each position.
+static size_t reference_size(const std::vector<uint8_t>& data)
+{
+    size_t  size     = 0;
+    int32_t literals = 0;
+    int32_t position = 0;
+    int32_t length   = int32_t(data.size());
+    while (position < length)
+    {
+        int32_t start = std::max(0, position - 2047);
+        int32_t best  = 0;
+        for (int32_t i = 3; i <= std::min(15, length - position); ++i)
+        {
+            bool found = false;
+            for (int32_t s = start; (s + i) <= position && !found; ++s)
+            {
+                found = std::equal(&data[s], &data[s] + i, &data[position]);
+            }
+            if (!found) break;
+            best = i;
+        }
+
+        if (best > 0)
+        {
+            size    += (literals > 0) ? (literals + 1) : 0;
+            size    += 2;
+            literals = 0;
+            position += best;
+        }
+        else
+        {
+            if (++literals == 0x80)
+            {
+                size    += 0x81;
+                literals = 0;
+            }
+            ++position;
+        }
+    }
+    return size + ((literals > 0) ? (literals + 1) : 0);
+}
+
+
+TEST_CASE("LZ77", "[lz77]")
+{
+    SECTION("Empty input")
+    {
+        CHECK(encode_lz77({}).empty());
+    }
+
+    SECTION("Literals only")
+    {
+        std::vector<uint8_t> data(200);
+        for (size_t i = 0; i < data.size(); ++i)
+        {
+            data[i] = uint8_t(i);
+        }
+        auto encoded = encode_lz77(data);
+        // 0x80 + 0x48 literals, each block with a code byte.
+        CHECK(encoded.size() == 202);
+        CHECK(encoded[0] == 0x00);
+        CHECK(encoded[0x81] == 0x48);
+        CHECK(decode(encoded) == data);
+    }
+
+    SECTION("Runs do not overlap the current position")
+    {
+        std::vector<uint8_t> data(100, 0xAA);
+        auto encoded = encode_lz77(data);
+        CHECK(decode(encoded) == data);
+        CHECK(encoded.size() == reference_size(data));
+    }
+
+    SECTION("Random sprite-like data")
+    {
+        // Mostly short runs of a few colours, which is typical of sprites.
+        std::mt19937 rng{1234};
+        for (uint32_t colours: { 2, 8, 64 })
+        {
+            std::vector<uint8_t> data;
+            while (data.size() < 20'000)
+            {
+                uint8_t colour = uint8_t(rng() % colours);
+                data.insert(data.end(), rng() % 12 + 1, colour);
+            }
+
+            auto encoded = encode_lz77(data);
+            CHECK(decode(encoded) == data);
+            CHECK(encoded.size() <= reference_size(data));
+
+            auto optimal = encode_lz77(data, LZ77Level::Max);
+            CHECK(decode(optimal) == data);
+            CHECK(optimal.size() <= encoded.size());
+        }
+    }
+
+    SECTION("Compression levels")
+    {
+        std::mt19937 rng{5678};
+        std::vector<uint8_t> data;
+        while (data.size() < 20'000)
+        {
+            data.insert(data.end(), rng() % 12 + 1, uint8_t(rng() % 8));
+        }
+
+        auto store = encode_lz77(data, LZ77Level::Store);
+        CHECK(store.size() == (data.size() + (data.size() + 0x7F) / 0x80));
+        CHECK(decode(store) == data);
+
+        size_t previous = store.size();
+        for (auto level: { LZ77Level::Fast, LZ77Level::Normal, LZ77Level::Max })
+        {
+            auto encoded = encode_lz77(data, level);
+            CHECK(decode(encoded) == data);
+            CHECK(encoded.size() <= previous);
+            previous = encoded.size();
+        }
+    }
+
+    SECTION("Optimal parse")
+    {
+        CHECK(encode_lz77({}, LZ77Level::Max).empty());
+
+        // Long literal runs are split into blocks of at most 0x80.
+        std::vector<uint8_t> data(200);
+        for (size_t i = 0; i < data.size(); ++i)
+        {
+            data[i] = uint8_t(i);
+        }
+        auto encoded = encode_lz77(data, LZ77Level::Max);
+        CHECK(encoded.size() == 202);
+        CHECK(decode(encoded) == data);
+
+        // Greedy takes the three byte match "abc" and is left with "de" as literals. It
+        // is better to write "a" as a literal and then match "bcde".
+        std::vector<uint8_t> text;
+        for (char c: std::string{"abcxbcdeyabcde"})
+        {
+            text.push_back(uint8_t(c));
+        }
+        auto greedy  = encode_lz77(text);
+        auto optimal = encode_lz77(text, LZ77Level::Max);
+        CHECK(decode(optimal) == text);
+        CHECK(optimal.size() < greedy.size());
+    }
+}
+
+
+TEST_CASE("Match length kernels", "[lz77]")
+{
+    std::vector<uint8_t> a(100, 0x55);
+    std::vector<uint8_t> b(100, 0x55);
+
+    for (MatchKernel kernel: { MatchKernel::Scalar, MatchKernel::SSE2, MatchKernel::AVX2 })
+    {
+        if (!match_kernel_supported(kernel))
+        {
+            CHECK_THROWS(match_length(kernel, a.data(), b.data(), 10, 10));
+            continue;
+        }
+
+        // Every mismatch position against every limit, with and without room for whole 
+        // vectors to be read.
+        for (size_t diff = 0; diff <= 70; ++diff)
+        {
+            b[diff] = 0xAA;
+            for (size_t limit = 0; limit <= 70; ++limit)
+            {
+                size_t expected = std::min(diff, limit);
+                CHECK(match_length(kernel, a.data(), b.data(), limit, limit) == expected);
+                CHECK(match_length(kernel, a.data(), b.data(), limit, a.size()) == expected);
+            }
+            b[diff] = 0x55;
+        }
+    }
+
+    CHECK(match_kernel_supported(best_match_kernel()));
+    CHECK(match_length(a.data(), b.data(), 15, a.size()) == 15);
+}
+
+
+TEST_CASE("LZ77 decoder", "[lz77]")
+{
+    auto decode_fast = [](const std::vector<uint8_t>& input, size_t size)
+    {
+        std::vector<uint8_t> output(size);
+        size_t used = decode_lz77(input.data(), input.size(), output.data(), output.size());
+        CHECK(used == input.size());
+        return output;
+    };
+
+    SECTION("Round trip")
+    {
+        std::mt19937 rng{4321};
+        std::vector<uint8_t> data;
+        while (data.size() < 20'000)
+        {
+            data.insert(data.end(), rng() % 12 + 1, uint8_t(rng() % 16));
+        }
+
+        for (auto level: { LZ77Level::Store, LZ77Level::Fast, LZ77Level::Normal, LZ77Level::Max })
+        {
+            CHECK(decode_fast(encode_lz77(data, level), data.size()) == data);
+        }
+    }
+
+    SECTION("Overlapping back-references")
+    {
+        // "ab" followed by 6 bytes from offset 2, then 5 bytes from offset 1.
+        std::vector<uint8_t> input = { 0x02, 'a', 'b', 0x80 | (10 << 3), 0x02, 0x80 | (11 << 3), 0x01 };
+        std::vector<uint8_t> expected = { 'a', 'b', 'a', 'b', 'a', 'b', 'a', 'b', 'b', 'b', 'b', 'b', 'b' };
+        CHECK(decode_fast(input, expected.size()) == expected);
+    }
+
+    SECTION("Reading stops when the output is full")
+    {
+        std::vector<uint8_t> input = { 0x03, 1, 2, 3, 0xFF, 0xFF };
+        std::vector<uint8_t> output(3);
+        CHECK(decode_lz77(input.data(), input.size(), output.data(), output.size()) == 4);
+        CHECK(output == std::vector<uint8_t>{ 1, 2, 3 });
+    }
+
+    SECTION("Invalid data")
+    {
+        std::vector<uint8_t> output(8);
+        auto check_throws = [&output](const std::vector<uint8_t>& input)
+        {
+            CHECK_THROWS_AS(decode_lz77(input.data(), input.size(), output.data(), output.size()), LZ77Error);
+        };
+
+        // Offset before the start of the output.
+        check_throws({ 0x01, 'a', 0x80 | (13 << 3), 0x02 });
+        // Match longer than the remaining output.
+        check_throws({ 0x04, 1, 2, 3, 4, 0x80 | (11 << 3), 0x04 });
+        // Literals longer than the remaining output.
+        check_throws({ 0x09, 1, 2, 3, 4, 5, 6, 7, 8, 9 });
+        // Truncated data.
+        check_throws({ 0x04, 1, 2 });
+        check_throws({ 0x04, 1, 2, 3, 4, 0x80 });
+        check_throws({ 0x04, 1, 2, 3, 4 });
+    }
+}
@@ -0,0 +1,375 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#include "catch.hpp"
+#include "Test_Shared.h"
+#include "NewGRFData.h"
+#include "SpriteIndexRecord.h"
+#include "RealSpriteRecord.h"
+#include "ByteReader.h"
+#include "ByteWriter.h"
+#include "FileSystem.h"
+#include <fstream>
+#include <sstream>
+
+
+namespace {
+
+// An 8bpp image in the sprite section of a Container2 GRF.
+struct TestSprite
+{
+    uint32_t             sprite_id;
+    uint16_t             xdim;
+    uint16_t             ydim;
+    std::vector<uint8_t> pixels;
+};
+
+
+// A record in the data section: the info byte, and the data which follows it.
+struct TestRecord
+{
+    uint8_t              info;
+    std::vector<uint8_t> data;
+};
+
+
+// Action01 for trains: one set of sprites. The number of sprites is an extended byte,
+// written in full as yagl does.
+TestRecord action01(uint16_t num_sprites)
+{
+    return { 0xFF, { 0x01, 0x00, 0x01, 0xFF, uint8_t(num_sprites), uint8_t(num_sprites >> 8) } };
+}
+
+
+TestRecord sprite_index(uint32_t sprite_id)
+{
+    return { 0xFD, { uint8_t(sprite_id), uint8_t(sprite_id >> 8), uint8_t(sprite_id >> 16), uint8_t(sprite_id >> 24) } };
+}
+
+
+// Action0C is a comment.
+TestRecord comment(const std::string& text)
+{
+    TestRecord record{ 0xFF, { 0x0C } };
+    record.data.insert(record.data.end(), text.begin(), text.end());
+    return record;
+}
+
+
+// Writes a Container2 GRF with the given records and sprites. The pixels are stored as 
+// LZ77 literals, so there can be at most 127 of them in each sprite.
+std::vector<uint8_t> make_grf(const std::vector<TestRecord>& records, const std::vector<TestSprite>& sprites)
+{
+    static constexpr std::array<uint8_t, 8> CONTAINER2_IDENTIFIER 
+        = { 0x47, 0x52, 0x46, 0x82, 0x0D, 0x0A, 0x1A, 0x0A };
+
+    ByteWriter os;
+    os.write_uint16(0);
+    os.write_bytes(CONTAINER2_IDENTIFIER.data(), CONTAINER2_IDENTIFIER.size());
+    size_t sprite_offs_pos = os.reserve_uint32();
+    os.write_uint8(0x00);
+
+    // Record counter.
+    os.write_uint32(4);
+    os.write_uint8(0xFF);
+    os.write_uint32(uint32_t(records.size()));
+
+    for (const auto& record: records)
+    {
+        os.write_uint32(uint32_t(record.data.size()));
+        os.write_uint8(record.info);
+        os.write_bytes(record.data.data(), record.data.size());
+    }
+    os.write_uint32(0);
+
+    os.patch_uint32(sprite_offs_pos, uint32_t(os.position() - 14));
+    for (const auto& sprite: sprites)
+    {
+        os.write_uint32(sprite.sprite_id);
+        os.write_uint32(uint32_t(sprite.pixels.size() + 11));
+        os.write_uint8(RealSpriteRecord::HAS_PALETTE);
+        os.write_uint8(0x00); // Zoom
+        os.write_uint16(sprite.ydim);
+        os.write_uint16(sprite.xdim);
+        os.write_uint16(0);
+        os.write_uint16(0);
+        os.write_uint8(uint8_t(sprite.pixels.size()));
+        os.write_bytes(sprite.pixels.data(), sprite.pixels.size());
+    }
+    os.write_uint32(0);
+
+    return os.buffer();
+}
+
+
+// Writes a Container2 GRF in which an Action01 refers to each of the sprites in turn. 
+std::vector<uint8_t> make_grf(const std::vector<uint32_t>& sprite_ids, const std::vector<TestSprite>& sprites)
+{
+    std::vector<TestRecord> records{ action01(uint16_t(sprite_ids.size())) };
+    for (uint32_t sprite_id: sprite_ids)
+    {
+        records.push_back(sprite_index(sprite_id));
+    }
+    return make_grf(records, sprites);
+}
+
+
+// The sprite IDs in the data section and the sprite section of a Container2 GRF.
+struct GRFSpriteIds
+{
+    std::vector<uint32_t> index_records;
+    std::vector<uint32_t> sprites;
+};
+
+
+GRFSpriteIds sprite_ids(const std::string& grf)
+{
+    GRFSpriteIds result;
+    ByteReader is{reinterpret_cast<const uint8_t*>(grf.data()), grf.size()};
+    is.skip(15);
+    while (uint32_t size = is.read_uint32())
+    {
+        if (is.read_uint8() == 0xFD)
+        {
+            result.index_records.push_back(is.read_uint32());
+        }
+        else
+        {
+            is.skip(size);
+        }
+    }
+    while (uint32_t sprite_id = is.read_uint32())
+    {
+        result.sprites.push_back(sprite_id);
+        is.skip(is.read_uint32());
+    }
+    return result;
+}
+
+
+std::string write_grf(const std::vector<uint8_t>& grf)
+{
+    NewGRFData data;
+    ByteReader is{grf.data(), grf.size()};
+    data.read(is);
+    std::ostringstream os;
+    data.write(os);
+    return os.str();
+}
+
+
+// Reads a GRF with the given number of threads, and writes it with one.
+std::string read_with_jobs(const std::vector<uint8_t>& grf, const char* jobs)
+{
+    NewGRFData data;
+    {
+        TestOptions options{{"-j", jobs}};
+        ByteReader is{grf.data(), grf.size()};
+        data.read(is);
+    }
+
+    TestOptions options{{"-j", "1"}};
+    std::ostringstream os;
+    data.write(os);
+    return os.str();
+}
+
+
+void write_file(const fs::path& path, const std::string& text)
+{
+    std::ofstream os(path, std::ios::binary);
+    os << text;
+}
+
+
+void parse_index(const std::string& yagl, SpriteZoomMap& sprites)
+{
+    std::istringstream is(yagl);
+    TokenStream ts{is};
+    SpriteIndexRecord record{RecordType::ACTION_11};
+    record.parse(ts, sprites);
+}
+
+} // namespace {
+
+
+TEST_CASE("NewGRFData sprite aliases", "[sprites]")
+{
+    const std::vector<uint8_t> pixels1 = { 1, 2, 3, 4, 5, 6 };
+    const std::vector<uint8_t> pixels2 = { 6, 5, 4, 3, 2, 1 };
+    const std::vector<uint8_t> grf = make_grf({ 1, 2, 3, 1 }, 
+        { { 1, 3, 2, pixels1 }, { 2, 3, 2, pixels2 }, { 3, 3, 2, pixels1 } });
+
+    SECTION("Index records refer to the first of several identical sprites")
+    {
+        TestOptions options{{"--alias_sprites", "-j", "1"}};
+        GRFSpriteIds ids = sprite_ids(write_grf(grf));
+        CHECK(ids.index_records == std::vector<uint32_t>{ 1, 2, 1, 1 });
+        CHECK(ids.sprites == std::vector<uint32_t>{ 1, 2 });
+    }
+
+    SECTION("Sprites which differ only in size are not aliased")
+    {
+        const std::vector<uint8_t> grf2 = make_grf({ 1, 2 }, { { 1, 3, 2, pixels1 }, { 2, 2, 3, pixels1 } });
+        TestOptions options{{"--alias_sprites", "-j", "1"}};
+        GRFSpriteIds ids = sprite_ids(write_grf(grf2));
+        CHECK(ids.index_records == std::vector<uint32_t>{ 1, 2 });
+        CHECK(ids.sprites == std::vector<uint32_t>{ 1, 2 });
+    }
+
+    SECTION("Without the option every sprite is written")
+    {
+        TestOptions options{{"-j", "1"}};
+        const std::string output = write_grf(grf);
+        GRFSpriteIds ids = sprite_ids(output);
+        CHECK(ids.index_records == std::vector<uint32_t>{ 1, 2, 3, 1 });
+        CHECK(ids.sprites == std::vector<uint32_t>{ 1, 2, 3 });
+        CHECK(output == std::string(grf.begin(), grf.end()));
+    }
+}
+
+
+TEST_CASE("SpriteIndexRecord repeated sprite IDs", "[sprites]")
+{
+    fs::path dir = fs::temp_directory_path().append("yagl-test-sprite-index");
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    write_file(fs::path(dir).append("a.wav"), "sound a");
+    write_file(fs::path(dir).append("b.wav"), "sound b");
+
+    const char* str_A = "sprite_id<0x00000001> { binary(\"a.wav\"); }";
+    const char* str_B = "sprite_id<0x00000001> { binary(\"b.wav\"); }";
+
+    SECTION("With --alias_sprites the images are kept once and must not differ")
+    {
+        TestOptions options{{"test.grf", dir.string(), "--alias_sprites"}};
+        SpriteZoomMap sprites;
+        parse_index(str_A, sprites);
+        parse_index(str_A, sprites);
+        CHECK(sprites[1].size() == 1);
+        CHECK_THROWS_WITH(parse_index(str_B, sprites), Catch::Contains("differ from those given earlier"));
+    }
+
+    SECTION("Without --alias_sprites the images are written for each record")
+    {
+        TestOptions options{{"test.grf", dir.string()}};
+        SpriteZoomMap sprites;
+        parse_index(str_A, sprites);
+        parse_index(str_B, sprites);
+        CHECK(sprites[1].size() == 2);
+    }
+
+    fs::remove_all(dir);
+}
+
+
+TEST_CASE("NewGRFData reading on several threads", "[sprites]")
+{
+    const std::vector<TestSprite> sprites = { { 1, 3, 2, { 1, 2, 3, 4, 5, 6 } }, { 2, 2, 1, { 7, 8 } } };
+
+    auto make_records = [](bool with_error)
+    {
+        std::vector<TestRecord> records;
+        for (uint32_t i = 0; i < 20; ++i)
+        {
+            records.push_back(comment("Comment " + std::to_string(i)));
+        }
+
+        // An Action04 which ends before its strings. 
+        if (with_error)
+        {
+            records.push_back({ 0xFF, { 0x04, 0x00 } });
+        }
+
+        records.push_back(action01(2));
+        records.push_back(sprite_index(1));
+        records.push_back(sprite_index(2));
+        for (uint32_t i = 20; i < 40; ++i)
+        {
+            records.push_back(comment("Comment " + std::to_string(i)));
+        }
+        return records;
+    };
+
+    SECTION("The records are the same as when read serially")
+    {
+        const std::vector<uint8_t> grf = make_grf(make_records(false), sprites);
+        const std::string serial = read_with_jobs(grf, "1");
+        CHECK(serial == std::string(grf.begin(), grf.end()));
+        CHECK(read_with_jobs(grf, "4") == serial);
+    }
+
+    SECTION("A record which cannot be decoded is skipped as when read serially")
+    {
+        // The serial loop takes over after the bad record, and must group the sprites 
+        // which follow it in the same way.
+        const std::vector<uint8_t> grf  = make_grf(make_records(true), sprites);
+        const std::vector<uint8_t> good = make_grf(make_records(false), sprites);
+        const std::string serial = read_with_jobs(grf, "1");
+        CHECK(serial == std::string(good.begin(), good.end()));
+        CHECK(read_with_jobs(grf, "4") == serial);
+    }
+}
+
+
+TEST_CASE("NewGRFData writing on several threads", "[sprites]")
+{
+    // Enough sprites for several batches, whose sizes are not a multiple of the number 
+    // of threads. 
+    std::vector<uint32_t>   sprite_ids;
+    std::vector<TestSprite> sprites;
+    for (uint32_t sprite_id = 1; sprite_id <= 300; ++sprite_id)
+    {
+        std::vector<uint8_t> pixels(4 + sprite_id % 20);
+        for (size_t i = 0; i < pixels.size(); ++i)
+        {
+            pixels[i] = uint8_t(sprite_id * 7 + i * 13);
+        }
+        sprite_ids.push_back(sprite_id);
+        sprites.push_back({ sprite_id, uint16_t(pixels.size()), 1, pixels });
+    }
+    const std::vector<uint8_t> grf = make_grf(sprite_ids, sprites);
+
+    NewGRFData data;
+    {
+        TestOptions options{{"-j", "1"}};
+        ByteReader is{grf.data(), grf.size()};
+        data.read(is);
+    }
+
+    auto write_with_jobs = [&data](const char* jobs, bool auto_chunking)
+    {
+        std::vector<std::string> args{"-j", jobs};
+        if (auto_chunking)
+        {
+            args.push_back("--auto_chunking");
+        }
+        TestOptions options{args};
+        std::ostringstream os;
+        data.write(os);
+        return os.str();
+    };
+
+    const std::string serial = write_with_jobs("1", false);
+    CHECK(serial == std::string(grf.begin(), grf.end()));
+    CHECK(write_with_jobs("3", false) == serial);
+    CHECK(write_with_jobs("4", false) == serial);
+
+    const std::string chunked = write_with_jobs("1", true);
+    CHECK(write_with_jobs("3", true) == chunked);
+}
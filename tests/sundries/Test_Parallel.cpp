@@ -0,0 +1,56 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#include "catch.hpp"
+#include "Parallel.h"
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+TEST_CASE("parallel_for", "[parallel]")
+{
+    SECTION("Every index is visited once")
+    {
+        std::vector<uint32_t> visits(1000);
+        parallel_for(visits.size(), 4, [&](size_t index) { visits[index] += uint32_t(index) + 1; });
+        for (size_t index = 0; index < visits.size(); ++index)
+        {
+            CHECK(visits[index] == index + 1);
+        }
+    }
+
+    SECTION("The lowest failing index wins")
+    {
+        for (uint32_t threads: { 1, 4 })
+        {
+            try
+            {
+                parallel_for(100, threads, [](size_t index) 
+                {
+                    if ((index % 10) == 7) throw std::runtime_error(std::to_string(index)); 
+                });
+                FAIL("Expected an exception");
+            }
+            catch (const std::runtime_error& e)
+            {
+                CHECK(std::string(e.what()) == "7");
+            }
+        }
+    }
+}
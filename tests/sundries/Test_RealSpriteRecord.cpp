@@ -0,0 +1,422 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#include "catch.hpp"
+#include "RealSpriteRecord.h"
+#include "PixelPool.h"
+#include "ByteReader.h"
+#include "ByteWriter.h"
+#include "Test_Shared.h"
+#include <algorithm>
+#include <sstream>
+
+
+// Reads a Container2 sprite with the given pixels, stored as LZ77 literals.
+static RealSpriteRecord read_sprite(uint8_t compression, uint16_t xdim, uint16_t ydim, 
+    int16_t xrel, int16_t yrel, const std::vector<uint8_t>& pixels)
+{
+    ByteWriter os;
+    os.write_uint8(0x00); // Zoom
+    os.write_uint16(ydim);
+    os.write_uint16(xdim);
+    os.write_uint16(uint16_t(xrel));
+    os.write_uint16(uint16_t(yrel));
+    for (size_t first = 0; first < pixels.size(); first += 0x7F)
+    {
+        size_t count = std::min<size_t>(0x7F, pixels.size() - first);
+        os.write_uint8(uint8_t(count));
+        os.write_bytes(pixels.data() + first, count);
+    }
+
+    RealSpriteRecord sprite{0x10, uint32_t(os.position()), compression};
+    ByteReader is{os.buffer().data(), os.buffer().size()};
+    sprite.read(is, GRFInfo{});
+    return sprite;
+}
+
+
+static std::string dimensions(const RealSpriteRecord& sprite)
+{
+    std::ostringstream os;
+    sprite.print(os, SpriteZoomMap{}, 0);
+    return os.str().substr(0, os.str().find(']') + 1);
+}
+
+
+TEST_CASE("RealSpriteRecord cropping", "[sprites]")
+{
+    const std::vector<uint8_t> pixels = 
+    { 
+        0, 0, 0, 0, 0, 
+        0, 0, 7, 8, 0, 
+        0, 0, 0, 9, 0, 
+        0, 0, 0, 0, 0, 
+    };
+
+    SECTION("Transparent borders are removed")
+    {
+        RealSpriteRecord sprite = read_sprite(RealSpriteRecord::HAS_PALETTE, 5, 4, -3, -10, pixels);
+        uint64_t before = RealSpriteRecord::cropped_pixels();
+        sprite.crop_transparent_border();
+        CHECK(dimensions(sprite) == "[2, 2, -1, -9]");
+        CHECK((RealSpriteRecord::cropped_pixels() - before) == 16);
+        CHECK(sprite.pixel(0, 0).index == 7);
+        CHECK(sprite.pixel(1, 0).index == 8);
+        CHECK(sprite.pixel(0, 1).index == 0);
+        CHECK(sprite.pixel(1, 1).index == 9);
+    }
+
+    SECTION("Sprites marked no_crop are not changed")
+    {
+        RealSpriteRecord sprite = read_sprite(RealSpriteRecord::HAS_PALETTE | RealSpriteRecord::CROP_TRANSARENT_BORDER, 
+            5, 4, -3, -10, pixels);
+        sprite.crop_transparent_border();
+        CHECK(dimensions(sprite) == "[5, 4, -3, -10]");
+    }
+
+    SECTION("Fully transparent sprites become a single pixel")
+    {
+        RealSpriteRecord sprite = read_sprite(RealSpriteRecord::HAS_PALETTE, 3, 2, 0, 0, std::vector<uint8_t>(6, 0));
+        sprite.crop_transparent_border();
+        CHECK(dimensions(sprite) == "[1, 1, 0, 0]");
+    }
+
+    SECTION("Sprites without alpha are opaque")
+    {
+        RealSpriteRecord rgb = read_sprite(RealSpriteRecord::HAS_RGB, 3, 2, 0, 0, std::vector<uint8_t>(18, 0));
+        rgb.crop_transparent_border();
+        CHECK(rgb.xdim() == 3);
+        CHECK(rgb.ydim() == 2);
+
+        // The mask does not decide the bounds on its own.
+        RealSpriteRecord masked = read_sprite(RealSpriteRecord::HAS_RGB | RealSpriteRecord::HAS_PALETTE, 
+            3, 2, 0, 0, std::vector<uint8_t>(24, 0));
+        masked.crop_transparent_border();
+        CHECK(masked.xdim() == 3);
+        CHECK(masked.ydim() == 2);
+    }
+}
+
+
+TEST_CASE("RealSpriteRecord colour reduction", "[sprites]")
+{
+    constexpr uint8_t RGBA  = RealSpriteRecord::HAS_RGB | RealSpriteRecord::HAS_ALPHA;
+    constexpr uint8_t RGBAP = RGBA | RealSpriteRecord::HAS_PALETTE;
+
+    // Palette indices 1 and 2 are dark greys in the default palette.
+    const std::vector<uint8_t> palette_pixels = 
+    { 
+        16, 16, 16, 255,   99, 99, 99, 0, 
+        32, 32, 32, 255,   16, 16, 16, 255, 
+    };
+
+    auto make_images = [](std::initializer_list<RealSpriteRecord> sprites)
+    {
+        SpriteZoomVector images;
+        for (const auto& sprite: sprites)
+        {
+            images.push_back(std::make_unique<RealSpriteRecord>(sprite));
+        }
+        return images;
+    };
+
+    auto image = [](const SpriteZoomVector& images, size_t index)
+    {
+        return static_cast<const RealSpriteRecord*>(images[index].get());
+    };
+
+    SECTION("Palette colours with binary alpha become 8bpp")
+    {
+        SpriteZoomVector images = make_images({ read_sprite(RGBA, 2, 2, 0, 0, palette_pixels) });
+        uint32_t before = RealSpriteRecord::demoted_sprites();
+        RealSpriteRecord::reduce_colour_depth(images);
+        CHECK((RealSpriteRecord::demoted_sprites() - before) == 1);
+        CHECK(image(images, 0)->colour() == RealSpriteRecord::HAS_PALETTE);
+        CHECK(image(images, 0)->pixel(0, 0).index == 1);
+        CHECK(image(images, 0)->pixel(1, 0).index == 0);
+        CHECK(image(images, 0)->pixel(0, 1).index == 2);
+        CHECK(image(images, 0)->pixel(1, 1).index == 1);
+    }
+
+    SECTION("Colours outside the palette and partial alpha are kept")
+    {
+        std::vector<uint8_t> other_colour = palette_pixels;
+        other_colour[0] = 17;
+        std::vector<uint8_t> partial_alpha = palette_pixels;
+        partial_alpha[3] = 128;
+
+        SpriteZoomVector images = make_images({ read_sprite(RGBA, 2, 2, 0, 0, other_colour) });
+        RealSpriteRecord::reduce_colour_depth(images);
+        CHECK(image(images, 0)->colour() == RGBA);
+
+        images = make_images({ read_sprite(RGBA, 2, 2, 0, 0, partial_alpha) });
+        RealSpriteRecord::reduce_colour_depth(images);
+        CHECK(image(images, 0)->colour() == RGBA);
+    }
+
+    SECTION("All the images of a sprite are demoted or none")
+    {
+        std::vector<uint8_t> other_colour = palette_pixels;
+        other_colour[0] = 17;
+
+        SpriteZoomVector images = make_images({ read_sprite(RGBA, 2, 2, 0, 0, palette_pixels), 
+                                                read_sprite(RGBA, 2, 2, 0, 0, other_colour) });
+        RealSpriteRecord::reduce_colour_depth(images);
+        CHECK(image(images, 0)->colour() == RGBA);
+        CHECK(image(images, 1)->colour() == RGBA);
+
+        // A sprite which already has an 8bpp image keeps its 32bpp images.
+        images = make_images({ read_sprite(RGBA, 2, 2, 0, 0, palette_pixels), 
+                               read_sprite(RealSpriteRecord::HAS_PALETTE, 2, 2, 0, 0, {1, 0, 2, 1}) });
+        RealSpriteRecord::reduce_colour_depth(images);
+        CHECK(image(images, 0)->colour() == RGBA);
+    }
+
+    SECTION("Empty masks are dropped")
+    {
+        const std::vector<uint8_t> empty_mask = 
+        { 
+            16, 16, 16, 255, 0,   99, 99, 99, 0, 0, 
+            32, 32, 32, 255, 0,   17, 16, 16, 255, 0, 
+        };
+        std::vector<uint8_t> used_mask = empty_mask;
+        used_mask[4] = 0xC6;
+
+        SpriteZoomVector images = make_images({ read_sprite(RGBAP, 2, 2, 0, 0, empty_mask) });
+        uint32_t before = RealSpriteRecord::dropped_masks();
+        RealSpriteRecord::reduce_colour_depth(images);
+        CHECK((RealSpriteRecord::dropped_masks() - before) == 1);
+        CHECK(image(images, 0)->colour() == RGBA);
+        CHECK(image(images, 0)->pixel(1, 1).red == 17);
+        CHECK(image(images, 0)->pixel(1, 1).alpha == 255);
+
+        images = make_images({ read_sprite(RGBAP, 2, 2, 0, 0, used_mask) });
+        RealSpriteRecord::reduce_colour_depth(images);
+        CHECK(image(images, 0)->colour() == RGBAP);
+        CHECK(image(images, 0)->pixel(0, 0).index == 0xC6);
+    }
+}
+
+
+TEST_CASE("RealSpriteRecord shared pixels", "[sprites]")
+{
+    const std::vector<uint8_t> pixels = { 1, 2, 3, 4, 5, 6 };
+
+    RealSpriteRecord sprite1 = read_sprite(RealSpriteRecord::HAS_PALETTE, 3, 2, 0, 0, pixels);
+    RealSpriteRecord sprite2 = read_sprite(RealSpriteRecord::HAS_PALETTE, 3, 2, -1, -1, pixels);
+    RealSpriteRecord sprite3 = read_sprite(RealSpriteRecord::HAS_PALETTE, 2, 3, 0, 0, pixels);
+
+    SECTION("Identical images share a buffer")
+    {
+        // The offsets are not part of the image.
+        CHECK(&sprite1.pixels() == &sprite2.pixels());
+        CHECK(sprite1.same_image(sprite2));
+        CHECK(&sprite1.pixels() != &sprite3.pixels());
+        CHECK(!sprite1.same_image(sprite3));
+    }
+
+    SECTION("Changing a shared image makes a copy")
+    {
+        sprite1.set_pixel(0, 0, RealSpriteRecord::Pixel{0, 0, 0, 0, 9});
+        CHECK(sprite1.pixel(0, 0).index == 9);
+        CHECK(sprite2.pixel(0, 0).index == 1);
+        CHECK(!sprite1.same_image(sprite2));
+    }
+
+    SECTION("Buffers are freed when no sprite uses them")
+    {
+        PixelPool pool;
+        PixelPool::Buffer buffer1 = pool.intern(std::vector<uint8_t>(pixels), 3, 2, RealSpriteRecord::HAS_PALETTE);
+        PixelPool::Buffer buffer2 = pool.intern(std::vector<uint8_t>(pixels), 3, 2, RealSpriteRecord::HAS_PALETTE);
+        CHECK(buffer1 == buffer2);
+        CHECK(buffer1.use_count() == 2);
+        CHECK(pool.shared_sprites() == 1);
+
+        std::weak_ptr<const std::vector<uint8_t>> freed = buffer1;
+        buffer1.reset();
+        buffer2.reset();
+        CHECK(freed.expired());
+
+        PixelPool::Buffer buffer3 = pool.intern(std::vector<uint8_t>(pixels), 3, 2, RealSpriteRecord::HAS_PALETTE);
+        CHECK(*buffer3 == pixels);
+        CHECK(pool.shared_sprites() == 1);
+    }
+}
+
+
+TEST_CASE("RealSpriteRecord content comparison", "[sprites]")
+{
+    const std::vector<uint8_t> pixels = { 1, 2, 3, 4, 5, 6 };
+
+    RealSpriteRecord sprite1 = read_sprite(RealSpriteRecord::HAS_PALETTE, 3, 2, -1, -2, pixels);
+    RealSpriteRecord sprite2 = read_sprite(RealSpriteRecord::HAS_PALETTE, 3, 2, -1, -2, pixels);
+    RealSpriteRecord sprite3 = read_sprite(RealSpriteRecord::HAS_PALETTE, 3, 2, -1, -1, pixels);
+
+    // Sprites drawn at different offsets cannot share an ID even if the pixels match.
+    CHECK(sprite1.same_content(sprite2));
+    CHECK(sprite1.content_hash() == sprite2.content_hash());
+    CHECK(sprite1.same_image(sprite3));
+    CHECK(!sprite1.same_content(sprite3));
+    CHECK(sprite1.content_hash() != sprite3.content_hash());
+}
+
+
+// Writes a sprite as it would appear in a GRF.
+static std::vector<uint8_t> write_sprite(const RealSpriteRecord& sprite, GRFFormat format)
+{
+    GRFInfo info;
+    info.format = format;
+    ByteWriter os;
+    sprite.write(os, info);
+    return os.buffer();
+}
+
+
+// Reads back a sprite written to a Container2 GRF, with the compression flags it was written with.
+static RealSpriteRecord reread_sprite(const std::vector<uint8_t>& data)
+{
+    ByteReader is{data.data(), data.size()};
+    uint32_t sprite_id   = is.read_uint32();
+    uint32_t size        = is.read_uint32();
+    uint8_t  compression = is.read_uint8();
+    RealSpriteRecord sprite{sprite_id, size, compression};
+    sprite.read(is, GRFInfo{});
+    return sprite;
+}
+
+
+TEST_CASE("RealSpriteRecord automatic chunking", "[sprites]")
+{
+    // A mostly transparent sprite is smaller chunked, and a noisy opaque one is smaller plain.
+    auto sparse = [](uint16_t xdim, uint16_t ydim)
+    {
+        std::vector<uint8_t> pixels(size_t(xdim) * ydim, 0);
+        for (uint16_t y = 0; y < ydim; ++y)
+        {
+            pixels[size_t(y) * xdim + (y * 7) % xdim] = uint8_t(1 + y);
+        }
+        return pixels;
+    };
+
+    auto noise = [](uint16_t xdim, uint16_t ydim)
+    {
+        std::vector<uint8_t> pixels(size_t(xdim) * ydim);
+        uint32_t value = 12345;
+        for (auto& pixel: pixels)
+        {
+            value = value * 1103515245 + 12345;
+            pixel = uint8_t(1 + (value >> 16) % 255);
+        }
+        return pixels;
+    };
+
+    constexpr uint8_t CHUNKED = RealSpriteRecord::CHUNKED_FORMAT;
+    const RealSpriteRecord sprite = read_sprite(RealSpriteRecord::HAS_PALETTE, 200, 40, 0, 0, sparse(200, 40));
+    const RealSpriteRecord noisy  = read_sprite(RealSpriteRecord::HAS_PALETTE, 200, 40, 0, 0, noise(200, 40));
+    const RealSpriteRecord wide   = read_sprite(RealSpriteRecord::HAS_PALETTE, 300, 40, 0, 0, sparse(300, 40));
+
+    SECTION("Chunked is chosen when it is smaller")
+    {
+        std::vector<uint8_t> plain2;
+        std::vector<uint8_t> plain1;
+        {
+            TestOptions defaults;
+            plain2 = write_sprite(sprite, GRFFormat::Container2);
+            plain1 = write_sprite(sprite, GRFFormat::Container1);
+        }
+
+        TestOptions options{{"--auto_chunking"}};
+        const std::vector<uint8_t> auto2 = write_sprite(sprite, GRFFormat::Container2);
+        const std::vector<uint8_t> auto1 = write_sprite(sprite, GRFFormat::Container1);
+        CHECK((auto2[8] & CHUNKED) != 0);
+        CHECK((auto1[2] & CHUNKED) != 0);
+        CHECK(auto2.size() < plain2.size());
+        CHECK(auto1.size() < plain1.size());
+
+        // The flag was flipped, so the sizes must be those the chunked sprite would have 
+        // been written with. 
+        const RealSpriteRecord chunked = reread_sprite(auto2);
+        CHECK(chunked.same_image(sprite));
+        TestOptions defaults;
+        CHECK(write_sprite(chunked, GRFFormat::Container2) == auto2);
+        CHECK(write_sprite(chunked, GRFFormat::Container1) == auto1);
+    }
+
+    SECTION("Plain is chosen when it is smaller")
+    {
+        // A sprite which is marked chunked, but which no longer has any transparency.
+        std::vector<uint8_t> auto2;
+        {
+            TestOptions options{{"--auto_chunking"}};
+            auto2 = write_sprite(sprite, GRFFormat::Container2);
+        }
+        RealSpriteRecord chunked = reread_sprite(auto2);
+        REQUIRE((chunked.compression() & CHUNKED) != 0);
+        for (uint16_t y = 0; y < noisy.ydim(); ++y)
+        {
+            for (uint16_t x = 0; x < noisy.xdim(); ++x)
+            {
+                chunked.set_pixel(x, y, noisy.pixel(x, y));
+            }
+        }
+
+        std::vector<uint8_t> plain2;
+        std::vector<uint8_t> plain1;
+        {
+            TestOptions defaults;
+            plain2 = write_sprite(noisy, GRFFormat::Container2);
+            plain1 = write_sprite(noisy, GRFFormat::Container1);
+            CHECK(write_sprite(chunked, GRFFormat::Container2).size() > plain2.size());
+        }
+
+        // The flag was flipped, so the sizes must be those of the plain sprite.
+        TestOptions options{{"--auto_chunking"}};
+        CHECK(write_sprite(chunked, GRFFormat::Container2) == plain2);
+        CHECK(write_sprite(chunked, GRFFormat::Container1) == plain1);
+        CHECK(write_sprite(noisy, GRFFormat::Container2) == plain2);
+    }
+
+    SECTION("Container1 sprites wider than 256 pixels are not chunked")
+    {
+        std::vector<uint8_t> plain1;
+        {
+            TestOptions defaults;
+            plain1 = write_sprite(wide, GRFFormat::Container1);
+        }
+
+        TestOptions options{{"--auto_chunking"}};
+        CHECK((write_sprite(wide, GRFFormat::Container2)[8] & CHUNKED) != 0);
+        CHECK(write_sprite(wide, GRFFormat::Container1) == plain1);
+    }
+
+    SECTION("The limits of each container are respected")
+    {
+        // Container2 has an extra 4 bytes for the size of the chunked data.
+        CHECK(RealSpriteRecord::prefer_chunked(GRFFormat::Container2, 100, 100, 95, 1000));
+        CHECK(!RealSpriteRecord::prefer_chunked(GRFFormat::Container2, 100, 100, 96, 1000));
+        CHECK(RealSpriteRecord::prefer_chunked(GRFFormat::Container2, 1000, 100, 95, 0x20000));
+
+        // Container1 has no extra bytes, but a limit on the width and on the size.
+        CHECK(RealSpriteRecord::prefer_chunked(GRFFormat::Container1, 100, 100, 99, 1000));
+        CHECK(!RealSpriteRecord::prefer_chunked(GRFFormat::Container1, 100, 100, 100, 1000));
+        CHECK(RealSpriteRecord::prefer_chunked(GRFFormat::Container1, 256, 100, 10, 1000));
+        CHECK(!RealSpriteRecord::prefer_chunked(GRFFormat::Container1, 257, 100, 10, 1000));
+        CHECK(RealSpriteRecord::prefer_chunked(GRFFormat::Container1, 100, 100, 10, 0xFFFF - 8));
+        CHECK(!RealSpriteRecord::prefer_chunked(GRFFormat::Container1, 100, 100, 10, 0xFFFF - 7));
+    }
+}
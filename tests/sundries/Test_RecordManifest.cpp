@@ -0,0 +1,181 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#include "catch.hpp"
+#include "RecordManifest.h"
+#include "Action03Record.h"
+#include "FileSystem.h"
+#include "yagl_version.h" // Generated in a pre-build step.
+#include <fstream>
+#include <sstream>
+
+
+namespace {
+
+static constexpr const char* str_YAGL =
+    "feature_graphics<Trains> // Action03\n"
+    "{\n"
+    "    livery_override: false;\n"
+    "    default_set_id: 0x01F8;\n"
+    "    feature_ids: [ 0x0087 ];\n"
+    "    cargo_types:\n"
+    "    {\n"
+    "        0x12: 0x02FE;\n"
+    "    };\n"
+    "}\n"
+    "feature_graphics<Trains> { livery_override: false; default_set_id: 0x01F8; feature_ids: [ 0x0087 ]; \n"
+    "    cargo_types: { 0x12: 0x02FE; }; } /* Same tokens */\n"
+    "feature_graphics<Trains> { livery_override: false; default_set_id: 0x01F9; feature_ids: [ 0x0087 ]; \n"
+    "    cargo_types: { 0x12: 0x02FE; }; }\n"
+    "feature_graphics<Trains> {\n";
+
+
+std::vector<uint8_t> write_record(const Record& record)
+{
+    ByteWriter os;
+    record.write(os, GRFInfo{});
+    return os.buffer();
+}
+
+} // namespace {
+
+
+TEST_CASE("RecordManifest tests", "[cache]")
+{
+    std::istringstream is(str_YAGL);
+    TokenStream ts{is};
+
+    SECTION("Records are hashed by their tokens")
+    {
+        uint32_t length1 = ts.record_length();
+        uint64_t hash1   = ts.hash_tokens(length1);
+        ts.skip(length1);
+        uint32_t length2 = ts.record_length();
+        uint64_t hash2   = ts.hash_tokens(length2);
+        ts.skip(length2);
+        uint32_t length3 = ts.record_length();
+        uint64_t hash3   = ts.hash_tokens(length3);
+        ts.skip(length3);
+
+        CHECK(length1 == length2);
+        CHECK(hash1 == hash2);
+        CHECK(hash1 != hash3);
+
+        // The last record is not closed.
+        CHECK(ts.peek().value == "feature_graphics");
+        CHECK(ts.record_length() == 0);
+    }
+
+    SECTION("Parsed records are stored and found again")
+    {
+        fs::path file = fs::temp_directory_path().append("yagl-test-record-manifest");
+        fs::remove(file);
+
+        uint64_t hash = ts.hash_tokens(ts.record_length());
+        Action03Record action;
+        SpriteZoomMap  sprites;
+        action.parse(ts, sprites);
+
+        RecordManifest manifest;
+        CHECK(!manifest.enabled());
+        manifest.load(file.string());
+        CHECK(manifest.enabled());
+        CHECK(manifest.find(hash, RecordType::ACTION_03) == nullptr);
+
+        // The stored record is written exactly as the parsed one.
+        auto stored = manifest.store(hash, action, GRFInfo{});
+        CHECK(stored->record_type() == RecordType::ACTION_03);
+        CHECK(write_record(*stored) == write_record(action));
+        CHECK(manifest.parsed() == 1);
+        manifest.save(file.string());
+
+        RecordManifest manifest2;
+        manifest2.load(file.string());
+        CHECK(manifest2.find(hash + 1, RecordType::ACTION_03) == nullptr);
+        auto found = manifest2.find(hash, RecordType::ACTION_03);
+        REQUIRE(found != nullptr);
+        CHECK(write_record(*found) == write_record(action));
+        CHECK(manifest2.reused() == 1);
+
+        // Only the entries used are saved again.
+        manifest2.save(file.string());
+        manifest.load(file.string());
+        CHECK(manifest.find(hash, RecordType::ACTION_03) != nullptr);
+
+        RecordManifest manifest3;
+        manifest3.save(file.string());
+        manifest.load(file.string());
+        CHECK(manifest.find(hash, RecordType::ACTION_03) == nullptr);
+
+        fs::remove(file);
+    }
+
+    SECTION("A manifest written by another version of yagl is ignored")
+    {
+        fs::path file = fs::temp_directory_path().append("yagl-test-record-manifest");
+        fs::remove(file);
+
+        uint64_t hash = ts.hash_tokens(ts.record_length());
+        Action03Record action;
+        SpriteZoomMap  sprites;
+        action.parse(ts, sprites);
+
+        RecordManifest manifest;
+        manifest.load(file.string());
+        manifest.store(hash, action, GRFInfo{});
+        manifest.save(file.string());
+
+        // The version follows the magic number, the manifest version and its length.
+        std::string data;
+        {
+            std::ifstream is(file, std::ios::binary);
+            std::ostringstream os;
+            os << is.rdbuf();
+            data = os.str();
+        }
+        const std::string version{str_yagl_version};
+        REQUIRE(data.substr(12, version.size()) == version);
+        if (!version.empty())
+        {
+            data[12] ^= 0x01;
+        }
+        {
+            std::ofstream os(file, std::ios::binary);
+            os << data;
+        }
+
+        RecordManifest manifest2;
+        manifest2.load(file.string());
+        CHECK(manifest2.find(hash, RecordType::ACTION_03) == nullptr);
+        CHECK(manifest2.reused() == 0);
+
+        fs::remove(file);
+    }
+
+    SECTION("Only self-contained records are cached")
+    {
+        CHECK(RecordManifest::is_cacheable(RecordType::ACTION_00));
+        CHECK(RecordManifest::is_cacheable(RecordType::ACTION_03));
+        CHECK(!RecordManifest::is_cacheable(RecordType::ACTION_01));
+        CHECK(!RecordManifest::is_cacheable(RecordType::ACTION_07));
+        CHECK(!RecordManifest::is_cacheable(RecordType::ACTION_08));
+        CHECK(!RecordManifest::is_cacheable(RecordType::ACTION_09));
+        CHECK(!RecordManifest::is_cacheable(RecordType::ACTION_13));
+        CHECK(!RecordManifest::is_cacheable(RecordType::SPRITE_INDEX));
+    }
+}
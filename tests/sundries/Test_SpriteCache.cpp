@@ -0,0 +1,67 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#include "catch.hpp"
+#include "SpriteCache.h"
+#include "RealSpriteRecord.h"
+#include "LZ77.h"
+#include "FileSystem.h"
+
+
+TEST_CASE("SpriteCache tests", "[cache]")
+{
+    fs::path directory = fs::temp_directory_path().append("yagl-test-sprite-cache");
+    fs::remove_all(directory);
+
+    const std::vector<uint8_t> pixels = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
+    const uint8_t colour = RealSpriteRecord::HAS_PALETTE;
+
+    SpriteCache::Entry stored;
+    stored.compression = colour;
+    stored.data        = encode_lz77(pixels);
+
+    SpriteCache cache;
+    SECTION("Nothing is cached until there is a directory")
+    {
+        SpriteCache::Entry entry;
+        cache.store(0x1234, stored);
+        CHECK(!cache.lookup(0x1234, pixels, 4, 3, colour, GRFFormat::Container2, entry));
+        CHECK(cache.misses() == 0);
+    }
+
+    SECTION("Entries are found by key and checked against the pixels")
+    {
+        cache.set_directory(directory.string());
+        cache.store(0x1234, stored);
+
+        SpriteCache::Entry entry;
+        CHECK(cache.lookup(0x1234, pixels, 4, 3, colour, GRFFormat::Container2, entry));
+        CHECK(entry.data == stored.data);
+        CHECK(entry.compression == colour);
+        CHECK(cache.hits() == 1);
+
+        // A different key, or the same key with different pixels, is a miss.
+        std::vector<uint8_t> changed = pixels;
+        changed[5] = 0;
+        CHECK(!cache.lookup(0x1235, pixels, 4, 3, colour, GRFFormat::Container2, entry));
+        CHECK(!cache.lookup(0x1234, changed, 4, 3, colour, GRFFormat::Container2, entry));
+        CHECK(cache.misses() == 2);
+    }
+
+    fs::remove_all(directory);
+}
@@ -0,0 +1,169 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#include "catch.hpp"
+#include "Test_Shared.h"
+#include "SpriteSheetGenerator.h"
+#include "SpriteSheetLayout.h"
+#include "RealSpriteRecord.h"
+#include "ByteReader.h"
+#include "ByteWriter.h"
+#include "FileSystem.h"
+#include <algorithm>
+#include <fstream>
+#include <tuple>
+
+
+namespace {
+
+// Makes 8bpp sprites of the given IDs and sizes, read as from a Container2 GRF.
+SpriteZoomMap make_sprites(std::initializer_list<std::tuple<uint32_t, uint16_t, uint16_t>> sizes)
+{
+    SpriteZoomMap sprites;
+    for (const auto& [sprite_id, xdim, ydim]: sizes)
+    {
+        std::vector<uint8_t> pixels(size_t(xdim) * ydim, uint8_t(sprite_id));
+
+        ByteWriter os;
+        os.write_uint8(0x00); // Zoom
+        os.write_uint16(ydim);
+        os.write_uint16(xdim);
+        os.write_uint16(0);
+        os.write_uint16(0);
+        for (size_t first = 0; first < pixels.size(); first += 0x7F)
+        {
+            size_t count = std::min<size_t>(0x7F, pixels.size() - first);
+            os.write_uint8(uint8_t(count));
+            os.write_bytes(pixels.data() + first, count);
+        }
+
+        auto sprite = std::make_unique<RealSpriteRecord>(sprite_id, uint32_t(os.position()), RealSpriteRecord::HAS_PALETTE);
+        ByteReader is{os.buffer().data(), os.buffer().size()};
+        sprite->read(is, GRFInfo{});
+        sprites[sprite_id].push_back(std::move(sprite));
+    }
+    return sprites;
+}
+
+
+// Where a sprite was drawn: the file name of the sheet and the position on it.
+std::tuple<std::string, uint32_t, uint32_t> placement(const SpriteZoomMap& sprites, uint32_t sprite_id)
+{
+    auto sprite = static_cast<const RealSpriteRecord*>(sprites.at(sprite_id)[0].get());
+    return { sprite->filename(), sprite->xoff(), sprite->yoff() };
+}
+
+
+// Writes the sprite sheets as a decode with --incremental would.
+void decode(const SpriteZoomMap& sprites, const fs::path& dir)
+{
+    const std::string layout_file = fs::path(dir).append("test.layout").string();
+    SpriteSheetLayout& layout = SpriteSheetLayout::layout();
+    layout.load(layout_file);
+    SpriteSheetGenerator generator{sprites, fs::path(dir).append("test").string(), GRFFormat::Container2};
+    generator.generate();
+    layout.save(layout_file);
+}
+
+} // namespace {
+
+
+TEST_CASE("SpriteSheetGenerator incremental layout", "[sprites]")
+{
+    fs::path dir = fs::temp_directory_path().append("yagl-test-sprite-sheets");
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    const fs::path sheet0 = fs::path(dir).append("test-8bpp-normal-0.png");
+    const fs::path sheet1 = fs::path(dir).append("test-8bpp-normal-1.png");
+
+    // The first row fits the width exactly: A at 10, B at 40, and C at 80.
+    SpriteZoomMap first = make_sprites({ {1, 20, 10}, {2, 30, 10}, {3, 10, 10} });
+
+    SECTION("Sprites are put back where they were")
+    {
+        TestOptions options{{"--width", "100", "--height", "200"}};
+        decode(first, dir);
+        CHECK(placement(first, 2) == std::make_tuple(std::string{"test-8bpp-normal-0.png"}, 40u, 10u));
+
+        // The sprites are packed in a different order without the layout.
+        SpriteZoomMap second = make_sprites({ {1, 20, 10}, {3, 10, 10}, {4, 30, 10} });
+        decode(second, dir);
+        CHECK(placement(second, 1) == placement(first, 1));
+        CHECK(placement(second, 3) == placement(first, 3));
+        CHECK(placement(second, 4) == std::make_tuple(std::string{"test-8bpp-normal-0.png"}, 10u, 30u));
+
+        // A sheet with the same sprites in the same places is not drawn again.
+        SpriteZoomMap third = make_sprites({ {1, 20, 10}, {3, 10, 10}, {4, 30, 10} });
+        decode(third, dir);
+        CHECK(SpriteSheetLayout::layout().kept_sheets() == 1);
+    }
+
+    SECTION("Sprites whose size has changed are packed again after the others")
+    {
+        TestOptions options{{"--width", "100", "--height", "200"}};
+        decode(first, dir);
+
+        SpriteZoomMap second = make_sprites({ {1, 20, 10}, {2, 30, 12}, {3, 10, 10}, {5, 20, 10} });
+        decode(second, dir);
+        CHECK(placement(second, 1) == placement(first, 1));
+        CHECK(placement(second, 3) == placement(first, 3));
+        CHECK(placement(second, 2) == std::make_tuple(std::string{"test-8bpp-normal-0.png"}, 10u, 30u));
+        CHECK(placement(second, 5) == std::make_tuple(std::string{"test-8bpp-normal-0.png"}, 50u, 30u));
+        CHECK(!fs::exists(sheet1));
+    }
+
+    SECTION("New rows start a new sheet if the last would become too tall")
+    {
+        TestOptions options{{"--width", "100", "--height", "40"}};
+        decode(first, dir);
+
+        // The new row would make the sheet 52 pixels tall.
+        SpriteZoomMap second = make_sprites({ {1, 20, 10}, {2, 30, 12}, {3, 10, 10}, {5, 20, 10} });
+        decode(second, dir);
+        CHECK(placement(second, 1) == placement(first, 1));
+        CHECK(placement(second, 2) == std::make_tuple(std::string{"test-8bpp-normal-1.png"}, 10u, 10u));
+        CHECK(placement(second, 5) == std::make_tuple(std::string{"test-8bpp-normal-1.png"}, 50u, 10u));
+        CHECK(fs::exists(sheet1));
+    }
+
+    SECTION("Sheets which no longer have any sprites are removed unless edited")
+    {
+        // The fourth sprite does not fit on the first row, and the second row does not fit 
+        // on the first sheet.
+        TestOptions options{{"--width", "100", "--height", "25"}};
+        SpriteZoomMap two_sheets = make_sprites({ {1, 20, 10}, {2, 30, 10}, {3, 10, 10}, {6, 50, 10} });
+        decode(two_sheets, dir);
+        REQUIRE(fs::exists(sheet1));
+
+        decode(make_sprites({ {1, 20, 10}, {2, 30, 10}, {3, 10, 10} }), dir);
+        CHECK(fs::exists(sheet0));
+        CHECK(!fs::exists(sheet1));
+
+        decode(two_sheets, dir);
+        REQUIRE(fs::exists(sheet1));
+        {
+            std::ofstream os(sheet1, std::ios::binary | std::ios::app);
+            os << "edited";
+        }
+        decode(make_sprites({ {1, 20, 10}, {2, 30, 10}, {3, 10, 10} }), dir);
+        CHECK(fs::exists(sheet1));
+    }
+
+    SpriteSheetLayout::layout() = SpriteSheetLayout{};
+    fs::remove_all(dir);
+}
@@ -0,0 +1,104 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#include "catch.hpp"
+#include "SpriteSheetLayout.h"
+#include "FileSystem.h"
+#include <fstream>
+
+
+TEST_CASE("SpriteSheetLayout tests", "[cache]")
+{
+    fs::path file = fs::temp_directory_path().append("yagl-test-sprite-sheet-layout");
+    fs::remove(file);
+
+    const SpriteSheetLayout::SheetKey  sheet_key{0, 2, 1};
+    const SpriteSheetLayout::SpriteKey sprite_key{0, 2, 0x1234, 1};
+
+    SpriteSheetLayout layout;
+    CHECK(!layout.enabled());
+    layout.load(file.string());
+    CHECK(layout.enabled());
+    layout.set_sheet(sheet_key, SpriteSheetLayout::Sheet{300, 200, 0x0123456789ABCDEF, 0xFEDCBA9876543210});
+    layout.set_placement(sprite_key, SpriteSheetLayout::Placement{1, 10, 20, 64, 31});
+    layout.save(file.string());
+
+    SECTION("The layout is read back")
+    {
+        SpriteSheetLayout layout2;
+        layout2.load(file.string());
+
+        SpriteSheetLayout::Sheet sheet{};
+        REQUIRE(layout2.find_sheet(sheet_key, sheet));
+        CHECK(sheet.width == 300);
+        CHECK(sheet.height == 200);
+        CHECK(sheet.content_hash == 0x0123456789ABCDEF);
+        CHECK(sheet.file_hash == 0xFEDCBA9876543210);
+        CHECK(!layout2.find_sheet(SpriteSheetLayout::SheetKey{0, 2, 0}, sheet));
+
+        SpriteSheetLayout::Placement placement{};
+        REQUIRE(layout2.find_placement(sprite_key, placement));
+        CHECK(placement.sheet == 1);
+        CHECK(placement.xoff == 10);
+        CHECK(placement.yoff == 20);
+        CHECK(placement.xdim == 64);
+        CHECK(placement.ydim == 31);
+        CHECK(!layout2.find_placement(SpriteSheetLayout::SpriteKey{0, 2, 0x1234, 0}, placement));
+
+        // Only the new layout is saved.
+        layout2.save(file.string());
+        layout2.load(file.string());
+        CHECK(!layout2.find_placement(sprite_key, placement));
+    }
+
+    SECTION("Sheets which are not used again are found")
+    {
+        SpriteSheetLayout layout2;
+        layout2.load(file.string());
+        auto unused = layout2.unused_sheets();
+        REQUIRE(unused.size() == 1);
+        CHECK(unused.begin()->second.file_hash == 0xFEDCBA9876543210);
+
+        layout2.set_sheet(sheet_key, SpriteSheetLayout::Sheet{300, 400, 0, 0});
+        CHECK(layout2.unused_sheets().empty());
+    }
+
+    SECTION("Layouts from other versions are ignored")
+    {
+        {
+            std::ofstream os(file, std::ios::app);
+            os << "version 0\n";
+        }
+        SpriteSheetLayout layout2;
+        layout2.load(file.string());
+        SpriteSheetLayout::Sheet sheet{};
+        CHECK(!layout2.find_sheet(sheet_key, sheet));
+    }
+
+    SECTION("Invalid lines are errors")
+    {
+        {
+            std::ofstream os(file, std::ios::app);
+            os << "sprite 0 2 0x1234\n";
+        }
+        SpriteSheetLayout layout2;
+        CHECK_THROWS(layout2.load(file.string()));
+    }
+
+    fs::remove(file);
+}
@@ -42,10 +42,10 @@ TEST_CASE("Year template", "[integers]")
             CHECK(year2.get() == y);
 
             // Short years are offset from 1920 and must be positive values.
-            std::ostringstream os2;
+            ByteWriter os2;
             year.write(os2);
-            CHECK(os2.str().size() == 1);
-            CHECK(uint8_t(os2.str()[0]) == (y - 1920));
+            CHECK(os2.buffer().size() == 1);
+            CHECK(uint8_t(os2.buffer()[0]) == (y - 1920));
         }
     }
 
@@ -66,11 +66,11 @@ TEST_CASE("Year template", "[integers]")
             year2.parse(ts);
             CHECK(year2.get() == y);
 
-            std::ostringstream os2;
+            ByteWriter os2;
             year.write(os2);
-            CHECK(os2.str().size() == 2);
-            CHECK(uint8_t(os2.str()[0]) == (y & 0xFF));
-            CHECK(uint8_t(os2.str()[1]) == ((y >> 8) & 0xFF));
+            CHECK(os2.buffer().size() == 2);
+            CHECK(uint8_t(os2.buffer()[0]) == (y & 0xFF));
+            CHECK(uint8_t(os2.buffer()[1]) == ((y >> 8) & 0xFF));
         }
     }
 
@@ -91,13 +91,13 @@ TEST_CASE("Year template", "[integers]")
             year2.parse(ts);
             CHECK(year2.get() == y);
 
-            std::ostringstream os2;
+            ByteWriter os2;
             year.write(os2);
-            CHECK(os2.str().size() == 4);
-            CHECK(uint8_t(os2.str()[0]) == (y & 0xFF));
-            CHECK(uint8_t(os2.str()[1]) == ((y >> 8) & 0xFF));
-            CHECK(uint8_t(os2.str()[2]) == ((y >> 16) & 0xFF));
-            CHECK(uint8_t(os2.str()[3]) == ((y >> 24) & 0xFF));
+            CHECK(os2.buffer().size() == 4);
+            CHECK(uint8_t(os2.buffer()[0]) == (y & 0xFF));
+            CHECK(uint8_t(os2.buffer()[1]) == ((y >> 8) & 0xFF));
+            CHECK(uint8_t(os2.buffer()[2]) == ((y >> 16) & 0xFF));
+            CHECK(uint8_t(os2.buffer()[3]) == ((y >> 24) & 0xFF));
         }
     }
 }
@@ -0,0 +1,85 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#include "ByteReader.h"
+#include "Exceptions.h"
+
+
+void ByteReader::check(size_t length, const char* what) const
+{
+    // Written this way round to avoid overflow with silly lengths read from a corrupt file.
+    if (length > (m_size - m_pos))
+    {
+        throw RUNTIME_ERROR(what);
+    }
+}
+
+
+uint8_t ByteReader::read_uint8()
+{
+    check(1, "read_uint8 failed");
+    return m_data[m_pos++];
+}
+
+
+uint16_t ByteReader::read_uint16()
+{
+    check(2, "read_uint16 failed");
+    uint16_t result = m_data[m_pos] | (m_data[m_pos + 1] << 8);
+    m_pos += 2;
+    return result;
+}
+
+
+uint32_t ByteReader::read_uint32()
+{
+    check(4, "read_uint32 failed");
+    uint32_t result = uint32_t(m_data[m_pos])             | (uint32_t(m_data[m_pos + 1]) << 8) |
+                      (uint32_t(m_data[m_pos + 2]) << 16) | (uint32_t(m_data[m_pos + 3]) << 24);
+    m_pos += 4;
+    return result;
+}
+
+
+const uint8_t* ByteReader::read_bytes(size_t length)
+{
+    check(length, "read_bytes failed");
+    const uint8_t* result = m_data + m_pos;
+    m_pos += length;
+    return result;
+}
+
+
+void ByteReader::seek(size_t pos)
+{
+    if (pos > m_size)
+    {
+        throw RUNTIME_ERROR("seek failed");
+    }
+    m_pos = pos;
+}
+
+
+ByteReader ByteReader::slice(size_t pos, size_t length) const
+{
+    if ((pos > m_size) || (length > (m_size - pos)))
+    {
+        throw RUNTIME_ERROR("slice failed");
+    }
+    return ByteReader{m_data + pos, length};
+}
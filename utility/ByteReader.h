@@ -0,0 +1,68 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+
+
+// A bounds-checked cursor over a block of memory containing binary GRF data.
+// This does not own the memory, which is typically a memory mapped file, so the
+// underlying buffer must outlive the reader. Values are little-endian, as in the
+// GRF file, and reading past the end of the buffer throws in the same way as the
+// stream helpers.
+class ByteReader
+{
+public:
+    ByteReader(const uint8_t* data, size_t size)
+    : m_data{data}
+    , m_size{size}
+    {
+    }
+
+    uint8_t  read_uint8();
+    uint16_t read_uint16();
+    uint32_t read_uint32();
+
+    // Returns a pointer to the next length bytes, and moves past them.
+    const uint8_t* read_bytes(size_t length);
+
+    // The next byte without moving past it, or EOF at the end of the data.
+    int            peek() const { return at_end() ? EOF : m_data[m_pos]; }
+    void           skip(size_t length) { read_bytes(length); }
+
+    const uint8_t* data() const      { return m_data + m_pos; }
+    size_t         size() const      { return m_size; }
+    size_t         position() const  { return m_pos; }
+    size_t         remaining() const { return m_size - m_pos; }
+    bool           at_end() const    { return m_pos >= m_size; }
+    void           seek(size_t pos);
+
+    // A separate reader for length bytes starting at pos. The cursor is not moved.
+    ByteReader     slice(size_t pos, size_t length) const;
+
+private:
+    void check(size_t length, const char* what) const;
+
+private:
+    const uint8_t* m_data = nullptr;
+    size_t         m_size = 0;
+    size_t         m_pos  = 0;
+};
+
@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#include "ByteWriter.h"
+#include "Exceptions.h"
+
+
+void ByteWriter::write_uint16(uint16_t value)
+{
+    m_buffer.push_back(value & 0xFF);
+    m_buffer.push_back(value >> 8);
+}
+
+
+void ByteWriter::write_uint32(uint32_t value)
+{
+    m_buffer.push_back(value & 0xFF);
+    m_buffer.push_back((value >> 8) & 0xFF);
+    m_buffer.push_back((value >> 16) & 0xFF);
+    m_buffer.push_back(value >> 24);
+}
+
+
+void ByteWriter::write_bytes(const uint8_t* data, size_t length)
+{
+    m_buffer.insert(m_buffer.end(), data, data + length);
+}
+
+
+size_t ByteWriter::reserve_uint16()
+{
+    size_t pos = position();
+    write_uint16(0);
+    return pos;
+}
+
+
+size_t ByteWriter::reserve_uint32()
+{
+    size_t pos = position();
+    write_uint32(0);
+    return pos;
+}
+
+
+void ByteWriter::patch(size_t pos, uint32_t value, size_t length)
+{
+    // The reserved bytes must still be in the buffer.
+    if ((pos < m_flushed) || ((pos + length) > position()))
+    {
+        throw RUNTIME_ERROR("ByteWriter patch position is not in the buffer");
+    }
+
+    uint8_t* data = &m_buffer[pos - m_flushed];
+    for (size_t i = 0; i < length; ++i)
+    {
+        data[i] = value & 0xFF;
+        value >>= 8;
+    }
+}
+
+
+void ByteWriter::patch_uint16(size_t pos, uint16_t value)
+{
+    patch(pos, value, sizeof(value));
+}
+
+
+void ByteWriter::patch_uint32(size_t pos, uint32_t value)
+{
+    patch(pos, value, sizeof(value));
+}
+
+
+void ByteWriter::flush(bool force)
+{
+    if ((m_sink == nullptr) || m_buffer.empty())
+    {
+        return;
+    }
+
+    if (force || (m_buffer.size() >= BLOCK_SIZE))
+    {
+        m_sink->write(reinterpret_cast<const char*>(m_buffer.data()), m_buffer.size());
+        if (m_sink->fail())
+        {
+            throw RUNTIME_ERROR("ByteWriter failed to write to the output");
+        }
+
+        m_flushed += m_buffer.size();
+        m_buffer.clear();
+    }
+}
+
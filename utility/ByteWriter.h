@@ -0,0 +1,77 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+
+// A growable output buffer for binary GRF data. Values are written little-endian.
+// Space for a length field can be reserved and then back-patched once the data
+// it describes has been written, which avoids serialising records twice. If a sink
+// is given, the buffer is written to it in large blocks whenever flush() is called
+// and the buffer is full enough.
+class ByteWriter
+{
+public:
+    // Roughly how much data we accumulate before writing to the sink.
+    static constexpr size_t BLOCK_SIZE = 1 << 20;
+
+public:
+    explicit ByteWriter(std::ostream* sink = nullptr)
+    : m_sink{sink}
+    {
+    }
+
+    ByteWriter(const ByteWriter&) = delete;
+    ByteWriter& operator=(const ByteWriter&) = delete;
+
+    void write_uint8(uint8_t value)   { m_buffer.push_back(value); }
+    void write_uint16(uint16_t value);
+    void write_uint32(uint32_t value);
+    void write_bytes(const uint8_t* data, size_t length);
+
+    // Reserve space for a value to be filled in later. The returned position is
+    // passed to the matching patch method.
+    size_t reserve_uint16();
+    size_t reserve_uint32();
+    void   patch_uint16(size_t pos, uint16_t value);
+    void   patch_uint32(size_t pos, uint32_t value);
+
+    // Total number of bytes written so far, including those already flushed.
+    size_t position() const { return m_flushed + m_buffer.size(); }
+
+    // Contents which have not yet been flushed to the sink.
+    const std::vector<uint8_t>& buffer() const { return m_buffer; }
+
+    // Write the buffer to the sink if it has grown large enough, or always if force
+    // is set. Any reserved values must be patched before they are flushed. Nothing
+    // is flushed automatically, so call this with force set when done.
+    void flush(bool force = false);
+
+private:
+    void patch(size_t pos, uint32_t value, size_t length);
+
+private:
+    std::ostream*        m_sink    = nullptr;
+    std::vector<uint8_t> m_buffer;
+    size_t               m_flushed = 0;
+};
+
@@ -0,0 +1,472 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#include "ConversionCache.h"
+#include "FileSystem.h"
+#include "Fnv1aHash.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <mutex>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+
+
+namespace {
+
+constexpr const char* MANIFEST_PREFIX = "manifest-";
+constexpr const char* STATS_FILE    = "stats";
+constexpr const char* MISSING_FILE  = "missing";
+
+// The number of sets of inputs for which a conversion is kept.
+constexpr size_t MAX_MANIFESTS = 8;
+
+
+// Used to name the entry for a key, and the manifest for a set of inputs.
+uint64_t hash_string(const std::string& text)
+{
+    Fnv1aHash hash;
+    hash.add(text);
+    return hash.value();
+}
+
+
+std::string to_hex(uint64_t value)
+{
+    std::ostringstream os;
+    os << std::hex << std::setfill('0') << std::setw(16) << value;
+    return os.str();
+}
+
+// A name for a temporary file next to the given one which no other job will use.
+fs::path temp_path(const fs::path& path)
+{
+    static std::random_device device;
+    static std::mutex         mutex;
+
+    std::lock_guard<std::mutex> lock{mutex};
+    fs::path temp = path;
+    temp += ".tmp" + to_hex((uint64_t(device()) << 32) | device());
+    return temp;
+}
+
+
+// The blobs referred to by a manifest.
+std::set<std::string> manifest_blobs(const fs::path& manifest)
+{
+    std::set<std::string> blobs;
+    std::ifstream is(manifest);
+    std::string   type;
+    std::string   value;
+    std::string   path;
+    while (is >> type >> value && std::getline(is, path))
+    {
+        if (type == "output")
+        {
+            blobs.insert(value);
+        }
+    }
+    return blobs;
+}
+
+
+// The manifests in an entry, most recently used first.
+std::vector<fs::path> entry_manifests(const fs::path& dir)
+{
+    std::vector<std::pair<fs::file_time_type, fs::path>> found;
+    std::error_code ec;
+    for (const auto& entry: fs::directory_iterator(dir, ec))
+    {
+        const std::string name = entry.path().filename().string();
+        if ((name.rfind(MANIFEST_PREFIX, 0) == 0) && (name.find(".tmp") == std::string::npos))
+        {
+            found.push_back({fs::last_write_time(entry.path(), ec), entry.path()});
+        }
+    }
+
+    std::sort(found.begin(), found.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    std::vector<fs::path> manifests;
+    for (const auto& item: found)
+    {
+        manifests.push_back(item.second);
+    }
+    return manifests;
+}
+
+
+} // namespace {
+
+
+// 64-bit FNV-1a of the contents of a file.
+bool ConversionCache::hash_file(const std::string& file_name, uint64_t& hash)
+{
+    std::ifstream is(file_name, std::ios::binary);
+    if (!is)
+    {
+        return false;
+    }
+
+    Fnv1aHash file_hash;
+    std::vector<char> block(1 << 16);
+    while (is)
+    {
+        is.read(block.data(), block.size());
+        file_hash.add(reinterpret_cast<const uint8_t*>(block.data()), size_t(is.gcount()));
+    }
+
+    hash = file_hash.value();
+    return is.eof();
+}
+
+
+ConversionCache& ConversionCache::cache()
+{
+    static ConversionCache instance;
+    return instance;
+}
+
+
+void ConversionCache::set_directory(const std::string& directory, const std::string& base_dir)
+{
+    m_directory = directory;
+    m_base_dir  = fs::absolute(base_dir.empty() ? "." : base_dir).lexically_normal().string();
+    if (!m_directory.empty())
+    {
+        fs::create_directories(m_directory);
+        read_stats();
+    }
+}
+
+
+void ConversionCache::add_input(const std::string& file_name)
+{
+    if (!enabled())
+    {
+        return;
+    }
+
+    // Pipes and other special files would block or be consumed by hashing them.
+    if (fs::exists(file_name) && !fs::is_regular_file(file_name))
+    {
+        m_uncacheable = true;
+        return;
+    }
+
+    // The input is hashed when it is read, so that a file which is edited during a long 
+    // conversion does not have the old outputs stored against its new contents. 
+    uint64_t    hash   = 0;
+    bool        exists = hash_file(file_name, hash);
+    std::string value  = exists ? to_hex(hash) : MISSING_FILE;
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_inputs.insert({relative_path(file_name), value});
+}
+
+
+void ConversionCache::add_output(const std::string& file_name)
+{
+    if (!enabled())
+    {
+        return;
+    }
+
+    // A pipe cannot be read back to store it.
+    if (!fs::is_regular_file(file_name))
+    {
+        m_uncacheable = true;
+        return;
+    }
+
+    // Some files, such as the chunk gaps, are both read and written. The next conversion 
+    // will read what was written, so that is what the input is compared with.
+    std::lock_guard<std::mutex> lock{m_mutex};
+    const std::string path = relative_path(file_name);
+    m_outputs.insert(path);
+
+    auto it = m_inputs.find(path);
+    if (it != m_inputs.end())
+    {
+        uint64_t hash = 0;
+        it->second = hash_file(file_name, hash) ? to_hex(hash) : MISSING_FILE;
+    }
+}
+
+
+std::string ConversionCache::relative_path(const std::string& file_name) const
+{
+    return fs::absolute(file_name).lexically_normal().lexically_relative(m_base_dir).generic_string();
+}
+
+
+std::string ConversionCache::entry_dir(const std::string& key) const
+{
+    std::ostringstream os;
+    os << key << '\n' << CACHE_VERSION;
+    return fs::path(m_directory).append(to_hex(hash_string(os.str()))).string();
+}
+
+
+bool ConversionCache::lookup(const std::string& key)
+{
+    if (!enabled())
+    {
+        return false;
+    }
+
+    // Each entry holds a manifest for each set of inputs the conversion has been run with, 
+    // so that switching between branches, say, does not evict the outputs for either. An 
+    // input can appear in several manifests, so its hash is worked out once. 
+    const fs::path dir = entry_dir(key);
+    std::map<std::string, std::string> hashes;
+
+    bool found = false;
+    for (const auto& manifest_path: entry_manifests(dir))
+    {
+        found = read_manifest(dir.string(), manifest_path.string(), hashes);
+        if (found)
+        {
+            // Mark the manifest as recently used, so that it is not the next evicted.
+            std::error_code ec;
+            fs::last_write_time(manifest_path, fs::file_time_type::clock::now(), ec);
+            break;
+        }
+    }
+
+    add_stats(found);
+    return found;
+}
+
+
+bool ConversionCache::read_manifest(const std::string& dir, const std::string& manifest_path, 
+    std::map<std::string, std::string>& hashes)
+{
+    // The manifest is a list of lines: "input <hash> <path>" and "output <blob> <path>".
+    // Paths are last on the line because they may contain spaces.
+    std::ifstream manifest(manifest_path);
+
+    m_found.clear();
+    bool found = bool(manifest);
+
+    std::string line;
+    while (found && std::getline(manifest, line))
+    {
+        std::istringstream is(line);
+        std::string type;
+        std::string value;
+        is >> type >> value;
+        is.get();
+        std::string path;
+        std::getline(is, path);
+
+        if (type == "input")
+        {
+            // Some inputs are optional, and it matters if one has appeared since.
+            auto it = hashes.find(path);
+            if (it == hashes.end())
+            {
+                uint64_t hash   = 0;
+                bool     exists = hash_file(fs::path(m_base_dir).append(path).string(), hash);
+                it = hashes.insert({path, exists ? to_hex(hash) : MISSING_FILE}).first;
+            }
+            found = (it->second == value);
+        }
+        else if (type == "output")
+        {
+            found = fs::is_regular_file(fs::path(dir).append(value));
+            m_found.push_back({fs::path(dir).append(value).string(), path});
+        }
+        else
+        {
+            found = false;
+        }
+    }
+
+    return found;
+}
+
+
+void ConversionCache::restore() const
+{
+    for (const auto& output: m_found)
+    {
+        fs::path path = fs::path(m_base_dir).append(output.second);
+        std::cout << "Restoring from cache: " << path.make_preferred().string() << "..." << std::endl;
+        fs::create_directories(path.parent_path());
+        fs::copy_file(output.first, path, fs::copy_options::overwrite_existing);
+    }
+}
+
+
+void ConversionCache::save(const std::string& key)
+{
+    if (!enabled() || m_uncacheable)
+    {
+        return;
+    }
+
+    // Another job may be restoring from this entry while it is saved, so nothing is changed 
+    // in place. Each output is stored in a blob named by its hash, and the manifest is 
+    // written last. The files are written to temporary names and then renamed, as in the 
+    // sprite cache, so that a reader never sees a partial file. The manifest is named by 
+    // the hash of the inputs, and replaces any earlier one for the same inputs.
+    const fs::path dir = entry_dir(key);
+    fs::create_directories(dir);
+
+    std::ostringstream inputs;
+    for (const auto& [input, hash]: m_inputs)
+    {
+        inputs << "input " << hash << ' ' << input << '\n';
+    }
+
+    std::ostringstream manifest;
+    manifest << inputs.str();
+    std::set<std::string> blobs;
+    for (const auto& output: m_outputs)
+    {
+        const fs::path path = fs::path(m_base_dir).append(output);
+        uint64_t       hash = 0;
+        if (!hash_file(path.string(), hash))
+        {
+            // The conversion is just not cached.
+            return;
+        }
+
+        const std::string name = to_hex(hash);
+        const fs::path    blob = fs::path(dir).append(name);
+        if (!fs::is_regular_file(blob))
+        {
+            const fs::path temp = temp_path(blob);
+            fs::copy_file(path, temp);
+            fs::rename(temp, blob);
+        }
+
+        blobs.insert(name);
+        manifest << "output " << name << ' ' << output << '\n';
+    }
+
+    const fs::path manifest_path = fs::path(dir).append(MANIFEST_PREFIX + to_hex(hash_string(inputs.str())));
+
+    // Blobs used by no remaining manifest are removed, but not those of the manifests which 
+    // this one replaces or evicts. A job which has just looked one of them up can still 
+    // restore its outputs. The blobs are removed by a later save.
+    for (const auto& name: manifest_blobs(manifest_path))
+    {
+        blobs.insert(name);
+    }
+
+    const fs::path temp = temp_path(manifest_path);
+    {
+        std::ofstream os(temp);
+        os << manifest.str();
+    }
+    fs::rename(temp, manifest_path);
+
+    std::vector<fs::path> manifests = entry_manifests(dir);
+    for (size_t index = 0; index < manifests.size(); ++index)
+    {
+        for (const auto& name: manifest_blobs(manifests[index]))
+        {
+            blobs.insert(name);
+        }
+        if ((index >= MAX_MANIFESTS) && (manifests[index] != manifest_path))
+        {
+            std::error_code ec;
+            fs::remove(manifests[index], ec);
+        }
+    }
+
+    for (const auto& entry: fs::directory_iterator(dir))
+    {
+        const std::string name = entry.path().filename().string();
+        if ((name.rfind(MANIFEST_PREFIX, 0) != 0) && (name.find(".tmp") == std::string::npos) && (blobs.count(name) == 0))
+        {
+            std::error_code ec;
+            fs::remove(entry.path(), ec);
+        }
+    }
+}
+
+
+void ConversionCache::read_stats()
+{
+    // The stats file is a list of lines: "hits <count>" and "misses <count>". The totals are
+    // the sums of the counts, so older files with a line for each lookup can still be read.
+    m_hits   = 0;
+    m_misses = 0;
+
+    std::ifstream is(fs::path(m_directory).append(STATS_FILE));
+    std::string name;
+    uint64_t    value = 0;
+    while (is >> name >> value)
+    {
+        if (name == "hits")   m_hits   += value;
+        if (name == "misses") m_misses += value;
+    }
+}
+
+
+void ConversionCache::add_stats(bool hit)
+{
+    // The cache directory may be shared by several jobs at once, so the totals are updated 
+    // while holding a lock. Creating a directory is atomic, so that is the lock. A lock left 
+    // by a job which died is broken after a while. The new totals are written to a temporary 
+    // file and renamed, so that a reader never sees a partial file. If the lock cannot be had, 
+    // the lookup is just not counted.
+    const fs::path stats = fs::path(m_directory).append(STATS_FILE);
+    fs::path       lock  = stats;
+    lock += ".lock";
+
+    using namespace std::chrono_literals;
+    const auto timeout = std::chrono::steady_clock::now() + 10s;
+    std::error_code ec;
+    while (!fs::create_directory(lock, ec))
+    {
+        const auto age = fs::file_time_type::clock::now() - fs::last_write_time(lock, ec);
+        if (!ec && (age > 30s))
+        {
+            fs::remove(lock, ec);
+        }
+        else if (std::chrono::steady_clock::now() > timeout)
+        {
+            read_stats();
+            return;
+        }
+        else
+        {
+            std::this_thread::sleep_for(10ms);
+        }
+    }
+
+    read_stats();
+    (hit ? m_hits : m_misses) += 1;
+
+    const fs::path temp = temp_path(stats);
+    {
+        std::ofstream os(temp);
+        os << "hits " << m_hits << "\nmisses " << m_misses << '\n';
+    }
+    fs::rename(temp, stats, ec);
+    fs::remove(lock, ec);
+}
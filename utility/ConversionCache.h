@@ -0,0 +1,93 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+
+// A cache of whole conversions, in the style of ccache. While a GRF is decoded or encoded, 
+// the files it reads and writes are recorded. Afterwards, the outputs are stored along with 
+// a manifest of hashes of the inputs. The next time the same conversion is run with the same 
+// options, the outputs are copied from the cache if none of the inputs has changed. The 
+// outputs for the last few sets of inputs are kept for each conversion.
+//
+// Paths in the manifest are relative to a base directory, normally that of the GRF, so that 
+// the cache still works if the files are moved, as they are by a fresh checkout on a build 
+// server. Hit and miss counts are kept in the cache directory as a record of how useful it is.
+// Several jobs may share the cache directory at once.
+class ConversionCache
+{
+public:
+    // Bump this whenever the layout of the cache changes.
+    static constexpr uint32_t CACHE_VERSION = 2;
+
+public:
+    static ConversionCache& cache();
+
+    // The cache is disabled until it has a directory.
+    void set_directory(const std::string& directory, const std::string& base_dir);
+    bool enabled() const { return !m_directory.empty(); }
+
+    // These are called by the code which reads and writes the files, possibly from 
+    // several threads. They do nothing if the cache is disabled. An input is hashed 
+    // when it is added, and one which does not exist is recorded as missing. A conversion 
+    // which reads or writes a pipe or other special file is not saved.
+    void add_input(const std::string& file_name);
+    void add_output(const std::string& file_name);
+
+    // The key describes the conversion: the operation, the main input file and the options 
+    // which affect the outputs. Returns true if the cache holds the outputs for the current 
+    // inputs, which can then be copied into place with restore().
+    bool lookup(const std::string& key);
+    void restore() const;
+    void save(const std::string& key);
+
+    // Running totals for the cache directory.
+    uint64_t hits() const   { return m_hits; }
+    uint64_t misses() const { return m_misses; }
+
+    // Hash of the contents of a file. Returns false if the file cannot be read.
+    static bool hash_file(const std::string& file_name, uint64_t& hash);
+
+private:
+    std::string entry_dir(const std::string& key) const;
+    std::string relative_path(const std::string& file_name) const;
+    bool        read_manifest(const std::string& dir, const std::string& manifest_path, 
+                    std::map<std::string, std::string>& hashes);
+    void        read_stats();
+    void        add_stats(bool hit);
+
+private:
+    std::string           m_directory;
+    std::string           m_base_dir;
+    std::map<std::string, std::string> m_inputs;   // Path and hash when it was read.
+    std::set<std::string> m_outputs;
+
+    // The blobs and paths of the outputs found by lookup().
+    std::vector<std::pair<std::string, std::string>> m_found;
+    std::atomic<bool>     m_uncacheable{false};
+    uint64_t              m_hits   = 0;
+    uint64_t              m_misses = 0;
+    mutable std::mutex    m_mutex;
+};
@@ -0,0 +1,69 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+// 64-bit FNV-1a. This is used to key the caches on the contents of sprites, records and 
+// files. It is not especially fast, but is quick compared to the work it saves. Values are 
+// normally added a byte at a time. add_word() mixes in a whole 64-bit value in one step, 
+// which is cheaper for values which are already hashes.
+class Fnv1aHash
+{
+public:
+    static constexpr uint64_t OFFSET_BASIS = 0xCBF29CE484222325ULL;
+    static constexpr uint64_t PRIME        = 0x100000001B3ULL;
+
+public:
+    // A hash can be continued from an earlier value.
+    explicit Fnv1aHash(uint64_t hash = OFFSET_BASIS)
+    : m_hash{hash}
+    {
+    }
+
+    void add(uint8_t value)
+    {
+        m_hash = (m_hash ^ value) * PRIME;
+    }
+
+    void add(const uint8_t* data, size_t size)
+    {
+        for (size_t i = 0; i < size; ++i)
+        {
+            add(data[i]);
+        }
+    }
+
+    void add(const std::string& text)
+    {
+        add(reinterpret_cast<const uint8_t*>(text.data()), text.size());
+    }
+
+    void add_word(uint64_t value)
+    {
+        m_hash = (m_hash ^ value) * PRIME;
+    }
+
+    uint64_t value() const { return m_hash; }
+
+private:
+    uint64_t m_hash;
+};
@@ -23,6 +23,7 @@
 #include <sstream>
 #include <locale>
 #include <codecvt>
+#include <cstring>
 
 
 struct ControlCode
@@ -431,28 +432,33 @@ static void process_utf16_control_codes(uint16_t u16, std::basic_ostringstream<c
 }
 
 
-std::string read_string(std::istream& is)
+std::string read_string(ByteReader& is)
 {
-    std::string result;
-    std::getline(is, result, char(0));
-
-    if (is.fail())
+    // As with std::getline(), a missing terminator at the end of the data is
+    // tolerated, but there must be something to read.
+    if (is.at_end())
     {
         throw RUNTIME_ERROR("read_string failed");
     }
 
+    const char* data = reinterpret_cast<const char*>(is.data());
+    const char* term = static_cast<const char*>(std::memchr(data, 0, is.remaining()));
+    size_t length    = term ? size_t(term - data) : is.remaining();
+
+    std::string result{data, length};
+    is.skip(term ? length + 1 : length);
     return result;
 }
 
 
-void write_string(std::ostream& os, const std::string& value, StringTerm term)
+void write_string(ByteWriter& os, const std::string& value, StringTerm term)
 {
     // Optionally write without a 0 terminator - one or two strings in the GRF are terminated by end of record or whatever.
-    os.write(value.c_str(), value.length() + ((term == StringTerm::None) ? 0 : 1));
+    os.write_bytes(reinterpret_cast<const uint8_t*>(value.c_str()), value.length() + ((term == StringTerm::None) ? 0 : 1));
 }
 
 
-void write_string(std::ostream& os, const std::string& value)
+void write_string(ByteWriter& os, const std::string& value)
 {
     write_string(os, value, StringTerm::Null);
 }
@@ -815,15 +821,12 @@ static std::string readable_utf8_to_grf_string(const std::string& str)
 }
 
 
-void GRFString::read(std::istream& is, StringTerm term)
+void GRFString::read(ByteReader& is, StringTerm term)
 {
     if (term == StringTerm::None)
     {
-        m_value = {};
-        while (is.peek() != EOF)
-        {
-            m_value.push_back(read_uint8(is));
-        }        
+        size_t length = is.remaining();
+        m_value.assign(reinterpret_cast<const char*>(is.read_bytes(length)), length);
     }
     else
     {
@@ -832,7 +835,7 @@ void GRFString::read(std::istream& is, StringTerm term)
 }
 
 
-void GRFString::write(std::ostream& os, StringTerm term) const
+void GRFString::write(ByteWriter& os, StringTerm term) const
 {
     write_string(os, m_value, term);
 }
@@ -35,8 +35,8 @@ class GRFString
 public:
     // Binary serialisation
     // Directly read or write m_value. 
-    void read(std::istream& is, StringTerm term = StringTerm::Null);
-    void write(std::ostream& os, StringTerm term = StringTerm::Null) const;
+    void read(ByteReader& is, StringTerm term = StringTerm::Null);
+    void write(ByteWriter& os, StringTerm term = StringTerm::Null) const;
 
     // Text serialisation
     // Convert the internal representation to a human readable version.
@@ -56,9 +56,9 @@ private:
 };
 
 
-std::string read_string(std::istream& is);
-void write_string(std::ostream& os, const std::string& value, StringTerm term);
-void write_string(std::ostream& os, const std::string& value);
+std::string read_string(ByteReader& is);
+void write_string(ByteWriter& os, const std::string& value, StringTerm term);
+void write_string(ByteWriter& os, const std::string& value);
 std::string grf_string_to_readable_utf8(const std::string& value);
 
 
@@ -0,0 +1,153 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#include "MappedFile.h"
+#include "Exceptions.h"
+#include "FileSystem.h"
+#include <sstream>
+
+#ifdef _WIN32
+    #define NOMINMAX
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+
+static RuntimeError mapping_error(const char* what, const std::string& file_name, const char* file, uint32_t line)
+{
+    std::ostringstream ss;
+    ss << what << ": " << file_name;
+    return RuntimeError(ss.str(), file, line);
+}
+#define MAPPING_ERROR(what, file_name) mapping_error(what, file_name, __FILE__, __LINE__)
+
+
+bool MappedFile::can_map(const std::string& file_name)
+{
+    std::error_code ec;
+    return fs::is_regular_file(file_name, ec);
+}
+
+
+#ifdef _WIN32
+
+
+MappedFile::MappedFile(const std::string& file_name)
+{
+    HANDLE file = CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        throw MAPPING_ERROR("Error opening file for reading", file_name);
+    }
+    m_file = file;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size))
+    {
+        CloseHandle(file);
+        throw MAPPING_ERROR("Error reading file size", file_name);
+    }
+    m_size = static_cast<size_t>(size.QuadPart);
+
+    // Zero length files cannot be mapped, but there is nothing to read anyway.
+    if (m_size == 0)
+    {
+        return;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+    {
+        CloseHandle(file);
+        throw MAPPING_ERROR("Error mapping file", file_name);
+    }
+    m_mapping = mapping;
+
+    m_data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (m_data == nullptr)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        throw MAPPING_ERROR("Error mapping file", file_name);
+    }
+}
+
+
+MappedFile::~MappedFile()
+{
+    if (m_data)    UnmapViewOfFile(m_data);
+    if (m_mapping) CloseHandle(static_cast<HANDLE>(m_mapping));
+    if (m_file)    CloseHandle(static_cast<HANDLE>(m_file));
+}
+
+
+#else
+
+
+MappedFile::MappedFile(const std::string& file_name)
+{
+    int fd = open(file_name.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw MAPPING_ERROR("Error opening file for reading", file_name);
+    }
+
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || !S_ISREG(st.st_mode))
+    {
+        close(fd);
+        throw MAPPING_ERROR("Error mapping file (not a regular file)", file_name);
+    }
+    m_size = static_cast<size_t>(st.st_size);
+
+    // Zero length files cannot be mapped, but there is nothing to read anyway.
+    if (m_size > 0)
+    {
+        void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            close(fd);
+            throw MAPPING_ERROR("Error mapping file", file_name);
+        }
+
+        // We read the file from front to back, more or less.
+        madvise(data, m_size, MADV_SEQUENTIAL);
+        m_data = static_cast<const uint8_t*>(data);
+    }
+
+    // The mapping keeps its own reference to the file.
+    close(fd);
+}
+
+
+MappedFile::~MappedFile()
+{
+    if (m_data)
+    {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+    }
+}
+
+
+#endif
@@ -0,0 +1,52 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+
+// Read-only memory mapping of an entire file. GRF files can be quite large, and
+// walking the mapped bytes with a ByteReader is much cheaper than pulling every
+// value through a std::istream. Only regular files can be mapped: other files
+// (pipes and the like) should be read through a stream instead.
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string& file_name);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const { return m_data; }
+    size_t         size() const { return m_size; }
+
+    // True if the file is something we are able to map.
+    static bool can_map(const std::string& file_name);
+
+private:
+    const uint8_t* m_data = nullptr;
+    size_t         m_size = 0;
+
+#ifdef _WIN32
+    void*          m_file    = nullptr;
+    void*          m_mapping = nullptr;
+#endif
+};
@@ -0,0 +1,216 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#include "MatchLength.h"
+#include "Exceptions.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define YAGL_MATCH_SIMD 1
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+        // MSVC allows AVX2 intrinsics in any function without special compiler options.
+        #define YAGL_TARGET_AVX2
+    #else
+        #define YAGL_TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+#endif
+
+
+namespace {
+
+
+size_t match_length_scalar(const uint8_t* a, const uint8_t* b, size_t length, size_t limit)
+{
+    while ((length < limit) && (a[length] == b[length]))
+    {
+        ++length;
+    }
+    return length;
+}
+
+
+#ifdef YAGL_MATCH_SIMD
+
+
+uint32_t count_trailing_zeros(uint32_t mask)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+
+size_t match_length_sse2(const uint8_t* a, const uint8_t* b, size_t limit, size_t available)
+{
+    size_t length = 0;
+    while ((length < limit) && ((length + 16) <= available))
+    {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + length));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + length));
+        // One bit for each byte which differs.
+        uint32_t mask = ~uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb))) & 0xFFFF;
+        if (mask != 0)
+        {
+            length += count_trailing_zeros(mask);
+            return (length < limit) ? length : limit;
+        }
+        length += 16;
+    }
+
+    if (length >= limit)
+    {
+        return limit;
+    }
+    return match_length_scalar(a, b, length, limit);
+}
+
+
+YAGL_TARGET_AVX2
+size_t match_length_avx2(const uint8_t* a, const uint8_t* b, size_t limit, size_t available)
+{
+    size_t length = 0;
+    while ((length < limit) && ((length + 32) <= available))
+    {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + length));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + length));
+        uint32_t mask = ~uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb)));
+        if (mask != 0)
+        {
+            length += count_trailing_zeros(mask);
+            return (length < limit) ? length : limit;
+        }
+        length += 32;
+    }
+
+    if (length >= limit)
+    {
+        return limit;
+    }
+    // There may still be room for a whole SSE2 vector near the end of the data.
+    return length + match_length_sse2(a + length, b + length, limit - length, available - length);
+}
+
+
+bool cpu_has_avx2()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+    {
+        return false;
+    }
+
+    // The OS must also save the YMM registers on a context switch.
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!osxsave || ((_xgetbv(0) & 0x6) != 0x6))
+    {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+
+#endif // YAGL_MATCH_SIMD
+
+
+size_t match_length_fallback(const uint8_t* a, const uint8_t* b, size_t limit, size_t /*available*/)
+{
+    return match_length_scalar(a, b, 0, limit);
+}
+
+
+MatchKernel detect_match_kernel()
+{
+#ifdef YAGL_MATCH_SIMD
+    return cpu_has_avx2() ? MatchKernel::AVX2 : MatchKernel::SSE2;
+#else
+    return MatchKernel::Scalar;
+#endif
+}
+
+
+using MatchFunction = size_t (*)(const uint8_t* a, const uint8_t* b, size_t limit, size_t available);
+
+
+MatchFunction match_function(MatchKernel kernel)
+{
+    switch (kernel)
+    {
+#ifdef YAGL_MATCH_SIMD
+        case MatchKernel::AVX2: return match_length_avx2;
+        case MatchKernel::SSE2: return match_length_sse2;
+#endif
+        default:                return match_length_fallback;
+    }
+}
+
+
+// Chosen once so that the hot path is a single indirect call.
+const MatchFunction g_best_function = match_function(best_match_kernel());
+
+
+} // namespace {
+
+
+MatchKernel best_match_kernel()
+{
+    static const MatchKernel kernel = detect_match_kernel();
+    return kernel;
+}
+
+
+bool match_kernel_supported(MatchKernel kernel)
+{
+    switch (kernel)
+    {
+        case MatchKernel::Scalar: return true;
+        case MatchKernel::SSE2:   return best_match_kernel() != MatchKernel::Scalar;
+        case MatchKernel::AVX2:   return best_match_kernel() == MatchKernel::AVX2;
+    }
+    return false;
+}
+
+
+size_t match_length(const uint8_t* a, const uint8_t* b, size_t limit, size_t available)
+{
+    return g_best_function(a, b, limit, available);
+}
+
+
+size_t match_length(MatchKernel kernel, const uint8_t* a, const uint8_t* b, size_t limit, size_t available)
+{
+    if (!match_kernel_supported(kernel))
+    {
+        throw RUNTIME_ERROR("match_length: kernel is not supported on this CPU");
+    }
+
+    return match_function(kernel)(a, b, limit, available);
+}
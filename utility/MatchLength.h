@@ -0,0 +1,38 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+
+// The implementations of match_length() which may be available. The SIMD versions are
+// only compiled for x86-64, where SSE2 is always present. AVX2 is used only if the CPU
+// running the program supports it.
+enum class MatchKernel { Scalar, SSE2, AVX2 };
+
+// The fastest kernel supported by this build and CPU. This is detected once.
+MatchKernel best_match_kernel();
+bool        match_kernel_supported(MatchKernel kernel);
+
+// Returns the number of leading bytes which are the same in a and b, up to limit. The 
+// SIMD kernels compare whole vectors, so available (which must be at least limit) says 
+// how many bytes may safely be read from both pointers. Any bytes beyond that are 
+// compared one at a time.
+size_t match_length(const uint8_t* a, const uint8_t* b, size_t limit, size_t available);
+size_t match_length(MatchKernel kernel, const uint8_t* a, const uint8_t* b, size_t limit, size_t available);
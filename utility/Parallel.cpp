@@ -0,0 +1,90 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#include "Parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+void parallel_for(size_t count, uint32_t num_threads, const std::function<void(size_t)>& func)
+{
+    num_threads = uint32_t(std::min<size_t>(num_threads, count));
+    if (num_threads <= 1)
+    {
+        for (size_t index = 0; index < count; ++index)
+        {
+            func(index);
+        }
+        return;
+    }
+
+    // Indices are handed out one at a time, which balances the load when the
+    // items vary a lot in size, as sprites do.
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> first_error{count};
+    std::exception_ptr  error;
+    std::mutex          error_mutex;
+
+    auto worker = [&]()
+    {
+        while (true)
+        {
+            size_t index = next++;
+            // There is no point doing work beyond an item which has already failed.
+            if ((index >= count) || (index > first_error))
+            {
+                break;
+            }
+
+            try
+            {
+                func(index);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock{error_mutex};
+                if (index < first_error)
+                {
+                    first_error = index;
+                    error       = std::current_exception();
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (uint32_t i = 1; i < num_threads; ++i)
+    {
+        threads.emplace_back(worker);
+    }
+    // The calling thread does its share too.
+    worker();
+    for (auto& thread: threads)
+    {
+        thread.join();
+    }
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
@@ -0,0 +1,30 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright 2019 Alan Chambers (unicycle.bloke@gmail.com)
+//
+// This file is part of yagl.
+//
+// yagl is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// yagl is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with yagl. If not, see <https://www.gnu.org/licenses/>.
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+
+// Calls func(index) for every index in [0, count), sharing the work among up to 
+// num_threads worker threads. The order in which the calls are made is unspecified, 
+// so func must only touch state belonging to its own index. If any call throws, the 
+// exception from the lowest failing index is rethrown on the calling thread once all 
+// the workers have finished. That is the same exception a simple loop would throw.
+void parallel_for(size_t count, uint32_t num_threads, const std::function<void(size_t)>& func);
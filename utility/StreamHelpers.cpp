@@ -62,6 +62,27 @@ void write_uint8_ext(std::ostream& os, uint16_t value, ExtByteFormat format)
 }
 
 
+uint16_t read_uint8_ext(ByteReader& is)
+{
+    uint8_t result = read_uint8(is);
+    return result == 0xFF ? read_uint16(is) : result;
+}
+
+
+void write_uint8_ext(ByteWriter& os, uint16_t value, ExtByteFormat format)
+{
+    if ((value >= 0xFF) || (format == ExtByteFormat::Long))
+    {
+        write_uint8(os, 0xFF);
+        write_uint16(os, value);
+    }
+    else
+    {
+        write_uint8(os, uint8_t(value));
+    }
+}
+
+
 uint16_t read_uint16(std::istream& is)
 {
     uint16_t result;
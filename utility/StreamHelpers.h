@@ -18,6 +18,8 @@
 ///////////////////////////////////////////////////////////////////////////////
 #pragma once 
 #include "Exceptions.h"
+#include "ByteReader.h"
+#include "ByteWriter.h"
 #include <cstdint>
 #include <iostream>
 #include <iomanip>
@@ -40,13 +42,27 @@ void write_uint16(std::ostream& os, uint16_t value);
 void write_uint32(std::ostream& os, uint32_t value);
 
 
+// Overloads for the binary GRF data. These are the ones used by the records, and
+// are inline so that reading or writing an integer does not involve a virtual call.
+inline uint8_t  read_uint8(ByteReader& is)  { return is.read_uint8(); }
+inline uint16_t read_uint16(ByteReader& is) { return is.read_uint16(); }
+inline uint32_t read_uint32(ByteReader& is) { return is.read_uint32(); }
+uint16_t        read_uint8_ext(ByteReader& is);
+
+
+inline void write_uint8(ByteWriter& os, uint8_t value)   { os.write_uint8(value); }
+inline void write_uint16(ByteWriter& os, uint16_t value) { os.write_uint16(value); }
+inline void write_uint32(ByteWriter& os, uint32_t value) { os.write_uint32(value); }
+void        write_uint8_ext(ByteWriter& os, uint16_t value, ExtByteFormat format = ExtByteFormat::Long);
+
+
 template <typename T>
 constexpr bool is_uint_v = std::is_same_v<T, uint8_t> || std::is_same_v<T, uint16_t> || std::is_same_v<T, uint32_t>;
 
 
-// Useful alias for inside templates.
-template <typename T, bool EXT = false>
-T read_uint(std::istream& is)
+// Useful alias for inside templates. Works with either std::istream or ByteReader.
+template <typename T, bool EXT = false, typename Reader>
+T read_uint(Reader& is)
 {
     static_assert(is_uint_v<T>);
     static_assert(EXT == false || std::is_same_v<T, uint16_t>);
@@ -69,9 +85,9 @@ T read_uint(std::istream& is)
 }
 
 
-// Useful alias for inside templates.
-template <typename T, bool EXT = false>
-void write_uint(std::ostream& os, T value)
+// Useful alias for inside templates. Works with either std::ostream or ByteWriter.
+template <typename T, bool EXT = false, typename Writer>
+void write_uint(Writer& os, T value)
 {
     static_assert(is_uint_v<T>);
     static_assert(EXT == false || std::is_same_v<T, uint16_t>);
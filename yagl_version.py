@@ -22,7 +22,9 @@
 
 import os
 
-stream = os.popen('git describe --long')
+# Fall back on the commit hash if there are no tags, so that the version is never empty.
+# Other code relies on it to tell builds apart.
+stream = os.popen('git describe --long --always --dirty')
 version = stream.read().strip()
 print("Repo version: ", version)
 
@@ -31,14 +33,16 @@ print("Repo version: ", version)
 # the one definition rule, but it seems to be OK so far. Maybe using constexpr makes
 # this a non-issue? Easy to fix if it becomes a problem.
 
+expected = "constexpr const char* str_yagl_version = \"%s\";" % (version)
+
 matches = False;
 try:
     infile = open("../yagl_version.h", "r")
     while True:
-        line = infile.readline().strip()
+        line = infile.readline()
         if len(line) == 0:
             break
-        if line.find(version) != -1:
+        if line.strip() == expected:
             matches = True
             break
 except:
@@ -50,5 +54,5 @@ if matches == False:
     outfile = open("../yagl_version.h", "w")
     outfile.write("// This file is generated in a pre-build step by yagl_version.py\n")
     outfile.write("#pragma once\n")
-    outfile.write("constexpr const char* str_yagl_version = \"%s\";" % (version))
+    outfile.write(expected)
 